@@ -0,0 +1,82 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <benchmark/benchmark.h>
+#include <open62541cpp/open62541client.h>
+#include "bench_server.h"
+
+namespace opc = Open62541;
+
+// Client services against the in-process server, over the loopback interface
+
+static bool connectClient(benchmark::State& state, opc::Client& client)
+{
+    BenchServer::instance();
+    if (!client.connect(BenchServer::endpoint())) {
+        state.SkipWithError("cannot connect to the loopback server");
+        return false;
+    }
+    return true;
+}
+
+//*****************************************************************************
+
+static void BM_Client_readValue(benchmark::State& state)
+{
+    opc::Client client;
+    if (!connectClient(state, client)) return;
+
+    auto& b = BenchServer::instance();
+    opc::Variant v;
+    size_t i = 0;
+    for (auto _ : state) {
+        client.readValue(b.variables[i++ % b.variables.size()], v);
+    }
+    state.SetItemsProcessed(state.iterations());
+    client.disconnect();
+}
+BENCHMARK(BM_Client_readValue)->UseRealTime();
+
+static void BM_Client_readMany(benchmark::State& state)
+{
+    opc::Client client;
+    if (!connectClient(state, client)) return;
+
+    auto& b = BenchServer::instance();
+    opc::ReadValueIdList nodes;
+    for (auto& node : b.variables)
+        nodes.put(node);
+
+    opc::DataValueList values;
+    for (auto _ : state) {
+        client.readMany(nodes, values);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(nodes.size()));
+    client.disconnect();
+}
+BENCHMARK(BM_Client_readMany)->UseRealTime();
+
+static void BM_Client_browseChildren(benchmark::State& state)
+{
+    opc::Client client;
+    if (!connectClient(state, client)) return;
+
+    auto& b = BenchServer::instance();
+    size_t n = 0;
+    for (auto _ : state) {
+        opc::NodeIdHashMap children;
+        client.browseChildren(b.folder, children);
+        n = children.size();
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(n));
+    client.disconnect();
+}
+BENCHMARK(BM_Client_browseChildren)->UseRealTime();
@@ -0,0 +1,271 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <benchmark/benchmark.h>
+#include <open62541cpp/columnarhistory.h>
+#include <open62541cpp/compressedhistory.h>
+#include <open62541cpp/historyaggregates.h>
+#include <open62541cpp/mappedhistory.h>
+#ifdef UA_CPP_SQLITE_HISTORY
+#include <open62541cpp/sqlitehistory.h>
+#endif
+#include "bench_server.h"
+
+namespace opc = Open62541;
+
+//*****************************************************************************
+// History ingestion: arg historized nodes, the samples are spread over them
+
+static const size_t kSamples = 1 << 20;
+
+// a Double sample per 100 ns tick, round robin over the nodes,
+// through the backend call back as the gathering does
+// returns the nodes
+static std::vector<UA_NodeId> appendSamples(benchmark::State& state, opc::HistoryDataBackend& store)
+{
+    UA_Server* server = BenchServer::instance().server.server();
+    UA_HistoryDataBackend& backend = store.database();
+    std::vector<UA_NodeId> nodes(state.range(0));
+    for (size_t i = 0; i < nodes.size(); i++)
+        nodes[i] = UA_NODEID_NUMERIC(1, UA_UInt32(i + 1));
+    UA_Double d = 0;
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Variant_setScalar(&dv.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dv.hasValue = true;
+    dv.hasSourceTimestamp = true;
+    dv.sourceTimestamp = UA_DateTime_now(); // after the samples of the previous runs
+    for (auto _ : state) {
+        for (size_t i = 0; i < kSamples; i++) {
+            d += 0.5;
+            dv.sourceTimestamp++;
+            backend.serverSetHistoryData(server, backend.context, nullptr, nullptr,
+                                         &nodes[i % nodes.size()], true, &dv);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kSamples);
+    return nodes;
+}
+
+// memory used per stored sample
+template <typename Store>
+static double bytesPerSample(const Store& store, const std::vector<UA_NodeId>& nodes)
+{
+    size_t n = 0;
+    for (const auto& node : nodes)
+        n += store.size(node);
+    return n ? double(store.memoryUsage()) / n : 0.0;
+}
+
+static void BM_ColumnarHistory_append(benchmark::State& state)
+{
+    opc::ColumnarHistoryBackend store(kSamples);
+    auto nodes = appendSamples(state, store);
+    state.counters["bytes/sample"] = bytesPerSample(store, nodes);
+}
+BENCHMARK(BM_ColumnarHistory_append)->Arg(1)->Arg(100)->Unit(benchmark::kMillisecond);
+
+// segment files in bin/bench_history, at most 8 x 2 MiB per node
+static void BM_MappedHistory_append(benchmark::State& state)
+{
+    opc::MappedHistoryBackend store(BENCH_HISTORY_DIR, 65536, 8);
+    appendSamples(state, store);
+}
+BENCHMARK(BM_MappedHistory_append)->Arg(1)->Arg(100)->Unit(benchmark::kMillisecond);
+
+static void BM_CompressedHistory_append(benchmark::State& state)
+{
+    opc::CompressedHistoryBackend store(1024, kSamples);
+    auto nodes = appendSamples(state, store);
+    state.counters["bytes/sample"] = bytesPerSample(store, nodes);
+}
+BENCHMARK(BM_CompressedHistory_append)->Arg(1)->Arg(100)->Unit(benchmark::kMillisecond);
+
+#ifdef UA_CPP_SQLITE_HISTORY
+// bin/bench_history/history.db, the samples inserted in one transaction as by a write-behind drain:
+// autocommitted, each insert would be a transaction of its own
+static void BM_SQLiteHistory_append(benchmark::State& state)
+{
+    opc::SQLiteHistoryBackend store(BENCH_HISTORY_DIR "/history.db", kSamples);
+    store.begin();
+    appendSamples(state, store);
+    store.commit();
+}
+BENCHMARK(BM_SQLiteHistory_append)->Arg(1)->Arg(100)->Unit(benchmark::kMillisecond);
+#endif
+
+//*****************************************************************************
+// History reads: arg samples read per request, in a 1M samples history
+
+// 1 Hz samples of a slowly changing Double, with a millisecond jitter
+static void BM_CompressedHistory_read(benchmark::State& state)
+{
+    const size_t n = size_t(state.range(0));
+    UA_Server* server = BenchServer::instance().server.server();
+    opc::CompressedHistoryBackend store(1024, kSamples);
+    UA_HistoryDataBackend& backend = store.database();
+    UA_NodeId node    = UA_NODEID_NUMERIC(1, 1);
+    UA_NodeId session = UA_NODEID_NUMERIC(1, 2);
+
+    UA_Double d = 20.0;
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Variant_setScalar(&dv.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dv.hasValue = true;
+    dv.hasSourceTimestamp = true;
+    for (size_t i = 0; i < kSamples; i++) {
+        if (i % 16 == 0) d += 0.125;
+        dv.sourceTimestamp = UA_DateTime(i) * UA_DATETIME_SEC + UA_DateTime(i * 7919 % 20000);
+        store.append(node, dv);
+    }
+
+    std::vector<UA_DataValue> values(n);
+    size_t start = 0;
+    for (auto _ : state) {
+        size_t provided = 0;
+        backend.copyDataValues(server, backend.context, &session, nullptr, &node,
+                               start, start + n - 1, false, n, UA_NumericRange{0, nullptr},
+                               false, nullptr, nullptr, &provided, values.data());
+        for (size_t i = 0; i < provided; i++)
+            UA_DataValue_clear(&values[i]);
+        start = (start + 7 * n) % (kSamples - n);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    state.counters["bytes/sample"] = double(store.memoryUsage()) / store.size(node);
+}
+BENCHMARK(BM_CompressedHistory_read)->Arg(100)->Arg(10000);
+
+//*****************************************************************************
+// Processed reads: a year of 1 Hz samples aggregated into 1 hour intervals,
+// arg the HistoryAggregator::Aggregate
+
+static const size_t kYearSeconds = 365 * 86400;
+
+struct YearOfSamples {
+    std::vector<UA_DateTime>    times;
+    std::vector<double>         values;
+};
+
+static const YearOfSamples& yearOfSamples()
+{
+    static YearOfSamples samples;
+    if (samples.times.empty()) {
+        samples.times.resize(kYearSeconds);
+        samples.values.resize(kYearSeconds);
+        for (size_t i = 0; i < kYearSeconds; i++) {
+            samples.times[i]  = UA_DateTime(i) * UA_DATETIME_SEC;
+            samples.values[i] = 20.0 + double(i % 3600) / 360.0 + double(i * 7919 % 100) / 1000.0;
+        }
+    }
+    return samples;
+}
+
+// the samples are folded as they are added, as by a read from the backend
+static void BM_HistoryAggregate_year(benchmark::State& state)
+{
+    const YearOfSamples& samples = yearOfSamples();
+    const auto          aggregate   = opc::HistoryAggregator::Aggregate(state.range(0));
+    const UA_DateTime   end         = UA_DateTime(kYearSeconds) * UA_DATETIME_SEC;
+    const UA_DateTime   interval    = 3600 * UA_DATETIME_SEC;
+    const size_t        count       = kYearSeconds / 3600;
+
+    opc::HistoryAggregator      aggregator;
+    std::vector<double>         values(count);
+    std::vector<UA_StatusCode>  status(count);
+    for (auto _ : state) {
+        aggregator.reset(0, end, interval, count);
+        for (size_t i = 0; i < kYearSeconds; i++)
+            aggregator.add(samples.times[i], samples.values[i]);
+        aggregator.compute(aggregate, values.data(), status.data());
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kYearSeconds);
+}
+BENCHMARK(BM_HistoryAggregate_year)
+    ->Arg(opc::HistoryAggregator::Interpolative)
+    ->Arg(opc::HistoryAggregator::Average)
+    ->Arg(opc::HistoryAggregator::TimeAverage)
+    ->Arg(opc::HistoryAggregator::Minimum)
+    ->Arg(opc::HistoryAggregator::Maximum)
+    ->Arg(opc::HistoryAggregator::Count)
+    ->Arg(opc::HistoryAggregator::Delta)
+    ->Unit(benchmark::kMillisecond);
+
+//*****************************************************************************
+// Processed reads through the service call back of a historian: a day of 1 Hz samples
+// of a node, read from the backend in many chunks, counted per 1 minute interval.
+// Fails if a sample is missed.
+
+static void BM_Historian_readProcessed(benchmark::State& state)
+{
+    const size_t        samples     = 86400;
+    opc::Server&        server      = BenchServer::instance().server;
+    opc::ColumnarHistorian historian(1, samples);
+    opc::NodeId         node(1, 1001);
+    UA_NodeId           session     = UA_NODEID_NUMERIC(1, 2);
+    historian.setUserNode(node, server);
+
+    UA_HistoryDataBackend& backend = historian.backend();
+    UA_Double d = 20.0;
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Variant_setScalar(&dv.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dv.hasValue = true;
+    dv.hasSourceTimestamp = true;
+    for (size_t i = 0; i < samples; i++) {
+        d = 20.0 + double(i % 3600) / 360.0;
+        dv.sourceTimestamp = UA_DateTime(i) * UA_DATETIME_SEC;
+        backend.serverSetHistoryData(server.server(), backend.context, nullptr, nullptr, node.ref(), true, &dv);
+    }
+
+    UA_NodeId count = UA_NODEID_NUMERIC(0, UA_NS0ID_AGGREGATEFUNCTION_COUNT);
+    UA_ReadProcessedDetails details;
+    UA_ReadProcessedDetails_init(&details);
+    details.startTime           = 0;
+    details.endTime             = UA_DateTime(samples) * UA_DATETIME_SEC;
+    details.processingInterval  = 60000.0;
+    details.aggregateTypeSize   = 1;
+    details.aggregateType       = &count;
+    UA_HistoryReadValueId toRead;
+    UA_HistoryReadValueId_init(&toRead);
+    toRead.nodeId = *node.ref();
+    UA_RequestHeader header;
+    UA_RequestHeader_init(&header);
+
+    UA_HistoryDatabase& database = historian.database();
+    for (auto _ : state) {
+        UA_HistoryReadResponse response;
+        UA_HistoryReadResponse_init(&response);
+        response.results = static_cast<UA_HistoryReadResult*>(
+            UA_Array_new(1, &UA_TYPES[UA_TYPES_HISTORYREADRESULT]));
+        response.resultsSize = 1;
+        UA_HistoryData data;
+        UA_HistoryData_init(&data);
+        UA_HistoryData* historyData = &data;
+        database.readProcessed(server.server(), database.context, &session, nullptr, &header, &details,
+                               UA_TIMESTAMPSTORETURN_SOURCE, false, 1, &toRead, &response, &historyData);
+
+        size_t total = 0;
+        for (size_t i = 0; i < data.dataValuesSize; i++) {
+            const UA_DataValue& v = data.dataValues[i];
+            if (v.hasValue) total += size_t(*static_cast<const UA_Int32*>(v.value.data));
+        }
+        const bool ok = response.results[0].statusCode == UA_STATUSCODE_GOOD && total == samples;
+        UA_HistoryData_clear(&data);
+        UA_HistoryReadResponse_clear(&response);
+        if (!ok) {
+            state.SkipWithError("readProcessed missed samples");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * samples);
+}
+BENCHMARK(BM_Historian_readProcessed)->Unit(benchmark::kMillisecond);
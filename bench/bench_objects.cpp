@@ -0,0 +1,162 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <benchmark/benchmark.h>
+#include <open62541cpp/open62541objects.h>
+#include <open62541cpp/objects/NodeIdMap.h>
+#include <open62541cpp/objects/NodeIdHashMap.h>
+#include <open62541cpp/propertytree.h>
+
+namespace opc = Open62541;
+
+//*****************************************************************************
+// Variant
+
+static void BM_Variant_scalar(benchmark::State& state)
+{
+    int i = 0;
+    for (auto _ : state) {
+        opc::Variant v(i++);
+        benchmark::DoNotOptimize(v.constRef());
+    }
+}
+BENCHMARK(BM_Variant_scalar);
+
+static void BM_Variant_string(benchmark::State& state)
+{
+    const std::string s(size_t(state.range(0)), 'x');
+    for (auto _ : state) {
+        opc::Variant v(s);
+        benchmark::DoNotOptimize(v.constRef());
+    }
+}
+BENCHMARK(BM_Variant_string)->Arg(8)->Arg(256);
+
+static void BM_Variant_vector(benchmark::State& state)
+{
+    const std::vector<double> values(size_t(state.range(0)), 1.5);
+    for (auto _ : state) {
+        opc::Variant v(values);
+        benchmark::DoNotOptimize(v.constRef());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Variant_vector)->Arg(16)->Arg(1024);
+
+//*****************************************************************************
+// NodeId
+
+static opc::NodeId benchNodeId(int type)
+{
+    return type ? opc::NodeId(2, "Plant.Line1.Machine4.Temperature") : opc::NodeId(2, 12345u);
+}
+
+static void BM_NodeId_copy(benchmark::State& state)
+{
+    const opc::NodeId source = benchNodeId(int(state.range(0)));
+    for (auto _ : state) {
+        opc::NodeId copy(source);
+        benchmark::DoNotOptimize(copy.constRef());
+    }
+}
+BENCHMARK(BM_NodeId_copy)->ArgName("string")->Arg(0)->Arg(1);
+
+static void BM_NodeId_compare(benchmark::State& state)
+{
+    opc::NodeId a = benchNodeId(int(state.range(0)));
+    const opc::NodeId b = benchNodeId(int(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a == b);
+    }
+}
+BENCHMARK(BM_NodeId_compare)->ArgName("string")->Arg(0)->Arg(1);
+
+//*****************************************************************************
+// Node id sets
+
+static std::vector<opc::NodeId> benchNodeIds(size_t n)
+{
+    std::vector<opc::NodeId> nodes;
+    nodes.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        nodes.push_back((i % 2) ? opc::NodeId(2, "Node_" + std::to_string(i)) : opc::NodeId(2, unsigned(i)));
+    }
+    return nodes;
+}
+
+static void BM_NodeIdMap_put(benchmark::State& state)
+{
+    const auto nodes = benchNodeIds(size_t(state.range(0)));
+    for (auto _ : state) {
+        opc::NodeIdMap map;
+        for (auto& node : nodes)
+            map.put(node);
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NodeIdMap_put)->Arg(1000)->Arg(100000);
+
+static void BM_NodeIdHashMap_put(benchmark::State& state)
+{
+    const auto nodes = benchNodeIds(size_t(state.range(0)));
+    for (auto _ : state) {
+        opc::NodeIdHashMap map;
+        for (auto& node : nodes)
+            map.put(node);
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NodeIdHashMap_put)->Arg(1000)->Arg(100000);
+
+//*****************************************************************************
+// PropertyTree
+
+typedef opc::PropertyTree<std::string, int> BenchTree;
+
+static void BM_PropertyTree_set(benchmark::State& state)
+{
+    BenchTree tree;
+    BenchTree::Path path("Plant.Line1.Machine4.Temperature");
+    int i = 0;
+    for (auto _ : state) {
+        tree.set(path, i++);
+    }
+}
+BENCHMARK(BM_PropertyTree_set);
+
+static void BM_PropertyTree_get(benchmark::State& state)
+{
+    BenchTree tree;
+    for (int line = 0; line < 10; line++) {
+        for (int machine = 0; machine < 10; machine++) {
+            BenchTree::Path p("Plant.Line" + std::to_string(line) + ".Machine" + std::to_string(machine) + ".Temperature");
+            tree.set(p, line * machine);
+        }
+    }
+    BenchTree::Path path("Plant.Line4.Machine7.Temperature");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree.get(path));
+    }
+}
+BENCHMARK(BM_PropertyTree_get);
+
+static void BM_PropertyTree_get_string(benchmark::State& state)
+{
+    BenchTree tree;
+    tree.set(BenchTree::Path("Plant.Line4.Machine7.Temperature"), 1);
+    const std::string path("Plant.Line4.Machine7.Temperature");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree.get(path)); // includes splitting the path
+    }
+}
+BENCHMARK(BM_PropertyTree_get_string);
@@ -0,0 +1,309 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "bench_server.h"
+
+namespace opc = Open62541;
+
+//*****************************************************************************
+
+BenchServer::BenchServer()
+    : refContext(
+          [](opc::Server&, opc::NodeIdRef, const UA_NumericRange*, UA_DataValue& value) {
+              UA_Int32 v = 42;
+              UA_Variant_setScalarCopy(&value.value, &v, &UA_TYPES[UA_TYPES_INT32]);
+              value.hasValue = true;
+              return true;
+          },
+          opc::NodeContext::ConstDataRefFunc(), "BenchRef")
+    , copyContext(
+          [](opc::Server&, opc::NodeId&, const UA_NumericRange*, UA_DataValue& value) {
+              UA_Int32 v = 42;
+              UA_Variant_setScalarCopy(&value.value, &v, &UA_TYPES[UA_TYPES_INT32]);
+              value.hasValue = true;
+              return true;
+          },
+          opc::NodeContext::ConstDataFunc(), "BenchCopy")
+{
+    ns = server.addNamespace("urn:open62541cpp:bench");
+
+    folder = opc::NodeId(ns, "Bench");
+    server.addFolder(opc::NodeId::Objects, "Bench", folder, opc::NodeId::Null, ns);
+    for (int i = 0; i < Variables; i++) {
+        const std::string name = "Value_" + std::to_string(i);
+        opc::NodeId node = (i % 2) ? opc::NodeId(ns, name) : opc::NodeId(ns, unsigned(1000 + i));
+        opc::Variant v(i);
+        server.addVariable(folder, name, v, node, opc::NodeId::Null, nullptr, ns);
+        variables.push_back(node);
+    }
+
+    dataSource = opc::NodeId(ns, "DataSource");
+    opc::Variant v(0);
+    server.addVariable(folder, "DataSource", v, dataSource, opc::NodeId::Null, &refContext, ns);
+    refContext.setAsDataSource(server, dataSource);
+
+    thread = std::thread([this] { server.start(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // let it listen
+}
+
+//*****************************************************************************
+
+BenchServer::~BenchServer()
+{
+    server.stop();
+    if (thread.joinable())
+        thread.join();
+}
+
+//*****************************************************************************
+
+std::unique_ptr<BenchServer>& BenchServer::holder()
+{
+    static std::unique_ptr<BenchServer> p;
+    return p;
+}
+
+BenchServer& BenchServer::instance()
+{
+    static std::mutex mutex; // the multi-threaded benchmarks start together
+    std::lock_guard<std::mutex> l(mutex);
+    auto& p = holder();
+    if (!p) p.reset(new BenchServer());
+    return *p;
+}
+
+void BenchServer::release()
+{
+    holder().reset();
+}
+
+//*****************************************************************************
+// Server API, in process
+
+static void BM_Server_readValue(benchmark::State& state)
+{
+    auto& b = BenchServer::instance();
+    opc::Variant v;
+    size_t i = 0;
+    for (auto _ : state) {
+        b.server.readValue(b.variables[i++ % b.variables.size()], v);
+        benchmark::DoNotOptimize(v.constRef());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Server_readValue);
+
+static void BM_Server_setValue(benchmark::State& state)
+{
+    auto& b = BenchServer::instance();
+    opc::Variant v(7);
+    size_t i = 0;
+    for (auto _ : state) {
+        b.server.setValue(b.variables[i++ % b.variables.size()], v);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Server_setValue);
+
+// all the variables per batch skipping the unchanged values, arg 1 changes every value, arg 0 none
+static void BM_Server_writeValues(benchmark::State& state)
+{
+    auto& b = BenchServer::instance();
+    std::vector<std::pair<opc::NodeId, opc::Variant>> values;
+    std::vector<UA_StatusCode> results;
+    int cycle = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        values.clear();
+        cycle += int(state.range(0));
+        for (auto& node : b.variables)
+            values.emplace_back(node, opc::Variant(cycle));
+        state.ResumeTiming();
+        b.server.writeValues(values, results, true);
+    }
+    state.SetItemsProcessed(state.iterations() * b.variables.size());
+}
+BENCHMARK(BM_Server_writeValues)->ArgName("changed")->Arg(1)->Arg(0);
+
+//*****************************************************************************
+// Concurrent readers with a concurrent writer: arg 1 also serialises the reads behind
+// an exclusive mutex, as every read was before the read-only services took the shared lock.
+// Without UA_MULTITHREADING the ServerReadLock is exclusive, with it open62541 serialises
+// UA_Server_read itself: the reads are serialised in both builds, the label says by what.
+
+/**
+ * setValue() on the benchmark variables every 100 us, from its own thread,
+ * while at least one reader thread holds it.
+ */
+class ConcurrentWriter {
+    static std::mutex           mutex;
+    static unsigned             readers;
+    static std::atomic<bool>    running;
+    static std::atomic<size_t>  writes;
+    static std::thread          thread;
+
+public:
+    static void acquire()
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        if (readers++) return;
+        auto& b = BenchServer::instance();
+        writes  = 0;
+        running = true;
+        thread  = std::thread([&b] {
+            size_t i = 0;
+            while (running) {
+                opc::Variant v(int(i));
+                b.server.setValue(b.variables[i++ % b.variables.size()], v);
+                writes++;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+    }
+
+    /** @return the number of writes done since the first reader acquired the writer */
+    static size_t release()
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        if (--readers) return writes;
+        running = false;
+        if (thread.joinable()) thread.join();
+        return writes;
+    }
+};
+
+std::mutex          ConcurrentWriter::mutex;
+unsigned            ConcurrentWriter::readers = 0;
+std::atomic<bool>   ConcurrentWriter::running{false};
+std::atomic<size_t> ConcurrentWriter::writes{0};
+std::thread         ConcurrentWriter::thread;
+
+static void BM_Server_readValue_concurrent(benchmark::State& state)
+{
+    static std::mutex exclusive;
+    auto& b = BenchServer::instance();
+    const bool serialise = state.range(0) != 0;
+#if UA_MULTITHREADING >= 100
+    state.SetLabel(serialise ? "serialised: mutex + open62541 service mutex"
+                             : "serialised: open62541 service mutex");
+#else
+    state.SetLabel(serialise ? "serialised: mutex + exclusive ServerReadLock"
+                             : "serialised: exclusive ServerReadLock, no UA_MULTITHREADING");
+#endif
+    opc::Variant v;
+    size_t i = 0;
+    ConcurrentWriter::acquire();
+    for (auto _ : state) {
+        const opc::NodeId& node = b.variables[i++ % b.variables.size()];
+        if (serialise) {
+            std::lock_guard<std::mutex> l(exclusive);
+            b.server.readValue(node, v);
+        }
+        else {
+            b.server.readValue(node, v);
+        }
+        benchmark::DoNotOptimize(v.constRef());
+    }
+    state.counters["writes"] = benchmark::Counter(double(ConcurrentWriter::release()),
+                                                  benchmark::Counter::kAvgThreads);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Server_readValue_concurrent)
+    ->ArgName("exclusive")->Arg(0)->Arg(1)
+    ->ThreadRange(1, 8)->UseRealTime();
+
+//*****************************************************************************
+// Server::browseTree into each map type, over a tree of folders
+
+static const int kTreeNodes     = 10000;
+static const int kTreeChildren  = 10;
+
+// breadth first, half of the nodes with string ids like most information models
+static const opc::NodeId& benchTree()
+{
+    static opc::NodeId root;
+    if (!root.isNull()) return root;
+
+    auto& b = BenchServer::instance();
+    root = opc::NodeId(b.ns, "Tree");
+    b.server.addFolder(opc::NodeId::Objects, "Tree", root, opc::NodeId::Null, b.ns);
+    std::vector<opc::NodeId> folders{root};
+    for (size_t parent = 0; int(folders.size()) < kTreeNodes; parent++) {
+        for (int c = 0; c < kTreeChildren && int(folders.size()) < kTreeNodes; c++) {
+            const int n = int(folders.size());
+            const std::string name = "Tree_" + std::to_string(n);
+            opc::NodeId node = (n % 2) ? opc::NodeId(b.ns, name) : opc::NodeId(b.ns, unsigned(100000 + n));
+            b.server.addFolder(folders[parent], name, node, opc::NodeId::Null, b.ns);
+            folders.push_back(node);
+        }
+    }
+    return root;
+}
+
+template <typename Map>
+static void browseTreeInto(benchmark::State& state)
+{
+    auto& b = BenchServer::instance();
+    const opc::NodeId& root = benchTree();
+    size_t nodes = 0;
+    for (auto _ : state) {
+        Map map;
+        b.server.browseTree(root, map);
+        nodes = map.size();
+    }
+    state.SetItemsProcessed(state.iterations() * nodes);
+}
+
+static void BM_Server_browseTree_NodeIdMap(benchmark::State& state)
+{
+    browseTreeInto<opc::NodeIdMap>(state);
+}
+BENCHMARK(BM_Server_browseTree_NodeIdMap)->Unit(benchmark::kMillisecond);
+
+static void BM_Server_browseTree_NodeIdHashMap(benchmark::State& state)
+{
+    browseTreeInto<opc::NodeIdHashMap>(state);
+}
+BENCHMARK(BM_Server_browseTree_NodeIdHashMap)->Unit(benchmark::kMillisecond);
+
+//*****************************************************************************
+// NodeContext data source dispatch, as done by the stack on each read
+
+static void dataSourceDispatch(benchmark::State& state, opc::NodeContext& context, const opc::NodeId& node)
+{
+    auto& b = BenchServer::instance();
+    UA_DataValue value;
+    UA_DataValue_init(&value);
+    for (auto _ : state) {
+        opc::NodeContext::readDataSource(b.server.server(), nullptr, nullptr, node.constRef(),
+                                         &context, false, nullptr, &value);
+        UA_DataValue_clear(&value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_NodeContext_readDataSource_Ref(benchmark::State& state)
+{
+    auto& b = BenchServer::instance();
+    dataSourceDispatch(state, b.refContext, b.dataSource);
+}
+BENCHMARK(BM_NodeContext_readDataSource_Ref);
+
+static void BM_NodeContext_readDataSource_Copy(benchmark::State& state)
+{
+    auto& b = BenchServer::instance();
+    dataSourceDispatch(state, b.copyContext, b.dataSource);
+}
+BENCHMARK(BM_NodeContext_readDataSource_Copy);
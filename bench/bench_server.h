@@ -0,0 +1,55 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef BENCH_SERVER_H
+#define BENCH_SERVER_H
+
+#include <thread>
+#include <vector>
+#include <memory>
+#include <open62541cpp/open62541server.h>
+#include <open62541cpp/nodecontext.h>
+
+/**
+ * In-process server shared by the server and client benchmarks.
+ * Started on first use, running in its own thread until release().
+ */
+class BenchServer {
+public:
+    static const int Port       = 4860;
+    static const int Variables  = 100;
+
+    Open62541::Server           server{Port};
+    std::thread                 thread;
+    int                         ns = 0;         /**< namespace of the benchmark nodes */
+    Open62541::NodeId           folder;         /**< parent of the variables */
+    std::vector<Open62541::NodeId> variables;   /**< plain variables, numeric then string ids */
+    Open62541::NodeId           dataSource;     /**< variable read through a NodeContext */
+    Open62541::NodeContext      refContext;     /**< data source taking a NodeIdRef */
+    Open62541::NodeContext      copyContext;    /**< data source taking a NodeId copy */
+
+    /** @return the running server, created on first call. */
+    static BenchServer& instance();
+
+    /** Stop the server if it was started. */
+    static void release();
+
+    /** @return the endpoint url of the server */
+    static std::string endpoint() { return "opc.tcp://localhost:" + std::to_string(Port); }
+
+    BenchServer();
+    ~BenchServer();
+
+private:
+    static std::unique_ptr<BenchServer>& holder();
+};
+
+#endif // BENCH_SERVER_H
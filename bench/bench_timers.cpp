@@ -0,0 +1,85 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <benchmark/benchmark.h>
+#include <open62541cpp/open62541server.h>
+#include <open62541cpp/timerwheel.h>
+
+namespace opc = Open62541;
+
+//*****************************************************************************
+// Concurrent timeouts, as per-request watchdogs: arg concurrent timers
+
+// add the timers then cancel them all, none expires
+static void BM_TimerWheel_addCancel(benchmark::State& state)
+{
+    opc::TimerWheel wheel(10, 0);
+    std::vector<opc::TimerWheel::Id> ids(state.range(0));
+    for (auto _ : state) {
+        for (size_t i = 0; i < ids.size(); i++)
+            ids[i] = wheel.addTimeout(1000 + i % 60000, [](opc::TimerWheel::Id) {});
+        for (auto id : ids)
+            wheel.cancel(id);
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+BENCHMARK(BM_TimerWheel_addCancel)->Arg(1000)->Arg(100000);
+
+// watchdog kicks of pending timers
+static void BM_TimerWheel_reschedule(benchmark::State& state)
+{
+    opc::TimerWheel wheel(10, 0);
+    std::vector<opc::TimerWheel::Id> ids(state.range(0));
+    for (size_t i = 0; i < ids.size(); i++)
+        ids[i] = wheel.addTimeout(1000 + i % 60000, [](opc::TimerWheel::Id) {});
+    size_t i = 0;
+    for (auto _ : state) {
+        wheel.reschedule(ids[i], 5000 + i % 60000);
+        if (++i == ids.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerWheel_reschedule)->Arg(100000);
+
+// add the timers then let them all expire
+static void BM_TimerWheel_expire(benchmark::State& state)
+{
+    const size_t n = size_t(state.range(0));
+    uint64_t now = 0;
+    size_t fired = 0;
+    opc::TimerWheel wheel(10, now);
+    for (auto _ : state) {
+        for (size_t i = 0; i < n; i++)
+            wheel.addTimeout(10 + i % 60000, [&fired](opc::TimerWheel::Id) { fired++; });
+        while (wheel.size()) {
+            now += 10;
+            wheel.advance(now);
+        }
+    }
+    benchmark::DoNotOptimize(fired);
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_TimerWheel_expire)->Arg(1000)->Arg(100000);
+
+// same as BM_TimerWheel_addCancel with one stack call-back per timer, in a server not running
+static void BM_Server_addTimedEvent(benchmark::State& state)
+{
+    opc::Server server;
+    std::vector<UA_UInt64> ids(state.range(0));
+    for (auto _ : state) {
+        for (size_t i = 0; i < ids.size(); i++)
+            server.addTimedEvent(1000 + unsigned(i % 60000), ids[i], [](opc::Timer&) {});
+        for (auto id : ids)
+            server.removeTimerEvent(id);
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+BENCHMARK(BM_Server_addTimedEvent)->Arg(1000)->Arg(100000);
@@ -0,0 +1,132 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace Open62541 {
+
+/**
+ * The BoundedQueue class
+ * Fixed capacity lock-free FIFO, safe with any number of producer and consumer threads.
+ * Each cell carries a sequence number telling whether it is free to write or ready to read,
+ * so a push or a pop only costs one compare-and-swap on the shared position.
+ * Never blocks: tryPush() fails when full, tryPop() fails when empty.
+ * @param T the stored type. Must be default constructible and movable.
+ */
+template <typename T>
+class BoundedQueue {
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T                   data;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    const size_t            m_mask;
+    alignas(64) std::atomic<size_t> m_enqueuePos{0}; // separate cache lines for producers and consumers
+    alignas(64) std::atomic<size_t> m_dequeuePos{0};
+
+    static size_t roundUp(size_t n) {
+        size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+public:
+    /**
+     * @param capacity the maximum number of items, rounded up to a power of 2.
+     */
+    explicit BoundedQueue(size_t capacity)
+        : m_cells(new Cell[roundUp(capacity)])
+        , m_mask(roundUp(capacity) - 1) {
+        for (size_t i = 0; i <= m_mask; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /** @return the maximum number of items */
+    size_t capacity() const { return m_mask + 1; }
+
+    /** @return the number of items, approximate while other threads push or pop */
+    size_t size() const {
+        const size_t out = m_dequeuePos.load(std::memory_order_relaxed);
+        const size_t in  = m_enqueuePos.load(std::memory_order_relaxed);
+        const size_t n   = (in > out) ? in - out : 0;
+        return (n > m_mask) ? m_mask + 1 : n;
+    }
+
+    /**
+     * Add an item at the end of the queue.
+     * @param item moved into the queue on success, untouched otherwise.
+     * @return false if the queue is full.
+     */
+    bool tryPush(T& item) {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const size_t   seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t dif = intptr_t(seq) - intptr_t(pos);
+            if (dif == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0) {
+                return false; // full
+            }
+            else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove the item at the front of the queue.
+     * @param[out] item receives the removed item.
+     * @return false if the queue is empty.
+     */
+    bool tryPop(T& item) {
+        Cell* cell;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const size_t   seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t dif = intptr_t(seq) - intptr_t(pos + 1);
+            if (dif == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0) {
+                return false; // empty
+            }
+            else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->data);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+} // namespace Open62541
+
+#endif // BOUNDEDQUEUE_H
@@ -0,0 +1,134 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef CLIENTASYNC_H
+#define CLIENTASYNC_H
+
+#include <open62541cpp/open62541objects.h>
+#include <open62541cpp/objects/UaBaseTypeTemplate.h>
+#include <functional>
+
+namespace Open62541 {
+
+/**
+ * The AsyncOperation class
+ * A service request sent, or waiting to be sent, by the Client asynchronous API.
+ * Owns the request until the response arrives.
+ * The completion is called exactly once, with the response or with a failure status.
+ */
+class AsyncOperation {
+    const UA_DataType* m_requestType;   /**< type of the request struct */
+    const UA_DataType* m_responseType;  /**< type of the response struct */
+
+public:
+    AsyncOperation(const UA_DataType* requestType, const UA_DataType* responseType)
+        : m_requestType(requestType)
+        , m_responseType(responseType) {}
+    virtual ~AsyncOperation() {}
+
+    const UA_DataType* requestType()  const { return m_requestType; }
+    const UA_DataType* responseType() const { return m_responseType; }
+
+    /** @return a pointer on the request struct to encode */
+    virtual const void* request() const = 0;
+
+    /**
+     * Called when the response is received.
+     * @param response the response struct, owned by the stack. It may be moved from.
+     */
+    virtual void complete(void* response) = 0;
+
+    /**
+     * Called instead of complete() when the request cannot be sent.
+     * @param status the reason, stored in the response header given to the completion.
+     */
+    virtual void fail(UA_StatusCode status) = 0;
+};
+
+/**
+ * The AsyncServiceCall class
+ * Binds a request type, its response type and the completion function.
+ * @param Request the UA_ request struct, for example UA_ReadRequest.
+ * @param REQUEST_INDEX its index in UA_TYPES.
+ * @param Response the UA_ response struct, for example UA_ReadResponse.
+ * @param RESPONSE_INDEX its index in UA_TYPES.
+ */
+template <typename Request, int REQUEST_INDEX, typename Response, int RESPONSE_INDEX>
+class AsyncServiceCall : public AsyncOperation {
+public:
+    typedef std::function<void(Response&)> Completion;
+
+private:
+    Request     m_request;  /**< owned request */
+    Completion  m_done;     /**< completion function */
+
+public:
+    AsyncServiceCall(Completion done)
+        : AsyncOperation(&UA_TYPES[REQUEST_INDEX], &UA_TYPES[RESPONSE_INDEX])
+        , m_done(std::move(done)) {
+        UA_init(&m_request, &UA_TYPES[REQUEST_INDEX]);
+    }
+
+    ~AsyncServiceCall() { UA_clear(&m_request, &UA_TYPES[REQUEST_INDEX]); }
+
+    /** @return the request to fill before the call is submitted */
+    Request& get() { return m_request; }
+
+    const void* request() const override { return &m_request; }
+
+    void complete(void* response) override {
+        if (m_done) m_done(*static_cast<Response*>(response));
+    }
+
+    void fail(UA_StatusCode status) override {
+        Response response;
+        UA_init(&response, &UA_TYPES[RESPONSE_INDEX]);
+        response.responseHeader.serviceResult = status;
+        complete(&response);
+        UA_clear(&response, &UA_TYPES[RESPONSE_INDEX]);
+    }
+};
+
+// Asynchronous calls of the supported services
+typedef AsyncServiceCall<UA_ReadRequest, UA_TYPES_READREQUEST,
+                         UA_ReadResponse, UA_TYPES_READRESPONSE>                 AsyncRead;
+typedef AsyncServiceCall<UA_WriteRequest, UA_TYPES_WRITEREQUEST,
+                         UA_WriteResponse, UA_TYPES_WRITERESPONSE>               AsyncWrite;
+typedef AsyncServiceCall<UA_BrowseRequest, UA_TYPES_BROWSEREQUEST,
+                         UA_BrowseResponse, UA_TYPES_BROWSERESPONSE>             AsyncBrowse;
+typedef AsyncServiceCall<UA_CallRequest, UA_TYPES_CALLREQUEST,
+                         UA_CallResponse, UA_TYPES_CALLRESPONSE>                 AsyncCall;
+typedef AsyncServiceCall<UA_HistoryReadRequest, UA_TYPES_HISTORYREADREQUEST,
+                         UA_HistoryReadResponse, UA_TYPES_HISTORYREADRESPONSE>   AsyncHistoryRead;
+
+// Owning wrappers of the responses, delivered by the futures
+typedef TypeBase<UA_ReadResponse, UA_TYPES_READRESPONSE>                ReadResponse;
+typedef TypeBase<UA_WriteResponse, UA_TYPES_WRITERESPONSE>              WriteResponse;
+typedef TypeBase<UA_BrowseResponse, UA_TYPES_BROWSERESPONSE>            BrowseResponse;
+typedef TypeBase<UA_CallResponse, UA_TYPES_CALLRESPONSE>                CallResponse;
+typedef TypeBase<UA_HistoryReadResponse, UA_TYPES_HISTORYREADRESPONSE>  HistoryReadResponse;
+
+/**
+ * Move a response owned by the stack into its owning wrapper, without deep copy.
+ * @param response moved from, left initialised.
+ * @return the wrapper owning the response content.
+ */
+template <typename T, int TYPES_ARRAY_INDEX>
+TypeBase<T, TYPES_ARRAY_INDEX> takeResponse(T& response) {
+    T* p = static_cast<T*>(UA_new(&UA_TYPES[TYPES_ARRAY_INDEX]));
+    *p = response; // shallow copy transfers the ownership
+    UA_init(&response, &UA_TYPES[TYPES_ARRAY_INDEX]);
+    return TypeBase<T, TYPES_ARRAY_INDEX>(p);
+}
+
+} // namespace Open62541
+
+#endif // CLIENTASYNC_H
@@ -15,6 +15,9 @@
 #ifndef OPEN62541CLIENT_H
 #include <open62541cpp/open62541client.h>
 #endif
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 namespace Open62541 {
 
@@ -28,28 +31,35 @@ typedef std::map<std::string, ClientRef> ClientMap;
  * The ClientCache class
  */
 class ClientCache {
-    ClientMap m_cache;  /**< Cache / Dictionary of Client objects.
-                             these are shared pointers so can be safely copied */
+    ClientMap                   m_cache;        /**< Cache / Dictionary of Client objects.
+                                                     these are shared pointers so can be safely copied */
+    mutable std::mutex          m_mutex;        /**< guards the map, so endpoints can be added and removed
+                                                     while a ClientCacheThread runs */
+    std::condition_variable     m_changed;      /**< notified when the map changes */
+    unsigned                    m_version = 0;  /**< incremented when the map changes */
+
 public:
             ClientCache()  = default;
     virtual ~ClientCache() = default;
 
     /**
-     * Add an endpoint to the cache map.
+     * Add an endpoint to the cache map, thread-safely.
      * If already in the cache, it isn't added.
      * @param endpoint name of the endpoint to add.
-     * @return a reference to the client interface of the endpoint
+     * @return a reference to the client interface of the endpoint, valid until it is removed.
      */
     ClientRef& add(const std::string& endpoint);
 
     /**
-     * Remove the client associated with the given endpoint
+     * Remove the client associated with the given endpoint, thread-safely.
+     * The client is disconnected when its last reference is released.
+     * While a ClientCacheThread runs, it is released by the worker thread processing it.
      * @param endpoint name of client to remove
      */
     void remove(const std::string& endpoint);
 
     /**
-     * Find a client by its name.
+     * Find a client by its name, thread-safely.
      * @param endpoint name of client to find
      * @return pointer to found client, nullptr otherwise.
      */
@@ -61,6 +71,32 @@ public:
      * Periodic processing interface.
      */
     void process();
+
+    /**
+     * Take a thread-safe copy of the cached clients.
+     * @param[out] clients receives the clients, by endpoint.
+     * @return the version of the cache the copy was taken from.
+     */
+    unsigned snapshot(ClientMap& clients) const;
+
+    /** @return the version of the cache, incremented on every add or remove. */
+    unsigned version() const {
+        std::lock_guard<std::mutex> l(m_mutex);
+        return m_version;
+    }
+
+    /**
+     * Wait until the cache changes from a given version, or a timeout.
+     * @param version the last known version.
+     * @param timeout the maximum wait.
+     * @return true if the version changed.
+     */
+    bool waitForChange(unsigned version, std::chrono::milliseconds timeout);
+
+    /**
+     * Wake up all the threads waiting in waitForChange(), as if the cache changed.
+     */
+    void wake();
 }; // class ClientCache
 
 } // namespace Open62541
@@ -13,6 +13,8 @@
 #define CLIENTCACHETHREAD_H
 
 #include <thread>
+#include <atomic>
+#include <vector>
 
 #ifndef CLIENTCACHE_H
 #include <open62541cpp/clientcache.h>
@@ -21,35 +23,63 @@
 namespace Open62541 {
 
 /**
- * Class periodically processing a given list of clients.
- * The period is as fast as possible and depend only on the number of clients
- * and the duration of their process() call.
+ * Class processing a given cache of clients with a pool of worker threads.
+ * Each client is handled by one worker only, chosen by the hash of its endpoint,
+ * so a client is never run from two threads.
+ * A worker blocks in the client run_iterate() for a share of the interval,
+ * instead of spinning, and sleeps until the cache changes when it has no active client.
+ * Endpoints can be added to and removed from the cache while the workers run.
  */
 class ClientCacheThread {
-    ClientCache&    m_cache;
-    std::thread     m_thread;
-    bool            m_running = false;
+    ClientCache&                m_cache;
+    std::vector<std::thread>    m_threads;
+    std::atomic<bool>           m_running{false};
+    unsigned                    m_workers  = 1;     /**< number of worker threads */
+    uint32_t                    m_interval = 100;   /**< maximum duration of a worker cycle in ms */
+
+    /**
+     * Worker thread loop.
+     * @param index the shard processed by the worker.
+     */
+    void run(unsigned index);
 
 public:
     /**
      * ClientCacheThread Constructor
      * @param cache a reference to a cache of clients to process periodically.
+     * @param workers the number of worker threads sharing the clients, at least 1.
+     * @param interval the maximum duration in ms of a worker cycle over all its clients.
      */
-    ClientCacheThread(ClientCache& cache)
-        : m_cache(cache) {}
+    ClientCacheThread(ClientCache& cache, unsigned workers = 1, uint32_t interval = 100)
+        : m_cache(cache)
+        , m_workers(workers ? workers : 1)
+        , m_interval(interval ? interval : 1) {}
+
+    ~ClientCacheThread() { stop(); }
 
     /**
      * start the periodical client cache processing
-     * @return true on success 
+     * @return true on success, false if already running or a thread failed to start.
      */
     bool start();
 
     /**
      * stop the client cache periodical processing.
+     * Waits for the worker threads to finish their cycle.
      * @return always true 
      */
     bool stop();
 
+    /**
+     * @return true if the workers are running.
+     */
+    bool running() const { return m_running; }
+
+    /**
+     * @return the number of worker threads.
+     */
+    unsigned workers() const { return m_workers; }
+
     /**
      * Accessor for the client cache.
      * @return a non-const reference to the client cache.
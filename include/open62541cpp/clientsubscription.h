@@ -32,12 +32,16 @@ typedef std::map<unsigned, MonitoredItemRef> MonitoredItemMap;
  * Every MonitoredItem is attached to exactly one Subscription.
  * And a Subscription can contain many MonitoredItems.
  */
+class NotificationDispatcher;
+
 class ClientSubscription {
     Client&                     m_client;         /**< owning client */
     CreateSubscriptionRequest   m_settings;       /**< subscription settings */
     CreateSubscriptionResponse  m_response;       /**< subscription response */
     int                         m_monitorId = 0;  /**< key monitor items by Id */
+    DataChangeProfile           m_profile;        /**< default monitoring parameters of the data change items */
     MonitoredItemMap            m_map;            /**< map of monitor items - these are monitored items owned by this subscription */
+    NotificationDispatcher*     m_dispatcher = nullptr; /**< runs the data change handlers off the client thread, not owned */
 
 protected:
     /**
@@ -79,6 +83,21 @@ public:
     Client&                         client()    { return m_client; }
     UA_CreateSubscriptionRequest&   settings()  { return m_settings; }
     UA_CreateSubscriptionResponse&  response()  { return m_response; }
+
+    /**
+     * Monitoring parameters used by the data change items added without a profile.
+     * Only applies to the items added afterward.
+     */
+    const DataChangeProfile&        dataChangeProfile() const           { return m_profile; }
+    void setDataChangeProfile(const DataChangeProfile& profile)         { m_profile = profile; }
+
+    /**
+     * Dispatcher running the data change handlers of the items in worker threads.
+     * Null by default: the handlers run in the client thread, during the publish response processing.
+     * The dispatcher must outlive the subscription, or be reset to null before being destroyed.
+     */
+    NotificationDispatcher*         dispatcher() const                  { return m_dispatcher; }
+    void setDispatcher(NotificationDispatcher* dispatcher)              { m_dispatcher = dispatcher; }
     
     /**
      * Hook customizing deleteSubscriptionCallback called at the end of the subscription.
@@ -130,6 +149,51 @@ public:
      */
     unsigned addMonitorNodeId(monitorItemFunc func, NodeId& node);
 
+    /**
+     * Add a node as monitored item, with its own monitoring parameters.
+     * Trigger upon node's data changing more than the profile deadband.
+     * @param func a Functor to handle data change.
+     * @param node to monitor
+     * @param profile sampling, queue and filter parameters of the item.
+     * @return the id of the Monitored Item id
+     * @see MonitoredItemDataChange
+     */
+    unsigned addMonitorNodeId(monitorItemFunc func, NodeId& node, const DataChangeProfile& profile);
+
+    /**
+     * Add a set of nodes as monitored items, with as few CreateMonitoredItems requests as possible.
+     * The requests are split according to the server MaxMonitoredItemsPerCall operation limit.
+     * Trigger upon a node's data changing.
+     * @param func a Functor to handle data change, shared by all the items.
+     * @param nodes to monitor.
+     * @param[out] ids receives the id of each Monitored Item, in the same order. 0 if not created.
+     * @param[out] results receives the status code of each creation, in the same order.
+     * @param timestamp specification. Can be source, server, both (default), neither, invalid.
+     * @return the number of Monitored Items created.
+     * @see MonitoredItemDataChange
+     */
+    size_t addMonitorNodeIds(
+        monitorItemFunc               func,
+        const std::vector<NodeId>&    nodes,
+        std::vector<unsigned>&        ids,
+        std::vector<UA_StatusCode>&   results,
+        UA_TimestampsToReturn         timestamp = UA_TIMESTAMPSTORETURN_BOTH) {
+        return addMonitorNodeIds(func, nodes, m_profile, ids, results, timestamp);
+    }
+
+    /**
+     * Add a set of nodes as monitored items sharing the same monitoring parameters.
+     * @see addMonitorNodeIds() above.
+     * @param profile sampling, queue and filter parameters of the items.
+     */
+    size_t addMonitorNodeIds(
+        monitorItemFunc               func,
+        const std::vector<NodeId>&    nodes,
+        const DataChangeProfile&      profile,
+        std::vector<unsigned>&        ids,
+        std::vector<UA_StatusCode>&   results,
+        UA_TimestampsToReturn         timestamp = UA_TIMESTAMPSTORETURN_BOTH);
+
     /**
      * Add an event to trigger upon a given node's data changing.
      * @param func a functor to handle event
@@ -0,0 +1,163 @@
+/*
+* Copyright (C) 2017 -  B. J. Hill
+*
+* This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+* redistribute it and/or modify it under the terms of the Mozilla Public
+* License v2.0 as stated in the LICENSE file provided with open62541.
+*
+* open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+* A PARTICULAR PURPOSE.
+*/
+#ifndef CLIENTVALUECACHE_H
+#define CLIENTVALUECACHE_H
+
+#ifndef OPEN62541CLIENT_H
+#include <open62541cpp/open62541client.h>
+#endif
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+
+namespace Open62541 {
+
+/**
+ * The ClientValueCache class
+ * Local copy of the values of subscribed nodes, kept current by data change monitored items.
+ * Reads through the cache return the local value when it is recent enough,
+ * and fall back to a Read service call otherwise, refreshing the local value
+ * unless a notification brought a newer one meanwhile, by source then server timestamp.
+ * The age of a value is the time since its last notification or refresh:
+ * a node whose value doesn't change ages even though its value is still current.
+ * Thread-safe: the notifications update the cache while other threads read it.
+ */
+class ClientValueCache {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /** Hit and miss counters */
+    struct Stats {
+        uint64_t hits          = 0; /**< values served from the cache */
+        uint64_t misses        = 0; /**< values read from the server */
+        uint64_t notifications = 0; /**< values updated by the monitored items */
+    };
+
+private:
+    /** Cached value of a subscribed node. Owns its node id and value */
+    struct Entry {
+        UA_NodeId           node;
+        UA_DataValue        value;
+        Clock::time_point   updated;
+        bool                valid   = false;    /**< false until the first notification or refresh */
+        unsigned            itemKey = 0;        /**< key of the monitored item in the subscription */
+
+        explicit Entry(const UA_NodeId& n) {
+            UA_NodeId_copy(&n, &node);
+            UA_DataValue_init(&value);
+        }
+        ~Entry() {
+            UA_DataValue_clear(&value);
+            UA_NodeId_clear(&node);
+        }
+        Entry(const Entry&) = delete;
+        Entry& operator=(const Entry&) = delete;
+    };
+
+    typedef std::shared_ptr<Entry> EntryRef;
+    // keyed by a shallow copy of the entry node id
+    typedef std::unordered_map<UA_NodeId, EntryRef, NodeIdHash, NodeIdEqual> EntryMap;
+
+    ClientSubscription& m_sub;              /**< subscription owning the monitored items */
+    mutable std::mutex  m_mutex;            /**< guards the entries and the counters */
+    EntryMap            m_entries;
+    Stats               m_stats;
+
+    void update(Entry& entry, UA_DataValue* value);
+    void refresh(const UA_NodeId& node, const UA_DataValue& value);
+    bool lookup(const UA_NodeId& node, std::chrono::milliseconds maxAge, UA_DataValue& out);
+
+public:
+    /** maxAge accepting any cached value, however old */
+    static constexpr std::chrono::milliseconds AnyAge = std::chrono::milliseconds::max();
+
+    /**
+     * Constructor
+     * @param sub the subscription receiving the data changes. Must outlive the cache.
+     */
+    ClientValueCache(ClientSubscription& sub) : m_sub(sub) {}
+
+    /**
+     * Destructor. Deletes the monitored items of the cached nodes.
+     */
+    virtual ~ClientValueCache();
+
+    ClientValueCache(const ClientValueCache&) = delete;
+    ClientValueCache& operator=(const ClientValueCache&) = delete;
+
+    ClientSubscription& subscription() { return m_sub; }
+
+    /**
+     * Cache the value of a node, monitoring it with the subscription data change profile.
+     * @param node the variable node to cache.
+     * @return true on success, or if the node is already cached.
+     */
+    bool add(const NodeId& node);
+
+    /**
+     * Cache the value of many nodes, with as few CreateMonitoredItems requests as possible.
+     * @param nodes the variable nodes to cache.
+     * @return the number of nodes added.
+     */
+    size_t add(const std::vector<NodeId>& nodes);
+
+    /**
+     * Stop caching the value of a node and delete its monitored item.
+     * @param node the node to forget.
+     * @return false if the node wasn't cached.
+     */
+    bool remove(const NodeId& node);
+
+    /**
+     * @param node the node to test.
+     * @return true if the node value is cached.
+     */
+    bool contains(const UA_NodeId& node) const;
+
+    /**
+     * Forget the cached values, for example after a reconnection.
+     * The nodes stay monitored: the next notifications or reads fill the cache again.
+     */
+    void invalidate();
+
+    /**
+     * Read the value of a node, from the cache if it is recent enough.
+     * @param node the variable node to read.
+     * @param[out] outValue the value of the node.
+     * @param maxAge oldest acceptable cached value. 0 always reads from the server.
+     * @return true on success.
+     */
+    bool readValue(const UA_NodeId& node, Variant& outValue, std::chrono::milliseconds maxAge);
+
+    /**
+     * Read the values of many nodes, from the cache if they are recent enough.
+     * The other values are read with as few Read service calls as possible.
+     * @param nodes the variable nodes to read.
+     * @param[out] results receives one data value per node, in the same order.
+     *             Check each value status for the per node result.
+     * @param maxAge oldest acceptable cached value. 0 always reads from the server.
+     * @return true if the reads of the values not cached succeeded.
+     */
+    bool readValues(const std::vector<NodeId>& nodes,
+                    DataValueList& results,
+                    std::chrono::milliseconds maxAge);
+
+    /** @return a snapshot of the counters */
+    Stats stats() const;
+
+    /** Reset the counters */
+    void resetStats();
+};
+
+} // namespace Open62541
+
+#endif // CLIENTVALUECACHE_H
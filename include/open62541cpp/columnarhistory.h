@@ -0,0 +1,148 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef COLUMNARHISTORY_H
+#define COLUMNARHISTORY_H
+
+#include <open62541cpp/historydatabase.h>
+#include <open62541cpp/objects/NodeIdHashMap.h>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+namespace Open62541 {
+
+/**
+ * The ColumnarHistoryBackend class
+ * In memory history storage keeping each node's samples in ring buffers of columns:
+ * time stamps, values and status codes.
+ * Scalar values of a fixed size type (numbers, DateTime, Guid...) are stored inline,
+ * without a Variant per sample. Other values (strings, arrays) are stored as owned Variants.
+ * Samples are kept sorted by time stamp. Once a node holds maxValuesPerNode samples,
+ * the oldest is dropped for each new one.
+ * One time stamp is stored per sample: the source time stamp, else the server time stamp,
+ * else the time of insertion. It is returned as both source and server time stamps.
+ * Implements the low level HistoryRead API, used by UA_HistoryDatabase_default.
+ * Indexes are positions in the node history, 0 being the oldest sample.
+ */
+class ColumnarHistoryBackend : public HistoryDataBackend
+{
+    struct Series; // the columns of a node, defined in columnarhistory.cpp
+
+    typedef std::unordered_map<UA_NodeId, std::unique_ptr<Series>, NodeIdHash, NodeIdEqual> SeriesMap;
+
+    mutable std::mutex  m_mutex;
+    SeriesMap           m_series;               /**< keyed by the series copy of the node id */
+    size_t              m_maxValuesPerNode;
+    UA_DataValue        m_scratch[2];           /**< values returned by getDataValue() */
+    unsigned            m_nextScratch = 0;
+
+    Series* find(const UA_NodeId& node) const;
+    Series& series(const UA_NodeId& node);
+
+public:
+    /**
+     * ColumnarHistoryBackend
+     * @param maxValuesPerNode capacity of the ring buffers, 24h of 1 Hz samples by default.
+     */
+    explicit ColumnarHistoryBackend(size_t maxValuesPerNode = 86400);
+    ~ColumnarHistoryBackend() override;
+    ColumnarHistoryBackend(const ColumnarHistoryBackend&) = delete;
+    ColumnarHistoryBackend& operator=(const ColumnarHistoryBackend&) = delete;
+
+    size_t maxValuesPerNode() const { return m_maxValuesPerNode; }
+
+    /** @return the number of samples stored for a node. */
+    size_t size(const UA_NodeId& node) const;
+
+    /** @return the number of nodes with a history. */
+    size_t nodes() const;
+
+    /** @return the memory allocated by the columns, in bytes. */
+    size_t memoryUsage() const;
+
+    /**
+     * Remove the history of a node.
+     * @param node the historized node.
+     */
+    void clear(const UA_NodeId& node);
+
+    // HistoryDataBackend hooks
+    UA_StatusCode serverSetHistoryData(
+        Context&            context,
+        bool                historizing,
+        const UA_DataValue* value) override;
+
+    size_t getDateTimeMatch(
+        Context&            context,
+        const UA_DateTime   timestamp,
+        const MatchStrategy strategy) override;
+
+    size_t getEnd(Context& context) override;
+    size_t lastIndex(Context& context) override;
+    size_t firstIndex(Context& context) override;
+    size_t resultSize(Context& context, size_t startIndex, size_t endIndex) override;
+
+    /**
+     * Materialise the data values of the window [startIndex, endIndex], and only them.
+     * @see HistoryDataBackend::copyDataValues
+     */
+    UA_StatusCode copyDataValues(
+        Context&        context,
+        size_t          startIndex,
+        size_t          endIndex,
+        UA_Boolean      reverse,
+        size_t          valueSize,
+        UA_NumericRange range,
+        UA_Boolean      releaseContinuationPoints,
+        std::string&    in,
+        std::string&    out,
+        size_t*         providedValues,
+        UA_DataValue*   values) override;
+
+    /**
+     * Materialise one data value.
+     * @return a pointer valid until the second next call, null if there is no such sample.
+     */
+    const UA_DataValue* getDataValue(Context& context, size_t index) override;
+
+    UA_Boolean boundSupported(Context& context) override;
+    UA_Boolean timestampsToReturnSupported(Context& context, UA_TimestampsToReturn timestampsToReturn) override;
+
+    UA_StatusCode insertDataValue(Context& context, const UA_DataValue* value) override;
+    UA_StatusCode replaceDataValue(Context& context, const UA_DataValue* value) override;
+    UA_StatusCode updateDataValue(Context& context, const UA_DataValue* value) override;
+    UA_StatusCode removeDataValue(
+        Context&    context,
+        UA_DateTime startTimestamp,
+        UA_DateTime endTimestamp) override;
+};
+
+/**
+ * The ColumnarHistorian class
+ * The default gathering and database over a ColumnarHistoryBackend.
+ * Same usage as MemoryHistorian.
+ */
+class ColumnarHistorian : public Historian
+{
+    ColumnarHistoryBackend m_store;
+
+public:
+    ColumnarHistorian(size_t numberNodes = 100, size_t maxValuesPerNode = 86400);
+    ~ColumnarHistorian() override;
+
+    /** @return the storage of the historized values. */
+    ColumnarHistoryBackend& store() { return m_store; }
+};
+
+} // namespace Open62541
+
+#endif // COLUMNARHISTORY_H
@@ -0,0 +1,158 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef COMPRESSEDHISTORY_H
+#define COMPRESSEDHISTORY_H
+
+#include <open62541cpp/historydatabase.h>
+#include <open62541cpp/objects/NodeIdHashMap.h>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+namespace Open62541 {
+
+/**
+ * The CompressedHistoryBackend class
+ * In memory history storage compressing each node's samples in blocks of samplesPerBlock samples,
+ * as in Facebook's Gorilla time series database:
+ * delta of delta encoded time stamps, values XOR encoded with the previous one,
+ * and run length encoded status codes.
+ * Regular samples of a slowly changing value take a few bits instead of the 20 bytes
+ * of a time stamp, a Double and a status code.
+ * Values must be scalars of at most 8 bytes (Boolean to Double, DateTime, StatusCode),
+ * of a single type per node. Other values are refused.
+ * Samples must come in time order: a sample older than the last one of its node is refused.
+ * Once a node holds more than maxValuesPerNode samples, its oldest block is dropped.
+ * Reads only decode the blocks holding the requested samples, the last decoded block
+ * of each node being kept for the following reads.
+ * One time stamp is stored per sample: the source time stamp, else the server time stamp,
+ * else the time of insertion. It is returned as both source and server time stamps.
+ * Indexes are positions in the node history, 0 being the oldest sample.
+ */
+class CompressedHistoryBackend : public HistoryDataBackend
+{
+    struct Block;   // defined in compressedhistory.cpp
+    struct Series;
+
+    typedef std::unordered_map<UA_NodeId, std::unique_ptr<Series>, NodeIdHash, NodeIdEqual> SeriesMap;
+
+    mutable std::mutex  m_mutex;
+    SeriesMap           m_series;               /**< keyed by the series copy of the node id */
+    size_t              m_samplesPerBlock;
+    size_t              m_maxValuesPerNode;
+    UA_DataValue        m_scratch[2];           /**< values returned by getDataValue() */
+    unsigned            m_nextScratch = 0;
+
+    Series*         find(const UA_NodeId& node) const;
+    Series&         series(const UA_NodeId& node);
+    UA_StatusCode   append(Series& series, const UA_DataValue& value);
+    UA_StatusCode   get(Series& series, size_t index, UA_DataValue& value, const UA_NumericRange& range);
+    size_t          bound(Series& series, UA_DateTime timestamp, bool after);
+
+public:
+    /**
+     * CompressedHistoryBackend
+     * @param samplesPerBlock number of samples compressed together, the unit of decoding.
+     * @param maxValuesPerNode the oldest block of a node is dropped beyond it, 24h of 1 Hz samples by default.
+     */
+    explicit CompressedHistoryBackend(size_t samplesPerBlock = 1024, size_t maxValuesPerNode = 86400);
+    ~CompressedHistoryBackend() override;
+    CompressedHistoryBackend(const CompressedHistoryBackend&) = delete;
+    CompressedHistoryBackend& operator=(const CompressedHistoryBackend&) = delete;
+
+    size_t samplesPerBlock() const  { return m_samplesPerBlock; }
+    size_t maxValuesPerNode() const { return m_maxValuesPerNode; }
+
+    /**
+     * Append a sample of a node, without going through the gathering.
+     * @param node the historized node.
+     * @param value the sample. Its source time stamp, else server time stamp, else now is used.
+     * @return UA_STATUSCODE_GOOD on success,
+     *         UA_STATUSCODE_BADTYPEMISMATCH if the value is not a small scalar of the node type,
+     *         UA_STATUSCODE_BADOUTOFRANGE if the sample is older than the last one.
+     */
+    UA_StatusCode append(const UA_NodeId& node, const UA_DataValue& value);
+
+    /** @return the number of samples stored for a node. */
+    size_t size(const UA_NodeId& node) const;
+
+    /** @return the number of nodes with a history. */
+    size_t nodes() const;
+
+    /** @return the memory allocated by the compressed blocks, in bytes. */
+    size_t memoryUsage() const;
+
+    /**
+     * Remove the history of a node.
+     * @param node the historized node.
+     */
+    void clear(const UA_NodeId& node);
+
+    // HistoryDataBackend hooks
+    UA_StatusCode serverSetHistoryData(
+        Context&            context,
+        bool                historizing,
+        const UA_DataValue* value) override;
+
+    size_t getDateTimeMatch(
+        Context&            context,
+        const UA_DateTime   timestamp,
+        const MatchStrategy strategy) override;
+
+    size_t getEnd(Context& context) override;
+    size_t lastIndex(Context& context) override;
+    size_t firstIndex(Context& context) override;
+    size_t resultSize(Context& context, size_t startIndex, size_t endIndex) override;
+
+    /**
+     * Materialise the data values of the window [startIndex, endIndex],
+     * decoding only the blocks holding them.
+     * @see HistoryDataBackend::copyDataValues
+     */
+    UA_StatusCode copyDataValues(
+        Context&        context,
+        size_t          startIndex,
+        size_t          endIndex,
+        UA_Boolean      reverse,
+        size_t          valueSize,
+        UA_NumericRange range,
+        UA_Boolean      releaseContinuationPoints,
+        std::string&    in,
+        std::string&    out,
+        size_t*         providedValues,
+        UA_DataValue*   values) override;
+
+    /**
+     * Materialise one data value.
+     * @return a pointer valid until the second next call, null if there is no such sample.
+     */
+    const UA_DataValue* getDataValue(Context& context, size_t index) override;
+
+    UA_Boolean boundSupported(Context& context) override;
+    UA_Boolean timestampsToReturnSupported(Context& context, UA_TimestampsToReturn timestampsToReturn) override;
+
+    /** Append only: the sample must not be older than the last one. */
+    UA_StatusCode insertDataValue(Context& context, const UA_DataValue* value) override;
+    /** Append only: the sample must not be older than the last one. */
+    UA_StatusCode updateDataValue(Context& context, const UA_DataValue* value) override;
+    /** Not supported by the compressed blocks. */
+    UA_StatusCode replaceDataValue(Context& context, const UA_DataValue* value) override;
+    /** Not supported by the compressed blocks. */
+    UA_StatusCode removeDataValue(
+        Context&    context,
+        UA_DateTime startTimestamp,
+        UA_DateTime endTimestamp) override;
+};
+
+} // namespace Open62541
+
+#endif // COMPRESSEDHISTORY_H
@@ -0,0 +1,146 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef HISTORYAGGREGATES_H
+#define HISTORYAGGREGATES_H
+
+#include "open62541/types.h"
+#include "open62541/types_generated_handling.h"
+#include <vector>
+
+namespace Open62541 {
+
+/**
+ * The HistoryAggregator class
+ * Computes the standard aggregates of the HistoryReadProcessed service (OPC UA Part 13)
+ * over the raw samples of a node: Interpolative, Average, TimeAverage, Minimum, Maximum,
+ * Count and Delta, for consecutive intervals.
+ * Only the good numeric samples are kept. They are buffered as columns of time stamps and Doubles,
+ * and each full chunk is folded into per interval accumulators: the memory depends on the number
+ * of intervals, not of samples, and the inner loops run over contiguous values without branches.
+ * Simplified against Part 13: bad and uncertain samples are ignored,
+ * interpolations are linear between the bounding good samples,
+ * and an interval without the samples its aggregate needs has the status BadNoData.
+ * @see Historian::enableReadProcessed()
+ */
+class HistoryAggregator
+{
+public:
+    enum Aggregate {
+        Interpolative,  /**< value at the interval start, interpolated */
+        Average,        /**< mean of the samples in the interval */
+        TimeAverage,    /**< time weighted mean of the interpolated curve over the interval */
+        Minimum,
+        Maximum,
+        Count,          /**< number of samples in the interval, an Int32 */
+        Delta           /**< last minus first sample of the interval */
+    };
+
+    /**
+     * Map an aggregate function node (ns=0;i=AggregateFunction_*) to an aggregate.
+     * @param function the aggregate function node id.
+     * @param[out] aggregate receives the aggregate.
+     * @return false if the aggregate is not supported.
+     */
+    static bool aggregate(const UA_NodeId& function, Aggregate& aggregate);
+
+    HistoryAggregator();
+
+    /**
+     * Start a new aggregation, over count intervals [start + i * interval, start + (i + 1) * interval),
+     * the last one ending at end. The samples added before are dropped.
+     */
+    void reset(UA_DateTime start, UA_DateTime end, UA_DateTime interval, size_t count);
+
+    /** @return the number of samples kept since reset() */
+    size_t size() const { return m_samples; }
+
+    /**
+     * Add a sample, after the previous ones.
+     * The samples bounding the time range are needed for the interpolations at its bounds.
+     * @param time the sample time stamp.
+     * @param value kept if it is good and a numeric scalar.
+     * @return true if the sample is kept.
+     */
+    bool add(UA_DateTime time, const UA_DataValue& value);
+
+    /** Add a good sample, after the previous ones: an older sample is ignored. */
+    void add(UA_DateTime time, double value) {
+        if (m_samples && time < m_lastTime) return;
+        m_lastTime          = time;
+        m_times[m_pending]      = time;
+        m_offsets[m_pending]    = double(time - m_start);
+        m_values[m_pending]     = value;
+        m_samples++;
+        if (++m_pending == ChunkSize) fold();
+    }
+
+    /**
+     * Compute an aggregate over the intervals, from the samples added since reset().
+     * @param aggregate the aggregate to compute.
+     * @param[out] values receives the results, one per interval.
+     * @param[out] status receives the status codes, Good or BadNoData.
+     */
+    void compute(Aggregate aggregate, double* values, UA_StatusCode* status);
+
+    /**
+     * Compute an aggregate as data values, time stamped with their interval start.
+     * @param[out] results receives the data values, one per interval, initialised.
+     */
+    void compute(Aggregate aggregate, UA_TimestampsToReturn timestampsToReturn, UA_DataValue* results);
+
+private:
+    static const size_t ChunkSize = 1024;
+
+    /** Accumulators of the samples of an interval */
+    struct Interval {
+        size_t      count       = 0;
+        double      sum         = 0.0;
+        double      minimum     = 0.0;
+        double      maximum     = 0.0;
+        double      area        = 0.0;  /**< under the line through the samples, in value x 100 ns */
+        UA_DateTime firstTime   = 0;
+        UA_DateTime lastTime    = 0;
+        double      first       = 0.0;
+        double      last        = 0.0;
+    };
+
+    /** Value at an interval bound, interpolated between the samples around it */
+    struct Bound {
+        double      value       = 0.0;
+        bool        known       = false;
+    };
+
+    UA_DateTime                 m_start     = 0;
+    UA_DateTime                 m_end       = 0;
+    UA_DateTime                 m_interval  = 1;
+    std::vector<Interval>       m_intervals;
+    std::vector<Bound>          m_bounds;       /**< the interval starts, then end */
+    size_t                      m_nextBound = 0;
+    size_t                      m_samples   = 0;
+
+    std::vector<UA_DateTime>    m_times;        /**< chunk waiting to be folded, in time order */
+    std::vector<double>         m_offsets;      /**< the times from start, for the vectorised area */
+    std::vector<double>         m_values;
+    size_t                      m_pending   = 0;
+    UA_DateTime                 m_lastTime  = 0;        /**< of the last sample kept */
+    UA_DateTime                 m_previousTime  = 0;    /**< last sample of the folded chunks */
+    double                      m_previousValue = 0.0;
+
+    UA_DateTime boundTime(size_t i) const {
+        return i < m_intervals.size() ? m_start + UA_DateTime(i) * m_interval : m_end;
+    }
+    void fold();
+};
+
+} // namespace Open62541
+
+#endif // HISTORYAGGREGATES_H
@@ -19,9 +19,13 @@
 #include "open62541/plugin/historydata/history_data_backend_memory.h"
 #include "open62541/plugin/historydata/history_data_backend_sqlite.h"
 #include <open62541cpp/open62541server.h>
+#include <memory>
 
 namespace Open62541 {
 
+class CompressedHistoryBackend;  // compressedhistory.h
+class WriteBehindHistoryBackend; // writebehindhistory.h
+
 /**
  * The HistoryDataGathering class
  * Wrap the Historian classes in C++
@@ -254,7 +258,7 @@ public:
          * Call back context common to most call backs.
          * move common bits into one structure so we can simplify calls and maybe do extra magic
          * @param pServer
-         * @param pSessionId
+         * @param pSessionId null when the value comes from polling, giving a null sessionId.
          * @param pSessionContext
          * @param pNode
          */
@@ -264,7 +268,7 @@ public:
             void*            pSessionContext,
             const UA_NodeId* pNode)
             : server(*Server::findServer(pServer))
-            , sessionId(*pNodeSession)
+            , sessionId(pNodeSession ? NodeId(*pNodeSession) : NodeId())
             , sessionContext(pSessionContext)
             , nodeId(*pNode) {}
     }; // HistoryDataBackend::Context class
@@ -1005,6 +1009,27 @@ class HistoryDatabase
         const UA_HistoryReadValueId*    nodesToRead,
         UA_HistoryReadResponse*         response,
         UA_HistoryData* const* const    historyData);
+
+    /**
+     * Call-back called if a history read of processed (aggregated) values is requested.
+     * Setting it to NULL will result in a response with status
+     * code UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED.
+     * Same parameters as _readRaw(), historyReadDetails giving the aggregates,
+     * one per node, and the processing interval.
+     */
+    static void _readProcessed(
+        UA_Server*                      server,
+        void*                           hdbContext,
+        const UA_NodeId*                sessionId,
+        void*                           sessionContext,
+        const UA_RequestHeader*         requestHeader,
+        const UA_ReadProcessedDetails*  historyReadDetails,
+        UA_TimestampsToReturn           timestampsToReturn,
+        UA_Boolean                      releaseContinuationPoints,
+        size_t                          nodesToReadSize,
+        const UA_HistoryReadValueId*    nodesToRead,
+        UA_HistoryReadResponse*         response,
+        UA_HistoryData* const* const    historyData);
     
     /**
      * Call-back called when a nodes value is updated.
@@ -1114,6 +1139,25 @@ public:
         UA_HistoryData* const* const    historyData)
     {
     }
+
+    /**
+     * Hook called if a history read of processed (aggregated) values is requested.
+     * Do nothing by default.
+     * Same parameters as readRaw(), historyReadDetails giving the aggregates,
+     * one per node, and the processing interval.
+     */
+    virtual void readProcessed(
+        Context&                        context,
+        const UA_RequestHeader*         requestHeader,
+        const UA_ReadProcessedDetails*  historyReadDetails,
+        UA_TimestampsToReturn           timestampsToReturn,
+        UA_Boolean                      releaseContinuationPoints,
+        size_t                          nodesToReadSize,
+        const UA_HistoryReadValueId*    nodesToRead,
+        UA_HistoryReadResponse*         response,
+        UA_HistoryData* const* const    historyData)
+    {
+    }
     
     /**
      * Hook called when a nodes value is updated.
@@ -1158,7 +1202,7 @@ public:
     }
 
     /*  Add more function pointer here.
-        For example for read_event, read_modified, read_processed, read_at_time */
+        For example for read_event, read_modified, read_at_time */
 };
 
 /**
@@ -1187,6 +1231,7 @@ public:
      * @param responseSize
      * @param pollInterval duration between 2 data polling in ms. 1s by default.
      * @param context
+     * @param compressed true to store the values in compressedStore() instead of backend().
      * @return true on success
      */
     bool setUpdateNode(
@@ -1194,7 +1239,8 @@ public:
         Server& server,
         size_t  responseSize = 100,
         size_t  pollInterval = 1000,
-        void*   context      = nullptr);
+        void*   context      = nullptr,
+        bool    compressed   = false);
     
     /**
      * Registers a node for the gathering of historical data.
@@ -1206,6 +1252,7 @@ public:
      * @param responseSize
      * @param pollInterval duration between 2 data polling in ms. 1s by default.
      * @param context
+     * @param compressed true to store the values in compressedStore() instead of backend().
      * @return true on success
      */
     bool setPollNode(
@@ -1213,7 +1260,8 @@ public:
         Server& server,
         size_t  responseSize = 100,
         size_t  pollInterval = 1000,
-        void*   context      = nullptr);
+        void*   context      = nullptr,
+        bool    compressed   = false);
     
     /**
      * Registers a node for the gathering of historical data.
@@ -1233,10 +1281,84 @@ public:
         size_t  pollInterval = 1000,
         void*   context      = nullptr);
 
+    /**
+     * The storage of the nodes registered with compressed set,
+     * created on first call: the parameters of the later calls are ignored.
+     * Values must be scalars of at most 8 bytes, in time order.
+     * @param samplesPerBlock number of samples compressed together.
+     * @param maxValuesPerNode the oldest samples of a node are dropped beyond it.
+     * @see CompressedHistoryBackend
+     */
+    CompressedHistoryBackend& compressedStore(size_t samplesPerBlock = 1024, size_t maxValuesPerNode = 86400);
+
+    /** @return the write-behind stage in front of backend(), null if not enabled. */
+    WriteBehindHistoryBackend* writeBehind() { return m_writeBehind.get(); }
+
+protected:
+    /**
+     * Put a write-behind stage in front of backend(): the values are stored
+     * by a background thread, out of the write service.
+     * Call it in the constructor, once backend() is set and before any node is registered.
+     * A backend member of the derived class is destroyed before the stage: the derived
+     * destructor must stop it first with releaseStore().
+     * @param flushInterval maximum time in ms a value waits before being stored.
+     * @param maxQueued maximum number of values waiting, stored in place beyond it.
+     * @see WriteBehindHistoryBackend
+     */
+    void enableWriteBehind(unsigned flushInterval, size_t maxQueued);
+
+    /**
+     * Detach backend() from a store member of the derived class, destroyed before ~Historian().
+     * Call it first in the derived destructor. A write-behind stage is stopped:
+     * its pending values are inserted and the store is released, while it still exists.
+     */
+    void releaseStore();
+
+    /**
+     * Serve the HistoryReadProcessed service from the backends of the nodes:
+     * the aggregates Interpolative, Average, TimeAverage, Minimum, Maximum, Count and Delta
+     * are computed from the raw values, as Doubles (Count as Int32).
+     * Call it in the constructor, once database() is set to the default database.
+     * The whole result is returned at once, without continuation point.
+     * @see HistoryAggregator
+     */
+    void enableReadProcessed();
+
 private:
     UA_HistoryDatabase m_database;
     UA_HistoryDataBackend m_backend;
     UA_HistoryDataGathering m_gathering;
+    std::unique_ptr<CompressedHistoryBackend> m_compressed;
+    std::unique_ptr<WriteBehindHistoryBackend> m_writeBehind;
+
+    /** @return the backend of a node registered with the given compression option */
+    UA_HistoryDataBackend& nodeBackend(bool compressed);
+
+    /** database() call-back: finds the historian of the database context */
+    static void _readProcessed(
+        UA_Server*                      server,
+        void*                           hdbContext,
+        const UA_NodeId*                sessionId,
+        void*                           sessionContext,
+        const UA_RequestHeader*         requestHeader,
+        const UA_ReadProcessedDetails*  historyReadDetails,
+        UA_TimestampsToReturn           timestampsToReturn,
+        UA_Boolean                      releaseContinuationPoints,
+        size_t                          nodesToReadSize,
+        const UA_HistoryReadValueId*    nodesToRead,
+        UA_HistoryReadResponse*         response,
+        UA_HistoryData* const* const    historyData);
+
+    void readProcessed(
+        UA_Server*                      server,
+        const UA_NodeId*                sessionId,
+        void*                           sessionContext,
+        const UA_ReadProcessedDetails*  historyReadDetails,
+        UA_TimestampsToReturn           timestampsToReturn,
+        size_t                          nodesToReadSize,
+        const UA_HistoryReadValueId*    nodesToRead,
+        UA_HistoryReadResponse*         response,
+        UA_HistoryData* const* const    historyData);
 };
 
 /**
@@ -1257,14 +1379,24 @@ public:
  * maximum number of values per node is exceeded.
  * Pruning old values is only done every pruneInterval times a new value is added.
  * This can be used for improving performance, with a slight cost in storage space.
+ * With a flushInterval, the values are inserted by a background thread,
+ * keeping the disk latency out of the write service.
+ * The C plug-in inserts each value in its own transaction: SQLiteHistorian batches them.
  */
 class SQLiteHistorianCyclicBuffered : public Historian
 {
 public:
+    /**
+     * @param flushInterval maximum time in ms a value waits before being inserted,
+     *        0 to insert it in the write service.
+     * @param maxQueued maximum number of values waiting, inserted in place beyond it.
+     */
     SQLiteHistorianCyclicBuffered(const char* dbFileName,
                                   size_t numberNodes,
                                   size_t maxValuesPerNode,
-                                  size_t pruneInterval);
+                                  size_t pruneInterval,
+                                  unsigned flushInterval = 0,
+                                  size_t maxQueued = 65536);
     ~SQLiteHistorianCyclicBuffered() override = default;
 };
 
@@ -1274,14 +1406,24 @@ public:
  * time window buffer. New entries are always added, old entries are removed 
  * Pruning old values is only done every pruneInterval times a new value is added.
  * This can be used for improving performance, with a slight cost in storage space.
+ * With a flushInterval, the values are inserted by a background thread,
+ * keeping the disk latency out of the write service.
+ * The C plug-in inserts each value in its own transaction: SQLiteHistorian batches them.
  */
 class SQLiteHistorianTimeBuffered : public Historian
 {
 public:
+    /**
+     * @param flushInterval maximum time in ms a value waits before being inserted,
+     *        0 to insert it in the write service.
+     * @param maxQueued maximum number of values waiting, inserted in place beyond it.
+     */
     SQLiteHistorianTimeBuffered(const char* dbFileName,
                                size_t numberNodes,
                                UA_DateTime maxBufferedTimeSec,
-                               size_t pruneInterval);
+                               size_t pruneInterval,
+                               unsigned flushInterval = 0,
+                               size_t maxQueued = 65536);
     ~SQLiteHistorianTimeBuffered() override = default;
 };
 
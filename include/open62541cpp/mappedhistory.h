@@ -0,0 +1,180 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef MAPPEDHISTORY_H
+#define MAPPEDHISTORY_H
+
+#include <open62541cpp/historydatabase.h>
+#include <open62541cpp/objects/NodeIdHashMap.h>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <list>
+
+namespace Open62541 {
+
+/**
+ * The MappedHistoryBackend class
+ * Persistent, append only history storage in memory mapped files.
+ * Each node's samples are appended as fixed size records to segment files of
+ * recordsPerSegment records, named <directory>/<node key>.<sequence>.seg.
+ * A record holds the time stamp, the status code and a scalar value of at most 8 bytes
+ * (Boolean to Double, DateTime, StatusCode). Other values are refused.
+ * Samples must come in time order: a sample older than the last one of its node is refused.
+ * Each record carries a checksum. On restart, only the last segment of a node is scanned,
+ * up to its first invalid record, the previous ones being full.
+ * A sparse index of the time stamps of each segment narrows the binary searches.
+ * Reads are served from the mapped segments, the least recently used ones being unmapped
+ * beyond maxMappedSegments. The last segment of each node stays mapped.
+ * The directory must exist.
+ */
+class MappedHistoryBackend : public HistoryDataBackend
+{
+    struct Record;  // defined in mappedhistory.cpp
+    struct Segment;
+    struct Series;
+
+    typedef std::unordered_map<UA_NodeId, std::unique_ptr<Series>, NodeIdHash, NodeIdEqual> SeriesMap;
+
+    mutable std::mutex  m_mutex;
+    SeriesMap           m_series;               /**< keyed by the series copy of the node id */
+    std::string         m_directory;
+    size_t              m_recordsPerSegment;
+    size_t              m_maxSegmentsPerNode;   /**< 0 for no limit */
+    size_t              m_maxMappedSegments;
+    std::list<Segment*> m_mapped;               /**< mapped full segments, most recently used first */
+    UA_DataValue        m_scratch[2];           /**< values returned by getDataValue() */
+    unsigned            m_nextScratch = 0;
+
+    Series*         find(const UA_NodeId& node);
+    Series&         series(const UA_NodeId& node);
+    void            map(Segment& segment, bool pinned = false);
+    void            track(Segment& segment);
+    void            dropOldestSegment(Series& series);
+    UA_StatusCode   append(Series& series, const UA_DataValue& value);
+    const Record*   record(Series& series, size_t index);
+    size_t          bound(Series& series, UA_DateTime timestamp, bool after);
+
+public:
+    static const size_t RecordSize = 32; /**< bytes per sample in the segment files */
+
+    /**
+     * MappedHistoryBackend
+     * @param directory of the segment files, created by the caller.
+     * @param recordsPerSegment number of samples per segment file, 2 MiB files by default.
+     * @param maxSegmentsPerNode the oldest segment file of a node is deleted beyond it, 0 for no limit.
+     * @param maxMappedSegments number of full segments kept mapped for reading.
+     */
+    MappedHistoryBackend(
+        const std::string&  directory,
+        size_t              recordsPerSegment   = 65536,
+        size_t              maxSegmentsPerNode  = 0,
+        size_t              maxMappedSegments   = 1024);
+    ~MappedHistoryBackend() override;
+    MappedHistoryBackend(const MappedHistoryBackend&) = delete;
+    MappedHistoryBackend& operator=(const MappedHistoryBackend&) = delete;
+
+    const std::string& directory() const { return m_directory; }
+
+    /**
+     * Append a sample of a node, without going through the gathering.
+     * @param node the historized node.
+     * @param value the sample. Its source time stamp, else server time stamp, else now is used.
+     * @return UA_STATUSCODE_GOOD on success,
+     *         UA_STATUSCODE_BADTYPEMISMATCH if the value does not fit in a record,
+     *         UA_STATUSCODE_BADOUTOFRANGE if the sample is older than the last one.
+     */
+    UA_StatusCode append(const UA_NodeId& node, const UA_DataValue& value);
+
+    /** @return the number of samples stored for a node, loading its segments if needed. */
+    size_t size(const UA_NodeId& node);
+
+    /**
+     * Write the mapped segments to disk and wait for it.
+     * The mapped pages survive a crash of the process, not of the system.
+     */
+    void flush();
+
+    // HistoryDataBackend hooks
+    UA_StatusCode serverSetHistoryData(
+        Context&            context,
+        bool                historizing,
+        const UA_DataValue* value) override;
+
+    size_t getDateTimeMatch(
+        Context&            context,
+        const UA_DateTime   timestamp,
+        const MatchStrategy strategy) override;
+
+    size_t getEnd(Context& context) override;
+    size_t lastIndex(Context& context) override;
+    size_t firstIndex(Context& context) override;
+    size_t resultSize(Context& context, size_t startIndex, size_t endIndex) override;
+
+    UA_StatusCode copyDataValues(
+        Context&        context,
+        size_t          startIndex,
+        size_t          endIndex,
+        UA_Boolean      reverse,
+        size_t          valueSize,
+        UA_NumericRange range,
+        UA_Boolean      releaseContinuationPoints,
+        std::string&    in,
+        std::string&    out,
+        size_t*         providedValues,
+        UA_DataValue*   values) override;
+
+    /**
+     * Materialise one data value.
+     * @return a pointer valid until the second next call, null if there is no such sample.
+     */
+    const UA_DataValue* getDataValue(Context& context, size_t index) override;
+
+    UA_Boolean boundSupported(Context& context) override;
+    UA_Boolean timestampsToReturnSupported(Context& context, UA_TimestampsToReturn timestampsToReturn) override;
+
+    /** Append only: the sample must not be older than the last one. */
+    UA_StatusCode insertDataValue(Context& context, const UA_DataValue* value) override;
+    /** Append only: the sample must not be older than the last one. */
+    UA_StatusCode updateDataValue(Context& context, const UA_DataValue* value) override;
+    /** Not supported by an append only storage. */
+    UA_StatusCode replaceDataValue(Context& context, const UA_DataValue* value) override;
+    /** Not supported by an append only storage. */
+    UA_StatusCode removeDataValue(
+        Context&    context,
+        UA_DateTime startTimestamp,
+        UA_DateTime endTimestamp) override;
+};
+
+/**
+ * The MappedHistorian class
+ * The default gathering and database over a MappedHistoryBackend.
+ * Same usage as SQLiteHistorianCyclicBuffered.
+ */
+class MappedHistorian : public Historian
+{
+    MappedHistoryBackend m_store;
+
+public:
+    MappedHistorian(
+        const std::string&  directory,
+        size_t              numberNodes         = 100,
+        size_t              recordsPerSegment   = 65536,
+        size_t              maxSegmentsPerNode  = 0);
+    ~MappedHistorian() override;
+
+    /** @return the storage of the historized values. */
+    MappedHistoryBackend& store() { return m_store; }
+};
+
+} // namespace Open62541
+
+#endif // MAPPEDHISTORY_H
@@ -27,6 +27,7 @@
 namespace Open62541 {
 
 class ClientSubscription;
+struct DispatchTarget;
 
 /**
  * This is a single monitored event.
@@ -39,6 +40,7 @@ class ClientSubscription;
  */
 class MonitoredItem {
     ClientSubscription&         m_sub; // parent subscription
+    std::shared_ptr<DispatchTarget> m_dispatchTarget; // link with the queued notifications, if dispatched
 
 protected:
     MonitoredItemCreateResult   m_response;  // response
@@ -110,7 +112,7 @@ public:
     /**
      * Destructor. Cancel the subscription.
      */
-    virtual ~MonitoredItem()            { remove(); }
+    virtual ~MonitoredItem();
 
     /**
      * @return last error code
@@ -128,7 +130,8 @@ public:
     ClientSubscription& subscription()  { return m_sub;} // parent subscription
 
     /**
-     * Cancel the subscription
+     * Cancel the subscription.
+     * The notifications still queued in a dispatcher are dropped.
      * @return true on success
      */
     virtual bool remove();
@@ -191,6 +194,65 @@ protected:
 /** Call-back triggered when the monitored item's data changes. */
 typedef std::function<void(ClientSubscription&, UA_DataValue*)> monitorItemFunc;
 
+/**
+ * The DataChangeProfile struct
+ * Monitoring parameters requested for data change items.
+ * Can be set for a whole subscription or given per item.
+ * The defaults match UA_MonitoredItemCreateRequest_default().
+ * A deadband only reports the changes larger than deadbandValue:
+ * in the variable unit for an absolute deadband,
+ * or in percent of its EURange property for a percent deadband (the server must expose it).
+ */
+struct DataChangeProfile {
+    UA_Double               samplingInterval    = 250.0;    /**< in ms, 0 for the fastest rate, -1 for the publishing interval */
+    UA_UInt32               queueSize           = 1;        /**< values kept by the server between two publications */
+    bool                    discardOldest       = true;     /**< which value to drop when the queue is full */
+    UA_MonitoringMode       monitoringMode      = UA_MONITORINGMODE_REPORTING;
+    UA_DataChangeTrigger    trigger             = UA_DATACHANGETRIGGER_STATUSVALUE;
+    UA_DeadbandType         deadbandType        = UA_DEADBANDTYPE_NONE;
+    UA_Double               deadbandValue       = 0.0;
+
+    /** @return true if a DataChangeFilter must be sent with the request */
+    bool hasFilter() const {
+        return deadbandType != UA_DEADBANDTYPE_NONE || trigger != UA_DATACHANGETRIGGER_STATUSVALUE;
+    }
+
+    /**
+     * Apply the profile to a monitored item creation request.
+     * @param[in,out] request to modify.
+     * @param[out] filter storage of the data change filter referenced by the request, if any.
+     *             Must outlive the request, which doesn't own it.
+     */
+    void apply(UA_MonitoredItemCreateRequest& request, UA_DataChangeFilter& filter) const;
+
+    /**
+     * A profile reporting only the changes larger than an absolute value.
+     * @param deadband minimum change, in the variable unit.
+     * @param samplingInterval in ms.
+     * @param queueSize values kept by the server between two publications.
+     */
+    static DataChangeProfile absoluteDeadband(UA_Double deadband, UA_Double samplingInterval = 250.0, UA_UInt32 queueSize = 1) {
+        DataChangeProfile p;
+        p.samplingInterval  = samplingInterval;
+        p.queueSize         = queueSize;
+        p.deadbandType      = UA_DEADBANDTYPE_ABSOLUTE;
+        p.deadbandValue     = deadband;
+        return p;
+    }
+
+    /**
+     * A profile reporting only the changes larger than a percentage of the variable EURange.
+     * @param percent minimum change, from 0 to 100.
+     * @param samplingInterval in ms.
+     * @param queueSize values kept by the server between two publications.
+     */
+    static DataChangeProfile percentDeadband(UA_Double percent, UA_Double samplingInterval = 250.0, UA_UInt32 queueSize = 1) {
+        DataChangeProfile p = absoluteDeadband(percent, samplingInterval, queueSize);
+        p.deadbandType = UA_DEADBANDTYPE_PERCENT;
+        return p;
+    }
+};
+
 /**
  * The MonitoredItemDataChange class
  * Handles value change notifications
@@ -232,7 +294,7 @@ public:
     }
 
     /**
-     * Add this DataChange notification to a given node.
+     * Add this DataChange notification to a given node, with the subscription data change profile.
      * @param node id of the monitored node.
      * @param timestamp specification. Can be source, server, both (default), neither, invalid.
      * @return true on success
@@ -240,6 +302,36 @@ public:
     bool addDataChange(
         NodeId&               node,
         UA_TimestampsToReturn timestamp = UA_TIMESTAMPSTORETURN_BOTH);
+
+    /**
+     * Add this DataChange notification to a given node.
+     * @param node id of the monitored node.
+     * @param profile sampling, queue and filter parameters of the item.
+     * @param timestamp specification. Can be source, server, both (default), neither, invalid.
+     * @return true on success
+     */
+    bool addDataChange(
+        NodeId&                     node,
+        const DataChangeProfile&    profile,
+        UA_TimestampsToReturn       timestamp = UA_TIMESTAMPSTORETURN_BOTH);
+
+    /**
+     * Add a set of DataChange notifications to the same subscription,
+     * with as few CreateMonitoredItems requests as possible.
+     * Each item gets the result of its own creation: check its lastError().
+     * @param items the items to create, all owned by the same subscription.
+     * @param nodes id of the node monitored by each item, in the same order.
+     * @param profile sampling, queue and filter parameters of all the items.
+     * @param maxPerCall maximum number of items per request, 0 for no limit.
+     * @param timestamp specification. Can be source, server, both (default), neither, invalid.
+     * @return the number of items created.
+     */
+    static size_t addDataChanges(
+        const std::vector<MonitoredItemDataChange*>& items,
+        const std::vector<NodeId>&                   nodes,
+        const DataChangeProfile&                     profile,
+        size_t                                       maxPerCall = 0,
+        UA_TimestampsToReturn                        timestamp  = UA_TIMESTAMPSTORETURN_BOTH);
 };
 
 /** Call-back handling event notifications */
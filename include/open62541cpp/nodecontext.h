@@ -14,6 +14,7 @@
 #define NODECONTEXT_H
 #include <open62541cpp/open62541objects.h>
 #include <open62541cpp/objects/NodeId.h>
+#include <open62541cpp/objects/NodeIdRef.h>
 
 namespace Open62541 {
     /**
@@ -36,6 +37,31 @@ public:
     typedef std::function<bool(Server&, NodeId&, const UA_NumericRange*, const UA_DataValue&)> ConstDataFunc;
     typedef std::function<void(Server&, NodeId&, const UA_NumericRange*, const UA_DataValue&)> ConstValueFunc;
 
+    // Same functors receiving a view of the node id, which avoids copying it on each call
+    typedef std::function<bool(Server&, NodeIdRef, const UA_NumericRange*, UA_DataValue&)> DataRefFunc;
+    typedef std::function<void(Server&, NodeIdRef, const UA_NumericRange*, const UA_DataValue*)> ValueRefFunc;
+    typedef std::function<bool(Server&, NodeIdRef, const UA_NumericRange*, const UA_DataValue&)> ConstDataRefFunc;
+    typedef std::function<void(Server&, NodeIdRef, const UA_NumericRange*, const UA_DataValue&)> ConstValueRefFunc;
+
+    /** Read cache counters of a node */
+    struct ReadCacheStats {
+        uint64_t hits      = 0; /**< reads answered from the cache */
+        uint64_t misses    = 0; /**< reads of the data source */
+        uint64_t coalesced = 0; /**< reads waiting for the data source read of another session */
+
+        /** @return the share of the reads not reaching the data source */
+        double hitRatio() const {
+            const uint64_t total = hits + misses + coalesced;
+            return total ? double(hits + coalesced) / double(total) : 0.0;
+        }
+    };
+
+private:
+    struct ReadCache;
+    std::shared_ptr<ReadCache>  m_readCache;          /**< last values of the data source nodes, null if disabled */
+
+    bool readDataCached(Server& server, NodeIdRef node, UA_DataValue& value);
+
 protected:
     UA_StatusCode               _lastError;
     // Functor read write interface
@@ -43,10 +69,14 @@ protected:
     ConstDataFunc               _writeData;
     ValueFunc                   _readValue;
     ConstValueFunc              _writeValue;
+    DataRefFunc                 _readDataRef;
+    ConstDataRefFunc            _writeDataRef;
+    ValueRefFunc                _readValueRef;
+    ConstValueRefFunc           _writeValueRef;
 
 public:
     NodeContext(const std::string& name = "") : m_name(name) {}
-    virtual ~NodeContext()                                   {}
+    virtual ~NodeContext();
 
 
 
@@ -82,6 +112,34 @@ public:
         // Value read/write node
     }
 
+    /*!
+     * \brief NodeContext
+     * \param s
+     * \param read
+     * \param write
+     */
+    NodeContext(DataRefFunc read, ConstDataRefFunc write, const std::string& s = "")
+        : m_name(s)
+        , _readDataRef(read)
+        , _writeDataRef(write)
+    {
+        // Data read write node, without node id copies
+    }
+
+    /*!
+     * \brief NodeContext
+     * \param s
+     * \param read
+     * \param write
+     */
+    NodeContext(ValueRefFunc read, ConstValueRefFunc write, const std::string& s = "")
+        : m_name(s)
+        , _readValueRef(read)
+        , _writeValueRef(write)
+    {
+        // Value read/write node, without node id copies
+    }
+
     /**
      * Overridable hook to specialize the node constructor of an object type in a given server.
      * Called by the Server::constructor() call-back.
@@ -96,6 +154,10 @@ public:
     void setWriteData(ConstDataFunc f)     { _writeData = f; }
     void setReadValue(ValueFunc f)         { _readValue = f; }
     void setWriteValue(ConstValueFunc f)   { _writeValue = f; }
+    void setReadData(DataRefFunc f)        { _readDataRef = f; }
+    void setWriteData(ConstDataRefFunc f)  { _writeDataRef = f; }
+    void setReadValue(ValueRefFunc f)      { _readValueRef = f; }
+    void setWriteValue(ConstValueRefFunc f){ _writeValueRef = f; }
 
     /*!
         \brief lastError
@@ -115,6 +177,13 @@ public:
         \return
     */
 
+    /**
+     * Drop the read cache entry of a node, counters included.
+     * Called by the Server::destructor() call-back, the entries of deleted nodes don't pile up.
+     * @param node the deleted data source node.
+     */
+    void forgetReadCache(const UA_NodeId& node);
+
     /**
      * Overridable hook to specialize the node destructor of an object type in a given server.
      * Called by the Server::destructor() call-back.
@@ -165,6 +234,21 @@ public:
      */
     virtual bool typeConstruct(Server& /*server*/, NodeId& /*n*/, NodeId& /*t*/) { return true; }
 
+    /**
+     * Hook called by typeConstructor, receiving views of the node ids.
+     * By default, copies the node ids and calls the NodeId version.
+     * Override this one instead to avoid the copies.
+     * @param server of the node
+     * @param node specify the node to create
+     * @param type specify the node storing the type of the node
+     * @return true on success
+     */
+    virtual bool typeConstructRef(Server& server, NodeIdRef node, NodeIdRef type) {
+        NodeId n = node.get();
+        NodeId t = type.get();
+        return typeConstruct(server, n, t);
+    }
+
     /* Can be NULL. May replace the nodeContext. */
     /*!
      * \brief typeDestructor
@@ -196,6 +280,20 @@ public:
     virtual void typeDestruct(Server& server, NodeId& node, NodeId& type) {
     }
 
+    /**
+     * Hook called by typeDestructor, receiving views of the node ids.
+     * By default, copies the node ids and calls the NodeId version.
+     * Override this one instead to avoid the copies.
+     * @param server of the node
+     * @param node specify the node to destroy
+     * @param type specify the node storing the type of the node
+     */
+    virtual void typeDestructRef(Server& server, NodeIdRef node, NodeIdRef type) {
+        NodeId n = node.get();
+        NodeId t = type.get();
+        typeDestruct(server, n, t);
+    }
+
     // Set up the data and value callbacks
 
     /**
@@ -215,6 +313,27 @@ public:
         return false;
     }
 
+    /**
+     * Hook called by the readDataSource call-back, receiving a view of the node id.
+     * Calls the DataRefFunc functor if set.
+     * Otherwise copies the node id and calls the NodeId version.
+     * Override this one instead to avoid allocating on each read.
+     * @param server
+     * @param node
+     * @param range
+     * @param value
+     * @return true on success
+     */
+    virtual bool readDataRef(
+        Server& server,
+        NodeIdRef node,
+        const UA_NumericRange* range,
+        UA_DataValue& value) {
+        if (_readDataRef) return _readDataRef(server, node, range, value);
+        NodeId n = node.get();
+        return readData(server, n, range, value);
+    }
+
     /**
      * Hook called by the writeDataSource call-back that can be overridden in children classes
      * to specialize how data are written to the node.
@@ -233,6 +352,26 @@ public:
         return false;
     }
 
+    /**
+     * Hook called by the writeDataSource call-back, receiving a view of the node id.
+     * Calls the ConstDataRefFunc functor if set.
+     * Otherwise copies the node id and calls the NodeId version.
+     * @param server
+     * @param node
+     * @param range
+     * @param value
+     * @return true on success
+     */
+    virtual bool writeDataRef(
+        Server& server,
+        NodeIdRef node,
+        const UA_NumericRange* range,
+        const UA_DataValue& value) {
+        if (_writeDataRef) return _writeDataRef(server, node, range, value);
+        NodeId n = node.get();
+        return writeData(server, n, range, value);
+    }
+
     /**
      * Establish the node as a data source provider.
      * A data source doesn't need a variable node attached to it to store the data.
@@ -247,6 +386,36 @@ public:
      */
     bool setAsDataSource(Server& server, NodeId& node);
 
+    /**
+     * Answer the data source reads from the last value read, while it is younger than a max age.
+     * Many sessions reading the same slow device node then cause a single device access per max age.
+     * The concurrent reads of a node missing the cache wait for a single readData() call.
+     * Reads of an index range always call readData(). A successful write drops the cached value.
+     * Configure it before the server runs.
+     * @param maxAge in milliseconds, 0 to disable the cache.
+     * @see readCacheStats()
+     */
+    void setReadCache(UA_Double maxAge);
+
+    /**
+     * @return the cache max age in milliseconds, 0 if disabled.
+     */
+    UA_Double readCacheMaxAge() const;
+
+    /**
+     * Drop the cached value of a node, the next read calls readData().
+     * @param node the data source node.
+     */
+    void invalidateReadCache(const UA_NodeId& node);
+
+    /**
+     * Get the read cache counters of a node.
+     * @param node the data source node.
+     * @param[out] stats the counters.
+     * @return false if the node was never read through the cache.
+     */
+    bool readCacheStats(const UA_NodeId& node, ReadCacheStats& stats) const;
+
     /*!
         \brief readDataSource
         \param server
@@ -309,6 +478,25 @@ public:
         if (_readValue) _readValue(server, node, range, value);
     }
 
+    /**
+     * Hook called by the readValueCallback() call-back, receiving a view of the node id.
+     * Calls the ValueRefFunc functor if set.
+     * Otherwise copies the node id and calls the NodeId version.
+     * @param node
+     */
+    virtual void readValueRef(
+        Server& server,
+        NodeIdRef node,
+        const UA_NumericRange* range,
+        const UA_DataValue* value) {
+        if (_readValueRef) {
+            _readValueRef(server, node, range, value);
+            return;
+        }
+        NodeId n = node.get();
+        readValue(server, n, range, value);
+    }
+
     /**
      * Hook called by the readValueCallback() call-back
      * that can be overridden in children classes
@@ -323,6 +511,25 @@ public:
         if (_writeValue) _writeValue(server, node, range, value);
     }
 
+    /**
+     * Hook called by the writeValueCallback() call-back, receiving a view of the node id.
+     * Calls the ConstValueRefFunc functor if set.
+     * Otherwise copies the node id and calls the NodeId version.
+     * @param node
+     */
+    virtual void writeValueRef(
+        Server& server,
+        NodeIdRef node,
+        const UA_NumericRange* range,
+        const UA_DataValue& value) {
+        if (_writeValueRef) {
+            _writeValueRef(server, node, range, value);
+            return;
+        }
+        NodeId n = node.get();
+        writeValue(server, n, range, value);
+    }
+
     // Value Callbacks
 
     /**
@@ -0,0 +1,166 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef NOTIFICATIONDISPATCHER_H
+#define NOTIFICATIONDISPATCHER_H
+
+#include <open62541cpp/open62541objects.h>
+#include <open62541cpp/boundedqueue.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Open62541 {
+
+class MonitoredItem;
+
+/**
+ * The DispatchTarget struct
+ * Link between a monitored item and its notifications waiting in a NotificationDispatcher.
+ * Shared by the item and the queued notifications, so the item can be destroyed while some are queued.
+ */
+struct DispatchTarget {
+    std::recursive_mutex        mutex;              /**< held while the item handles a notification. Recursive:
+                                                         the handler may remove its own item */
+    MonitoredItem*              item    = nullptr;  /**< null once the item is removed */
+    std::atomic<UA_DataValue*>  latest{nullptr};    /**< last value not dispatched yet, in coalescing mode */
+
+    explicit DispatchTarget(MonitoredItem* i) : item(i) {}
+    ~DispatchTarget();
+
+    /** Stop the dispatching to the item, waiting for its running handler to return. */
+    void detach() {
+        std::lock_guard<std::recursive_mutex> l(mutex);
+        item = nullptr;
+    }
+};
+
+typedef std::shared_ptr<DispatchTarget> DispatchTargetRef;
+
+/**
+ * The NotificationDispatcher class
+ * Runs the data change handlers of monitored items in a pool of worker threads,
+ * so a slow handler doesn't stall the client thread processing the publish responses and keep-alives.
+ * The client thread moves each notification into a bounded lock-free queue, consumed by the workers.
+ * A dispatcher can be shared by the subscriptions of several clients.
+ * The notifications of an item are handled in order only with a single worker, or in coalescing mode.
+ * @see ClientSubscription::setDispatcher()
+ */
+class NotificationDispatcher {
+public:
+    /** What to do with a new notification when the queue is full */
+    enum class Backpressure {
+        DropOldest, /**< discard the oldest queued notification */
+        Block,      /**< lossless per item: a notification finding the queue full is coalesced with the
+                         values of its item not dispatched yet, the oldest entry is dropped only if the item
+                         has none queued. Never waits: the client thread posting holds its client,
+                         which the handlers running in the workers may be calling */
+        Coalesce    /**< keep only the last value of each item: the queue never holds more than one entry per item.
+                         Drops the oldest entry if there are more items than slots */
+    };
+
+    /** Counters, read without lock */
+    struct Stats {
+        uint64_t posted     = 0;    /**< notifications received from the client threads */
+        uint64_t dispatched = 0;    /**< notifications handled by the items */
+        uint64_t dropped    = 0;    /**< notifications discarded: queue full, item removed or dispatcher stopped */
+        uint64_t coalesced  = 0;    /**< values replaced by a newer one before dispatch */
+        uint64_t blocked    = 0;    /**< notifications finding the queue full */
+        size_t   depth      = 0;    /**< current number of queued notifications */
+        size_t   maxDepth   = 0;    /**< highest number of queued notifications */
+    };
+
+private:
+    /** Queued notification. Owns its value unless coalescing */
+    struct Notification {
+        DispatchTargetRef   target;
+        UA_DataValue        value;
+        bool                hasValue = false;
+
+        Notification() { UA_DataValue_init(&value); }
+        ~Notification() { UA_DataValue_clear(&value); }
+        Notification(const Notification&) = delete;
+        Notification& operator=(const Notification&) = delete;
+        Notification& operator=(Notification&& n) noexcept {
+            if (this != &n) {
+                target = std::move(n.target);
+                UA_DataValue_clear(&value);
+                value    = n.value; // shallow move
+                hasValue = n.hasValue;
+                UA_DataValue_init(&n.value);
+                n.hasValue = false;
+            }
+            return *this;
+        }
+    };
+
+    BoundedQueue<Notification>  m_queue;
+    Backpressure                m_policy;
+    std::vector<std::thread>    m_workers;
+    std::atomic<bool>           m_running{false};
+
+    // idle workers sleep on the condition, the queue itself isn't locked
+    std::mutex                  m_idleMutex;
+    std::condition_variable     m_idle;
+    std::atomic<int>            m_sleeping{0};
+
+    std::atomic<uint64_t>       m_posted{0};
+    std::atomic<uint64_t>       m_dispatched{0};
+    std::atomic<uint64_t>       m_dropped{0};
+    std::atomic<uint64_t>       m_coalesced{0};
+    std::atomic<uint64_t>       m_blocked{0};
+    std::atomic<size_t>         m_maxDepth{0};
+
+    void run();
+    void push(Notification& n);
+    bool dropOldest(); // false if the queue is empty
+    void dispatch(Notification& n);
+    void wakeWorker();
+
+public:
+    /**
+     * Constructor. Starts the workers.
+     * @param workers number of threads running the handlers, at least 1.
+     * @param capacity maximum number of queued notifications, rounded up to a power of 2.
+     * @param policy what to do when the queue is full.
+     */
+    NotificationDispatcher(size_t workers = 1,
+                           size_t capacity = 4096,
+                           Backpressure policy = Backpressure::DropOldest);
+
+    /**
+     * Destructor. Stops the workers, the queued notifications are dropped.
+     */
+    virtual ~NotificationDispatcher();
+
+    Backpressure policy() const { return m_policy; }
+    size_t capacity()     const { return m_queue.capacity(); }
+
+    /**
+     * Queue a data change notification, called from the client thread. Never waits.
+     * Counted as dropped once the dispatcher is stopped.
+     * @param target the item to notify.
+     * @param value the new value, moved into the queue: left empty.
+     */
+    void post(const DispatchTargetRef& target, UA_DataValue& value);
+
+    /**
+     * Stop the workers. The queued notifications are dropped.
+     */
+    void stop();
+
+    /** @return a snapshot of the counters */
+    Stats stats() const;
+};
+
+} // namespace Open62541
+
+#endif // NOTIFICATIONDISPATCHER_H
@@ -0,0 +1,54 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+
+#ifndef DATAVALUELIST_H
+#define DATAVALUELIST_H
+
+#include "open62541/types.h"
+#include <vector>
+#include <open62541cpp/objects/UaBaseTypeTemplate.h>
+
+namespace Open62541 {
+    /**
+     * @class DataValueList open62541objects.h
+     * RAII contiguous vector of UA_DataValue, used to receive the results of batched reads.
+     * The list owns its values. It is meant to be reused between calls:
+     * reset() releases the values but keeps the allocated storage.
+     * Not safe to copy.
+     * @see UA_DataValue in open62541.h
+     */
+    class DataValueList : public std::vector<UA_DataValue>
+    {
+    public:
+        DataValueList() {}
+        virtual ~DataValueList();
+        DataValueList(const DataValueList&) = delete;
+        DataValueList& operator=(const DataValueList&) = delete;
+
+        /**
+         * Release the content of all the values and resize the list.
+         * @param size the new number of initialised values.
+         */
+        void reset(size_t size = 0);
+
+        /**
+         * Take the ownership of an array of values without copying them.
+         * @param pos index of the first value to replace, must be in the list.
+         * @param values array allocated by the stack, its values are moved and re-initialised.
+         * @param size number of values to take.
+         */
+        void take(size_t pos, UA_DataValue* values, size_t size);
+    };
+} // namespace Open62541
+
+
+#endif /* DATAVALUELIST_H */
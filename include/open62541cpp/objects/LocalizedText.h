@@ -27,11 +27,11 @@ namespace Open62541 {
      * No getter, use ->member_name to access them.
      * @see UA_LocalizedText in open62541.h
      */
-class LocalizedText : public TypeBase<UA_LocalizedText, UA_TYPES_LOCALIZEDTEXT>
+class LocalizedText : public InlineTypeBase<UA_LocalizedText, UA_TYPES_LOCALIZEDTEXT>
     {
     public:
         LocalizedText(const std::string& locale, const std::string& text)
-            : TypeBase(UA_LocalizedText_new())
+            : InlineTypeBase()
         {
             *ref() = UA_LOCALIZEDTEXT_ALLOC(locale.c_str(), text.c_str());
         }
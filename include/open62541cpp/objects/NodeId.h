@@ -29,7 +29,7 @@ namespace Open62541 {
  * No getter, use ->member_name to access them.
  * @see UA_NodeId in open62541.h
  */
-class NodeId : public TypeBase<UA_NodeId, UA_TYPES_NODEID>
+class NodeId : public InlineTypeBase<UA_NodeId, UA_TYPES_NODEID>
 {
 public:
     // Common constant nodes
@@ -60,39 +60,39 @@ public:
     unsigned hash() const { return UA_NodeId_hash(constRef()); }
 
     NodeId()
-        : TypeBase()
+        : InlineTypeBase()
     {
     }
 
     // human friendly id string
     NodeId(const char* id)
-        : TypeBase(UA_NodeId_new())
+        : InlineTypeBase()
     {
         *(ref()) = UA_NODEID(id);  // parses the string to a node id
     }
 
     NodeId(const UA_NodeId& t)
-        : TypeBase(UA_NodeId_new())
+        : InlineTypeBase()
     {
         UA_copy(&t, ref(), &UA_TYPES[UA_TYPES_NODEID]);
     }
 
     // Specialized constructors
     NodeId(unsigned index, unsigned id)
-        : TypeBase(UA_NodeId_new())
+        : InlineTypeBase()
     {
         *ref() = UA_NODEID_NUMERIC(UA_UInt16(index), id);
     }
 
     NodeId(unsigned index, const std::string& id)
-        : TypeBase(UA_NodeId_new())
+        : InlineTypeBase()
     {
         null();
         *ref() = UA_NODEID_STRING_ALLOC(UA_UInt16(index), id.c_str());
     }
 
     NodeId(unsigned index, UA_Guid guid)
-        : TypeBase(UA_NodeId_new())
+        : InlineTypeBase()
     {
         *ref() = UA_NODEID_GUID(UA_UInt16(index), guid);
     }
@@ -0,0 +1,64 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+
+#ifndef NODEIDHASHMAP_H
+#define NODEIDHASHMAP_H
+
+#include <unordered_map>
+#include "open62541/types.h"
+#include <open62541cpp/objects/UaBaseTypeTemplate.h>
+
+namespace Open62541 {
+
+    /**
+     * Hash functor of a UA_NodeId, to use it as a key of unordered containers.
+     */
+    struct NodeIdHash {
+        size_t operator()(const UA_NodeId& node) const { return UA_NodeId_hash(&node); }
+    };
+
+    /**
+     * Equality functor of a UA_NodeId, to use it as a key of unordered containers.
+     */
+    struct NodeIdEqual {
+        bool operator()(const UA_NodeId& a, const UA_NodeId& b) const { return UA_NodeId_equal(&a, &b); }
+    };
+
+    /**
+     * @class NodeIdHashMap open62541objects.h
+     * RAII hash map of UA_NodeId, with the put method added.
+     * Same usage as NodeIdMap, but keyed directly by the UA_NodeId instead of its serialization,
+     * so neither insertion nor lookup formats a string.
+     * The key and the value share the same deep copy, released by the map.
+     * Not safe to copy.
+     * @see NodeIdMap
+     * @see UA_NodeId in open62541.h
+     */
+    class NodeIdHashMap : public std::unordered_map<UA_NodeId, UA_NodeId, NodeIdHash, NodeIdEqual>
+    {
+    public:
+        NodeIdHashMap() {}  // set of nodes not in a tree
+        NodeIdHashMap(const NodeIdHashMap&) = delete;
+        NodeIdHashMap& operator=(const NodeIdHashMap&) = delete;
+        virtual ~NodeIdHashMap();
+
+        /**
+         * Add a deep copy of a node, if not already in the map.
+         * @param node the node to add.
+         * @return true if added, false if already in the map.
+         */
+        bool put(const UA_NodeId& node);
+    };
+} // namespace Open62541
+
+
+#endif /* NODEIDHASHMAP_H */
@@ -30,7 +30,11 @@ namespace Open62541 {
     public:
         NodeIdMap() {}  // set of nodes not in a tree
         virtual ~NodeIdMap();
-        void put(const UA_NodeId& node);
+        /**
+         * Add a deep copy of a node, if not already in the map.
+         * @return true if added, false if already in the map.
+         */
+        bool put(const UA_NodeId& node);
     };
 } // namespace Open62541
 
@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+
+#ifndef NODEIDREF_H
+#define NODEIDREF_H
+
+#include <string>
+#include <open62541cpp/objects/NodeId.h>
+
+namespace Open62541 {
+
+/**
+ * Non-owning read-only view of a UA_NodeId.
+ * @class NodeIdRef open62541objects.h
+ * Passed to the call-back hooks instead of a NodeId, so the node id given by the stack isn't copied.
+ * Only valid during the call it is given to: use copy() to keep the node id.
+ * @see NodeId
+ * @see UA_NodeId in open62541.h
+ */
+class NodeIdRef
+{
+    const UA_NodeId* _d; /**< the viewed node id, never null */
+
+public:
+    NodeIdRef(const UA_NodeId& node)
+        : _d(&node)
+    {
+    }
+
+    explicit NodeIdRef(const NodeId& node)
+        : _d(node.constRef())
+    {
+    }
+
+    const UA_NodeId& get() const { return *_d; }
+    const UA_NodeId* constRef() const { return _d; }
+
+    operator const UA_NodeId&() const { return *_d; }
+    operator const UA_NodeId*() const { return _d; }
+
+    bool isNull() const { return UA_NodeId_isNull(_d); }
+
+    // equality
+    bool operator==(const NodeIdRef& node) const { return UA_NodeId_equal(_d, node._d); }
+    bool operator!=(const NodeIdRef& node) const { return !UA_NodeId_equal(_d, node._d); }
+
+    /* Returns a non-cryptographic hash for the NodeId */
+    unsigned hash() const { return UA_NodeId_hash(_d); }
+
+    // accessors
+    int nameSpaceIndex() const { return _d->namespaceIndex; }
+
+    UA_NodeIdType identifierType() const { return _d->identifierType; }
+
+    UA_UInt32 numeric() const { return _d->identifier.numeric; }
+    const UA_String& string() const { return _d->identifier.string; }
+    const UA_Guid& guid() const { return _d->identifier.guid; }
+    const UA_ByteString& byteString() const { return _d->identifier.byteString; }
+
+    /**
+     * @return a deep copy of the node id, that can outlive the view.
+     */
+    NodeId copy() const { return NodeId(*_d); }
+
+    bool toString(std::string& s) const  // C library version of nodeid to string
+    {
+        UA_String o;
+        UA_NodeId_print(_d, &o);
+        s = std::string((char*)o.data, o.length);
+        UA_String_clear(&o);
+        return true;
+    }
+};
+}  // namespace Open62541
+
+
+#endif /* NODEIDREF_H */
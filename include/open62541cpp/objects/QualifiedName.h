@@ -27,19 +27,19 @@ namespace Open62541 {
  * Setters are implemented for all member.
  * @see UA_QualifiedName in open62541.h
  */
-class QualifiedName : public TypeBase<UA_QualifiedName, UA_TYPES_QUALIFIEDNAME>
+class QualifiedName : public InlineTypeBase<UA_QualifiedName, UA_TYPES_QUALIFIEDNAME>
 {
 public:
     QualifiedName() = default;
 
     QualifiedName(int ns, const char* str)
-        : TypeBase(UA_QualifiedName_new())
+        : InlineTypeBase()
     {
         *ref() = UA_QUALIFIEDNAME_ALLOC(ns, str);
     }
 
     QualifiedName(int ns, const std::string& str)
-        : TypeBase(UA_QualifiedName_new())
+        : InlineTypeBase()
     {
         *ref() = UA_QUALIFIEDNAME_ALLOC(ns, str.c_str());
     }
@@ -0,0 +1,51 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+
+#ifndef READVALUEIDLIST_H
+#define READVALUEIDLIST_H
+
+#include "open62541/types.h"
+#include <vector>
+#include <open62541cpp/objects/UaBaseTypeTemplate.h>
+
+namespace Open62541 {
+    /**
+     * @class ReadValueIdList open62541objects.h
+     * RAII vector of UA_ReadValueId with the put method added.
+     * Describes the node attributes of a batched read. Not safe to copy.
+     * @see UA_ReadValueId in open62541.h
+     * @see Client::readMany()
+     */
+    class ReadValueIdList : public std::vector<UA_ReadValueId>
+    {
+    public:
+        ReadValueIdList() {}
+        virtual ~ReadValueIdList();
+        ReadValueIdList(const ReadValueIdList&) = delete;
+        ReadValueIdList& operator=(const ReadValueIdList&) = delete;
+
+        /**
+         * Add a node attribute to read.
+         * @param node id of the node to read, deep copied.
+         * @param attributeId the attribute to read, the value by default.
+         */
+        void put(const UA_NodeId& node, UA_AttributeId attributeId = UA_ATTRIBUTEID_VALUE);
+
+        /**
+         * Release all the items, keeping the allocated storage for the next batch.
+         */
+        void reset();
+    };
+} // namespace Open62541
+
+
+#endif /* READVALUEIDLIST_H */
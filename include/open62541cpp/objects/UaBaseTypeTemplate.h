@@ -14,6 +14,7 @@
 #define UABASETYPETEMPLATE_H
 
 #include <memory>
+#include <utility>
 #include "open62541/types_generated.h"
 #include "open62541/types.h"
 
@@ -35,7 +36,22 @@ protected:
         void operator()(T* r) { UA_delete(r, &UA_TYPES[TYPES_ARRAY_INDEX]); }
     };
 
-    std::unique_ptr<T, Deleter> _d;  // shared pointer - there is no copy on change
+    mutable std::unique_ptr<T, Deleter> _d;  // shared pointer - there is no copy on change
+                                             // null only in a moved-from object, see data()
+
+    /**
+     * The wrapped struct. A moved-from object gets a new empty struct here,
+     * so it behaves as a default constructed one.
+     * @warning that first access of a moved-from object writes _d, even through a const accessor:
+     * don't share a moved-from object between threads before assigning it or calling ref() once.
+     */
+    T* data() const
+    {
+        if (!_d) {
+            _d.reset(static_cast<T*>(UA_new(&UA_TYPES[TYPES_ARRAY_INDEX])));
+        }
+        return _d.get();
+    }
 
 private:
     void init()
@@ -59,19 +75,19 @@ public:
 
     virtual ~TypeBase() = default;
 
-    T& get() const { return *(_d.get()); }
+    T& get() const { return *data(); }
     // Reference and pointer for parameter passing
     operator T&() const { return get(); }
 
-    operator T*() const { return _d.get(); }
-    const T* constRef() const { return _d.get(); }
+    operator T*() const { return data(); }
+    const T* constRef() const { return data(); }
 
-    T* ref() const { return _d.get(); }
+    T* ref() const { return data(); }
 
     T* clearRef()
     {
         clear();
-        return _d.get();
+        return data();
     }
 
     TypeBase(const T& t)
@@ -83,23 +99,48 @@ public:
     TypeBase(const TypeBase<T, TYPES_ARRAY_INDEX>& t)
     {
         init();
-        UA_copy(t._d.get(), _d.get(), &UA_TYPES[TYPES_ARRAY_INDEX]);
+        UA_copy(t.data(), _d.get(), &UA_TYPES[TYPES_ARRAY_INDEX]);
+    }
+
+    /**
+     * Move constructor. Steals the wrapped struct, no allocation and no deep copy.
+     * The moved-from object is empty: its accessors allocate a new empty struct.
+     */
+    TypeBase(TypeBase<T, TYPES_ARRAY_INDEX>&& t) noexcept
+        : _d(std::move(t._d))
+    {
     }
 
     TypeBase<T, TYPES_ARRAY_INDEX>& operator=(const TypeBase<T, TYPES_ARRAY_INDEX>& t)
     {
-        init();
-        UA_copy(t._d.get(), _d.get(), &UA_TYPES[TYPES_ARRAY_INDEX]);
+        if (this != &t) {
+            reuse();
+            UA_copy(t.data(), _d.get(), &UA_TYPES[TYPES_ARRAY_INDEX]);
+        }
+        return *this;
+    }
+
+    /**
+     * Move assignment. Swaps the wrapped structs so the source releases our old content
+     * when it is destroyed, no allocation and no deep copy.
+     */
+    TypeBase<T, TYPES_ARRAY_INDEX>& operator=(TypeBase<T, TYPES_ARRAY_INDEX>&& t) noexcept
+    {
+        _d.swap(t._d);
         return *this;
     }
 
     TypeBase<T, TYPES_ARRAY_INDEX>& operator=(const T& t)
     {
-        init();
-        UA_copy(&t, _d.get(), &UA_TYPES[TYPES_ARRAY_INDEX]);
+        if (_d.get() != &t) {
+            reuse();
+            UA_copy(&t, _d.get(), &UA_TYPES[TYPES_ARRAY_INDEX]);
+        }
         return *this;
     }
 
+    void swap(TypeBase<T, TYPES_ARRAY_INDEX>& t) noexcept { _d.swap(t._d); }
+
     void clear()
     {
         if (_d) {
@@ -109,19 +150,141 @@ public:
 
     void null()
     {
-        clear();
+        reuse();
         UA_init(_d.get(), &UA_TYPES[TYPES_ARRAY_INDEX]);
     }
 
     void assignTo(T& v)
+    {
+        UA_clear(&v, &UA_TYPES[TYPES_ARRAY_INDEX]);
+        UA_copy(data(), &v, &UA_TYPES[TYPES_ARRAY_INDEX]);
+    }
+    void assignFrom(const T& v)
+    {
+        reuse();
+        UA_copy(&v, _d.get(), &UA_TYPES[TYPES_ARRAY_INDEX]);
+    }
+
+private:
+    /**
+     * Prepare the wrapped struct to receive a new content.
+     * Clear it in place rather than reallocating, only allocate after a move.
+     */
+    void reuse()
+    {
+        if (_d) {
+            clear();
+        }
+        else {
+            init();
+        }
+    }
+};
+
+//
+// Same wrapper without the separate heap allocation: the C struct is a member of the object.
+// Used by the small hot wrappers (NodeId, Variant, QualifiedName, LocalizedText), created by the
+// thousands in the call-backs and services, where the malloc of TypeBase dominates.
+// The API is the same as TypeBase so they can be swapped for each other.
+// Moves are shallow: the struct is relocated and the source re-initialised, as open62541 does.
+// Unlike TypeBase, the address of the struct changes with the move: don't keep ref() across one.
+//
+template <typename T, int TYPES_ARRAY_INDEX>
+class InlineTypeBase
+{
+    static_assert(TYPES_ARRAY_INDEX < UA_TYPES_COUNT, "TYPES_ARRAY_INDEX must be smaller than UA_TYPES_COUNT");
+
+protected:
+    mutable T _v;  // the struct itself - mutable to keep the const accessors of TypeBase
+
+public:
+    InlineTypeBase() { UA_init(&_v, &UA_TYPES[TYPES_ARRAY_INDEX]); }
+
+    InlineTypeBase(const T& t) { UA_copy(&t, &_v, &UA_TYPES[TYPES_ARRAY_INDEX]); }
+
+    InlineTypeBase(const InlineTypeBase<T, TYPES_ARRAY_INDEX>& t)
+    {
+        UA_copy(&t._v, &_v, &UA_TYPES[TYPES_ARRAY_INDEX]);
+    }
+
+    InlineTypeBase(InlineTypeBase<T, TYPES_ARRAY_INDEX>&& t) noexcept
+        : _v(t._v)
+    {
+        UA_init(&t._v, &UA_TYPES[TYPES_ARRAY_INDEX]);
+    }
+
+    virtual ~InlineTypeBase() { clear(); }
+
+    InlineTypeBase<T, TYPES_ARRAY_INDEX>& operator=(const InlineTypeBase<T, TYPES_ARRAY_INDEX>& t)
+    {
+        if (this != &t) {
+            assignFrom(t._v);
+        }
+        return *this;
+    }
+
+    InlineTypeBase<T, TYPES_ARRAY_INDEX>& operator=(InlineTypeBase<T, TYPES_ARRAY_INDEX>&& t) noexcept
+    {
+        if (this != &t) {
+            clear();
+            _v = t._v;
+            UA_init(&t._v, &UA_TYPES[TYPES_ARRAY_INDEX]);
+        }
+        return *this;
+    }
+
+    InlineTypeBase<T, TYPES_ARRAY_INDEX>& operator=(const T& t)
+    {
+        if (&_v != &t) {
+            assignFrom(t);
+        }
+        return *this;
+    }
+
+    T& get() const { return _v; }
+    // Reference and pointer for parameter passing
+    operator T&() const { return get(); }
+
+    operator T*() const { return &_v; }
+    const T* constRef() const { return &_v; }
+
+    T* ref() const { return &_v; }
+
+    T* clearRef()
+    {
+        clear();
+        return &_v;
+    }
+
+    void clear() { UA_clear(&_v, &UA_TYPES[TYPES_ARRAY_INDEX]); }
+
+    void null()
     {
         clear();
-        UA_copy(_d.get(), &v, &UA_TYPES[TYPES_ARRAY_INDEX]);
+        UA_init(&_v, &UA_TYPES[TYPES_ARRAY_INDEX]);
+    }
+
+    void assignTo(T& v)
+    {
+        UA_clear(&v, &UA_TYPES[TYPES_ARRAY_INDEX]);
+        UA_copy(&_v, &v, &UA_TYPES[TYPES_ARRAY_INDEX]);
     }
     void assignFrom(const T& v)
     {
         clear();
-        UA_copy(&v, _d.get(), &UA_TYPES[TYPES_ARRAY_INDEX]);
+        UA_copy(&v, &_v, &UA_TYPES[TYPES_ARRAY_INDEX]);
+    }
+
+    void swap(InlineTypeBase<T, TYPES_ARRAY_INDEX>& t) noexcept { std::swap(_v, t._v); }
+
+    /**
+     * Take ownership of the content of v without copying it. v is re-initialised.
+     */
+    void take(T& v)
+    {
+        clear();
+        _v = v;
+        UA_init(&v, &UA_TYPES[TYPES_ARRAY_INDEX]);
     }
 };
 
@@ -140,7 +303,8 @@ public:
 #endif
 
     //
-// copies are all deep copies
+// copies are all deep copies, moves transfer the ownership
+// a moved-from object is empty, its accessors allocate a new empty struct
 //
 #define UA_TYPE_BASE(C, T)                                 \
     C()                                                    \
@@ -164,14 +328,25 @@ public:
     C(const C& n)                                          \
         : TypeBase(T##_new())                              \
     {                                                      \
-        T##_copy(n._d.get(), _d.get());                    \
+        T##_copy(n.ref(), _d.get());                       \
         UA_TRC("Copy Construct:" << UA_STRINGIFY(C))       \
     }                                                      \
+    C(C&& n) noexcept                                      \
+        : TypeBase(n._d.release())                         \
+    {                                                      \
+        UA_TRC("Move Construct:" << UA_STRINGIFY(C))       \
+    }                                                      \
     C& operator=(const C& n)                               \
     {                                                      \
         UA_TRC("Assign:" << UA_STRINGIFY(C));              \
         null();                                            \
-        T##_copy(n._d.get(), _d.get());                    \
+        T##_copy(n.ref(), _d.get());                       \
+        return *this;                                      \
+    }                                                      \
+    C& operator=(C&& n) noexcept                           \
+    {                                                      \
+        UA_TRC("Move Assign:" << UA_STRINGIFY(C));         \
+        _d.swap(n._d);                                     \
         return *this;                                      \
     }                                                      \
     void null()                                            \
@@ -183,8 +358,8 @@ public:
         _d.reset(T##_new());                               \
         T##_init(_d.get());                                \
     }                                                      \
-    void assignTo(T& v) { T##_copy(_d.get(), &v); }        \
-    void assignFrom(const T& v) { T##_copy(&v, _d.get()); }
+    void assignTo(T& v) { T##_copy(ref(), &v); }           \
+    void assignFrom(const T& v) { T##_copy(&v, ref()); }
 
 #define UA_TYPE_DEF(T) UA_TYPE_BASE(T, UA_##T)
 }  // namespace Open62541
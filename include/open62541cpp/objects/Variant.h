@@ -36,7 +36,7 @@ namespace Open62541 {
  * @see UA_Variant in open62541.h
  */
 
-class Variant : public TypeBase<UA_Variant, UA_TYPES_VARIANT>
+class Variant : public InlineTypeBase<UA_Variant, UA_TYPES_VARIANT>
 {
     /**
     * Configure the variant as a one dimension array.
@@ -50,32 +50,32 @@ public:
     // TO DO add array handling
 
     explicit Variant()
-        : TypeBase(UA_Variant_new())
+        : InlineTypeBase()
     {
     }
         
         // Scalar Ctor
     template<typename T>
-    Variant(const T& val) : TypeBase(UA_Variant_new()) {
+    Variant(const T& val) : InlineTypeBase() {
       UA_Variant_setScalarCopy(ref(), &val, GetUAPrimitiveType(val));
     }
 
     // Specialization using overload, not function template full specialization
-    Variant(const std::string& str) : TypeBase(UA_Variant_new()) {
+    Variant(const std::string& str) : InlineTypeBase() {
         const auto ss = toUA_String(str);
         UA_Variant_setScalarCopy(ref(), &ss, &UA_TYPES[UA_TYPES_STRING]);
     }
 
-    Variant(const char* locale, const char* text) : TypeBase(UA_Variant_new()) {
+    Variant(const char* locale, const char* text) : InlineTypeBase() {
         UA_LocalizedText t = UA_LOCALIZEDTEXT((char*)locale, (char*)text); // just builds does not allocate
         UA_Variant_setScalarCopy((UA_Variant*)ref(), &t, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
     }
 
-    Variant(UA_UInt64 v) : TypeBase(UA_Variant_new()) {
+    Variant(UA_UInt64 v) : InlineTypeBase() {
         UA_Variant_setScalarCopy((UA_Variant*)ref(), &v, &UA_TYPES[UA_TYPES_UINT64]);
     }
 
-    Variant(UA_String& v) : TypeBase(UA_Variant_new()) {
+    Variant(UA_String& v) : InlineTypeBase() {
         UA_Variant_setScalarCopy((UA_Variant*)ref(), &v, &UA_TYPES[UA_TYPES_STRING]);
     }
 
@@ -83,7 +83,7 @@ public:
         \brief uaVariant
         \param a
     */
-    Variant(int a) : TypeBase(UA_Variant_new()) {
+    Variant(int a) : InlineTypeBase() {
         UA_Variant_setScalarCopy((UA_Variant*)ref(), &a, &UA_TYPES[UA_TYPES_INT32]);
     }
 
@@ -91,7 +91,7 @@ public:
         \brief uaVariant
         \param a
     */
-    Variant(unsigned a) : TypeBase(UA_Variant_new()) {
+    Variant(unsigned a) : InlineTypeBase() {
         UA_Variant_setScalarCopy((UA_Variant*)ref(), &a, &UA_TYPES[UA_TYPES_UINT32]);
     }
 
@@ -99,7 +99,7 @@ public:
         \brief uaVariant
         \param a
     */
-    Variant(double a) : TypeBase(UA_Variant_new()) {
+    Variant(double a) : InlineTypeBase() {
         UA_Variant_setScalarCopy((UA_Variant*)ref(), &a, &UA_TYPES[UA_TYPES_DOUBLE]);
     }
 
@@ -107,7 +107,7 @@ public:
         \brief uaVariant
         \param a
     */
-    Variant(bool a) : TypeBase(UA_Variant_new()) {
+    Variant(bool a) : InlineTypeBase() {
         UA_Variant_setScalarCopy((UA_Variant*)ref(), &a, &UA_TYPES[UA_TYPES_BOOLEAN]);
     }
 
@@ -115,12 +115,12 @@ public:
         \brief Variant
         \param t
     */
-    Variant(UA_DateTime t) : TypeBase(UA_Variant_new()) {
+    Variant(UA_DateTime t) : InlineTypeBase() {
         UA_Variant_setScalarCopy((UA_Variant*)ref(), &t, &UA_TYPES[UA_TYPES_DATETIME]);
     }
 
         Variant(const char* v)
-        : TypeBase(UA_Variant_new())
+        : InlineTypeBase()
     {
         UA_String ss = UA_STRING((char*)v);
         UA_Variant_setScalarCopy((UA_Variant*)ref(), &ss, &UA_TYPES[UA_TYPES_STRING]);
@@ -129,7 +129,7 @@ public:
     // Array Ctor
     template<typename T>
     Variant(const std::vector<T>& vec)
-        : TypeBase(UA_Variant_new()) {
+        : InlineTypeBase() {
       UA_Variant_setArrayCopy(ref(), vec.data(), vec.size(), GetUAPrimitiveType(T()));
       set1DArray(vec.size());
     }
@@ -137,7 +137,7 @@ public:
     // Specialization using overload, not function template full specialization
     template<>
     Variant(const std::vector<std::string>& vec)
-        : TypeBase(UA_Variant_new()) {
+        : InlineTypeBase() {
       std::vector<UA_String> ua;
       ua.reserve(vec.size());
 
@@ -0,0 +1,52 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+
+#ifndef WRITEVALUELIST_H
+#define WRITEVALUELIST_H
+
+#include "open62541/types.h"
+#include <vector>
+#include <open62541cpp/objects/UaBaseTypeTemplate.h>
+
+namespace Open62541 {
+    /**
+     * @class WriteValueList open62541objects.h
+     * RAII vector of UA_WriteValue with the put method added.
+     * Describes the node attributes of a batched write. Not safe to copy.
+     * @see UA_WriteValue in open62541.h
+     * @see Client::writeMany()
+     */
+    class WriteValueList : public std::vector<UA_WriteValue>
+    {
+    public:
+        WriteValueList() {}
+        virtual ~WriteValueList();
+        WriteValueList(const WriteValueList&) = delete;
+        WriteValueList& operator=(const WriteValueList&) = delete;
+
+        /**
+         * Add a node attribute to write.
+         * @param node id of the node to write, deep copied.
+         * @param value the new value of the attribute, deep copied.
+         * @param attributeId the attribute to write, the value by default.
+         */
+        void put(const UA_NodeId& node, const UA_Variant& value, UA_AttributeId attributeId = UA_ATTRIBUTEID_VALUE);
+
+        /**
+         * Release all the items, keeping the allocated storage for the next batch.
+         */
+        void reset();
+    };
+} // namespace Open62541
+
+
+#endif /* WRITEVALUELIST_H */
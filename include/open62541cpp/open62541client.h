@@ -24,6 +24,10 @@
 #include <open62541cpp/objects/NodeTreeTypeDefs.h>
 #include <open62541cpp/objects/UANodeTree.h>
 #include <open62541cpp/objects/NodeIdMap.h>
+#include <open62541cpp/objects/NodeIdHashMap.h>
+#include <open62541cpp/objects/ReadValueIdList.h>
+#include <open62541cpp/objects/WriteValueList.h>
+#include <open62541cpp/objects/DataValueList.h>
 #include <open62541cpp/objects/NodeId.h>
 #include <open62541cpp/objects/VariableTypeAttributes.h>
 #include <open62541cpp/objects/ObjectAttributes.h>
@@ -35,6 +39,13 @@
 #include <open62541cpp/objects/LocalizedText.h>
 #include <open62541cpp/objects/QualifiedName.h>
 #include <open62541cpp/objects/open62541typedefs.h>
+#include <open62541cpp/clientasync.h>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <thread>
 
 /*
     OPC nodes are just data objects they do not need to be in a property tree.
@@ -68,8 +79,46 @@ typedef std::map<UA_UInt32, ClientSubscriptionRef> ClientSubscriptionMap;
 class Client {
     UA_Client*              m_pClient = nullptr;  /**< Underlying UA struct. */
     mutable ReadWriteMutex  m_mutex;
+    mutable std::atomic<std::thread::id> m_owner{}; /**< thread holding m_mutex exclusively, see ClientLock */
     ClientSubscriptionMap   m_subscriptions;      /**< Map of subscription of the client. */
 
+    /**
+     * Exclusive lock of m_mutex, re-entrant for the thread already holding it.
+     * The call-backs run by runIterate() or by a synchronous service (timers, data changes,
+     * session states, asynchronous completions) can then call the services of the client.
+     */
+    class ClientLock {
+        const Client&   m_client;
+        WriteLock       m_lock;
+        const bool      m_nested;
+
+    public:
+        explicit ClientLock(const Client& client)
+            : m_client(client)
+            , m_lock(client.m_mutex, boost::defer_lock)
+            , m_nested(client.m_owner.load() == std::this_thread::get_id()) {
+            if (m_nested) return;
+            m_lock.lock();
+            m_client.m_owner = std::this_thread::get_id();
+        }
+        ~ClientLock() {
+            if (!m_nested) m_client.m_owner = std::thread::id(); // before m_lock releases m_mutex
+        }
+        ClientLock(const ClientLock&) = delete;
+        ClientLock& operator=(const ClientLock&) = delete;
+    };
+
+    /** Shared lock of m_mutex, skipped by the thread holding a ClientLock */
+    class ClientReadLock {
+        ReadLock m_lock;
+
+    public:
+        explicit ClientReadLock(const Client& client)
+            : m_lock(client.m_mutex, boost::defer_lock) {
+            if (client.m_owner.load() != std::this_thread::get_id()) m_lock.lock();
+        }
+    };
+
 
 public:
     enum ConnectionType { NONE, CONNECTION, ASYNC, SECURE, SECUREASYNC };
@@ -127,12 +176,47 @@ private:
     UA_SessionState _sessionState       = UA_SESSIONSTATE_CLOSED;
     UA_StatusCode _connectStatus        = UA_STATUSCODE_GOOD;
 
+    // server operation limits used to split the batched services, 0 means no limit
+    UA_UInt32 _maxNodesPerRead   = 0;
+    UA_UInt32 _maxNodesPerWrite  = 0;
+    UA_UInt32 _maxNodesPerBrowse = 0;
+    UA_UInt32 _maxMonitoredItemsPerCall = 0;
+    std::atomic<bool> _operationLimitsKnown{false}; // read once per session, cleared by the state call-back
+
+    // asynchronous service pipeline
+    std::mutex                   _asyncMutex;        // guards the counters and the queue, not the client
+    size_t                       _asyncWindow   = 64; // maximum number of requests in flight
+    size_t                       _asyncInFlight = 0;
+    std::deque<AsyncOperation*>  _asyncQueue;        // owned, waiting for a free slot in the window
+
+    /**
+     * Send the queued operations while the window isn't full.
+     * The caller owns the UA_Client: it holds a ClientLock, maybe through one of its call-backs.
+     */
+    void dispatchAsync();
+
+    /**
+     * Fail all the queued operations, before the UA_Client is deleted.
+     * The stack cancels the ones in flight itself.
+     */
+    void cancelAsync(UA_StatusCode status);
+
+    /**
+     * Call-back receiving the response of every asynchronous operation.
+     * @param userdata the AsyncOperation, deleted once completed.
+     */
+    static void asyncOperationCallback(UA_Client* client, void* userdata, UA_UInt32 requestId, void* response);
+
 protected:
     UA_StatusCode m_lastError = 0;
 
 public:
     /*!
      * \brief runIterate
+     * Process the network events, holding a ClientLock. The call-backs run here (timers,
+     * data changes, session states, asynchronous completions) can call the client services:
+     * the lock is re-entrant for this thread. Other threads using this client wait
+     * for the end of the iteration, up to interval ms: keep it short when they share it.
      * \param interval
      * \return
      */
@@ -142,7 +226,7 @@ public:
 
     UA_Client* client()
     {
-        ReadLock l(m_mutex);
+        ClientReadLock l(*this);
         return m_pClient;
     }
 
@@ -341,6 +425,73 @@ public:
                         const void* value,
                         const UA_DataType& type);
 
+    /**
+     * Read many node attributes with as few Read service calls as possible, thread-safely.
+     * The batch is split according to the server MaxNodesPerRead operation limit.
+     * @param nodes the node attributes to read.
+     * @param[out] results receives one data value per item, in the same order.
+     *             Reuse the same list between calls to avoid reallocating it.
+     *             Check each value status for the per item result.
+     * @param timestamps specify the timestamps to return with the values.
+     * @return true if every service call succeeded.
+     */
+    bool readMany(const ReadValueIdList& nodes,
+                  DataValueList& results,
+                  UA_TimestampsToReturn timestamps = UA_TIMESTAMPSTORETURN_SOURCE);
+
+    /**
+     * Write many node attributes with as few Write service calls as possible, thread-safely.
+     * The batch is split according to the server MaxNodesPerWrite operation limit.
+     * @param values the node attributes and the values to write.
+     * @param[out] results receives the status code of each write, in the same order.
+     * @return true if every service call succeeded.
+     */
+    bool writeMany(const WriteValueList& values, std::vector<UA_StatusCode>& results);
+
+    /**
+     * Read the MaxNodesPerRead, MaxNodesPerWrite, MaxNodesPerBrowse and MaxMonitoredItemsPerCall
+     * operation limits of the connected server.
+     * Done once per session by readMany(), writeMany(), browseDescendants()
+     * and the bulk monitored item creation.
+     * Limits the server doesn't expose are considered unlimited.
+     * @return true on success.
+     */
+    bool readOperationLimits();
+
+    /**
+     * Override the operation limits used to split the batched reads, writes and browses.
+     * They are kept until the session is closed.
+     * @param maxNodesPerRead maximum number of items per Read request, 0 for no limit.
+     * @param maxNodesPerWrite maximum number of items per Write request, 0 for no limit.
+     * @param maxNodesPerBrowse maximum number of nodes per Browse request, 0 for the client default.
+     * @param maxMonitoredItemsPerCall maximum number of items per CreateMonitoredItems request, 0 for no limit.
+     */
+    void setOperationLimits(UA_UInt32 maxNodesPerRead,
+                            UA_UInt32 maxNodesPerWrite,
+                            UA_UInt32 maxNodesPerBrowse = 0,
+                            UA_UInt32 maxMonitoredItemsPerCall = 0)
+    {
+        ClientLock l(*this);
+        _maxNodesPerRead            = maxNodesPerRead;
+        _maxNodesPerWrite           = maxNodesPerWrite;
+        _maxNodesPerBrowse          = maxNodesPerBrowse;
+        _maxMonitoredItemsPerCall   = maxMonitoredItemsPerCall;
+        _operationLimitsKnown       = true;
+    }
+
+    /**
+     * Get the MaxMonitoredItemsPerCall operation limit of the server,
+     * reading the operation limits if not done yet in this session.
+     * @return the maximum number of items per CreateMonitoredItems request, 0 for no limit.
+     */
+    UA_UInt32 maxMonitoredItemsPerCall()
+    {
+        if (!_operationLimitsKnown)
+            readOperationLimits(); // on failure the items are sent at once
+        ClientReadLock l(*this);
+        return _maxMonitoredItemsPerCall;
+    }
+
     /**
      * Get the client connection status, thread-safely.
      * @warning Assumes a non-null client, otherwise throws Null client exception.
@@ -428,10 +579,41 @@ public:
      */
     UANodeIdList getChildrenList(const UA_NodeId& node);
 
+    /**
+     * Call-back of browseDescendants() processing one forward reference of a browsed node.
+     * @param parent the browsed node.
+     * @param parentContext the context given to the browsed node.
+     * @param reference the reference to the child, including its browse name.
+     * @param[out] childContext the context given to the child if it is browsed.
+     * @return true to browse the child too.
+     */
+    typedef std::function<bool(const UA_NodeId& parent,
+                               void* parentContext,
+                               const UA_ReferenceDescription& reference,
+                               void*& childContext)> BrowseVisitor;
+
+    /**
+     * Browse the descendants of a node with the Browse service, thread-safely.
+     * Pending nodes of any depth are browsed together, as many per BrowseRequest
+     * as the server MaxNodesPerBrowse limit allows, and the references are returned
+     * with their browse name, so no other request is needed per node.
+     * Truncated results are completed with BrowseNext; on error the pending
+     * continuation points are released.
+     * The client lock is only held by the service calls: the visitor is called
+     * without it and may use the other Client methods.
+     * @param start the node to browse from, excluded.
+     * @param context given to the visitor with the references of start.
+     * @param visitor called for each forward reference, decides which children are browsed.
+     * @return true if every service call succeeded.
+     */
+    bool browseDescendants(const UA_NodeId& start, void* context, const BrowseVisitor& visitor);
+
     /**
      * Copy the descendants tree of a given UA_NodeId into a given PropertyTree.
      * Browse the tree from a given UA_NodeId (excluded from copying)
      * and add all its children as children of the given UANode.
+     * Only nodes outside namespace 0 are added. When siblings have the same browse name the first is kept.
+     * A node already in its own ancestry isn't browsed again.
      * @param[in] root parent of the nodes to copy.
      * @param[in, out] dest destination point in tree to which children nodes are added.
      * @return true on success.
@@ -470,6 +652,23 @@ public:
      */
     bool browseChildren(const UA_NodeId& nodeId, NodeIdMap& map);
 
+    /**
+     * Copy a NodeId and its descendants tree into a NodeIdHashMap.
+     * Faster than the NodeIdMap version: the node ids aren't serialized.
+     * @param[in] nodeId the starting point added to the map with its children.
+     * @param[out] map the destination NodeIdHashMap.
+     * @return true on success.
+     */
+    bool browseTree(const NodeId& nodeId, NodeIdHashMap& map);
+
+    /**
+     * Copy only the non-duplicate children of a UA_NodeId into a NodeIdHashMap.
+     * @param[in] nodeId parent of children to copy
+     * @param[out] map to fill. The nodes already in it aren't browsed again.
+     * @return true on success.
+     */
+    bool browseChildren(const UA_NodeId& nodeId, NodeIdHashMap& map);
+
     /**
      * Get the node id from the path of browse names in the given namespace. Tests for node existence
      * @param[in] start the reference node for the path
@@ -1547,6 +1746,129 @@ public:
         UA_DateTime     startTimestamp,
         UA_DateTime     endTimestamp);
 
+    ///////////////////////////////////////////////////////////////////////////
+    // Asynchronous services
+    ///////////////////////////////////////////////////////////////////////////
+
+    /**
+     * Set the maximum number of asynchronous requests in flight on the secure channel.
+     * Further requests are queued and sent as responses arrive.
+     * @param window at least 1.
+     */
+    void setAsyncWindow(size_t window) {
+        {
+            std::lock_guard<std::mutex> l(_asyncMutex);
+            _asyncWindow = window ? window : 1;
+        }
+        ClientLock l(*this);
+        dispatchAsync();
+    }
+
+    size_t asyncWindow() {
+        std::lock_guard<std::mutex> l(_asyncMutex);
+        return _asyncWindow;
+    }
+
+    /** @return the number of asynchronous requests waiting for their response. */
+    size_t asyncInFlight() {
+        std::lock_guard<std::mutex> l(_asyncMutex);
+        return _asyncInFlight;
+    }
+
+    /** @return the number of asynchronous requests waiting for a free slot in the window. */
+    size_t asyncQueued() {
+        std::lock_guard<std::mutex> l(_asyncMutex);
+        return _asyncQueue.size();
+    }
+
+    /**
+     * Send an asynchronous request, or queue it if the window is full, thread-safely.
+     * The completions are called from runIterate(), or from any synchronous service
+     * receiving the responses, in the thread holding the client. They must not call the synchronous services,
+     * but can submit new asynchronous requests.
+     * @param operation the request and its completion. Owned and deleted by the client.
+     * @return false if the client isn't connected. The completion is called with the error.
+     */
+    bool submitAsync(AsyncOperation* operation);
+
+    /**
+     * Read node attributes asynchronously.
+     * @param nodes the node attributes to read, copied.
+     * @param done completion receiving the response.
+     * @param timestamps specify the timestamps to return with the values.
+     * @return false if the client isn't connected.
+     * @see submitAsync()
+     */
+    bool readAsync(const ReadValueIdList& nodes,
+                   AsyncRead::Completion done,
+                   UA_TimestampsToReturn timestamps = UA_TIMESTAMPSTORETURN_SOURCE);
+
+    /**
+     * Write node attributes asynchronously.
+     * @param values the node attributes and their values, copied.
+     * @param done completion receiving the response.
+     * @return false if the client isn't connected.
+     * @see submitAsync()
+     */
+    bool writeAsync(const WriteValueList& values, AsyncWrite::Completion done);
+
+    /**
+     * Browse nodes asynchronously.
+     * @param request the browse request, copied.
+     * @param done completion receiving the response.
+     * @return false if the client isn't connected.
+     * @see submitAsync()
+     */
+    bool browseAsync(const UA_BrowseRequest& request, AsyncBrowse::Completion done);
+
+    /**
+     * Call a method asynchronously.
+     * @param objectId the object owning the method.
+     * @param methodId the method to call.
+     * @param in the input arguments, copied.
+     * @param done completion receiving the response.
+     * @return false if the client isn't connected.
+     * @see submitAsync()
+     */
+    bool callAsync(const NodeId& objectId,
+                   const NodeId& methodId,
+                   const VariantList& in,
+                   AsyncCall::Completion done);
+
+    /**
+     * Read the history of nodes asynchronously.
+     * @param request the history read request, copied.
+     * @param done completion receiving the response.
+     * @return false if the client isn't connected.
+     * @see submitAsync()
+     */
+    bool historyReadAsync(const UA_HistoryReadRequest& request, AsyncHistoryRead::Completion done);
+
+    /**
+     * Read the raw history of a node asynchronously.
+     * @param node the historized node.
+     * @param startTime start of the period.
+     * @param endTime end of the period.
+     * @param numValuesPerNode maximum number of values returned, 0 for all.
+     * @param done completion receiving the response.
+     * @return false if the client isn't connected.
+     * @see submitAsync()
+     */
+    bool historyReadRawAsync(const NodeId& node,
+                             UA_DateTime startTime,
+                             UA_DateTime endTime,
+                             unsigned numValuesPerNode,
+                             AsyncHistoryRead::Completion done);
+
+    // The same services returning a future, resolved by runIterate().
+    // Don't wait for them in the thread running runIterate().
+    std::future<ReadResponse> readFuture(const ReadValueIdList& nodes,
+                                         UA_TimestampsToReturn timestamps = UA_TIMESTAMPSTORETURN_SOURCE);
+    std::future<WriteResponse> writeFuture(const WriteValueList& values);
+    std::future<BrowseResponse> browseFuture(const UA_BrowseRequest& request);
+    std::future<CallResponse> callFuture(const NodeId& objectId, const NodeId& methodId, const VariantList& in);
+    std::future<HistoryReadResponse> historyReadFuture(const UA_HistoryReadRequest& request);
+
     // connection status - updated in call back
     UA_SecureChannelState getChannelState() const { return _channelState; }
     UA_SessionState getSessionState() const { return _sessionState; }
@@ -17,6 +17,8 @@
 #include <open62541cpp/objects/Variant.h>
 #include <open62541cpp/objects/UANodeTree.h>
 #include <open62541cpp/objects/NodeIdMap.h>
+#include <open62541cpp/objects/WriteValueList.h>
+#include <open62541cpp/objects/NodeIdHashMap.h>
 #include <open62541cpp/objects/BrowsePathResult.h>
 #include <open62541cpp/objects/MethodAttributes.h>
 #include <open62541cpp/objects/UANodeIdList.h>
@@ -40,9 +42,11 @@
 #include <open62541/server_config_default.h>
 #include <open62541cpp/condition.h>
 #include <open62541cpp/open62541timer.h>
+#include <open62541cpp/timerwheel.h>
 #include "open62541/plugin/accesscontrol_default.h"
 
 #include <map>
+#include <atomic>
 
 namespace Open62541 {
 
@@ -52,6 +56,22 @@ class ServerMethod;
 class Client;
 class NodeContext;
 class RegisteredNodeContext;
+class SamplingManager;
+class ServerUpdateQueue;
+
+/**
+ * The lock of the read-only Server services.
+ * Concurrent reads of the address space are only safe when open62541 is built with
+ * UA_MULTITHREADING: otherwise its nodestore is unsynchronised and the reads are serialised.
+ * @note the reads don't scale with the reader threads in either build: with UA_MULTITHREADING,
+ * open62541 (1.2) serialises UA_Server_read behind its own service mutex. The shared lock
+ * only keeps the readers from queueing behind each other on m_mutex, on top of that.
+ */
+#if UA_MULTITHREADING >= 100
+typedef ReadLock ServerReadLock;
+#else
+typedef WriteLock ServerReadLock;
+#endif
 
 /**
  * The Server class abstracts the server side.
@@ -62,7 +82,6 @@ class RegisteredNodeContext;
  * Most functions return true if the lastError is UA_STATUSCODE_GOOD.
  **/
 class Server {
-    using ServerMap    = std::map<UA_Server*, Server*>;    /**< Map UA_Server pointer key to servers pointer value */
     using DiscoveryMap = std::map<UA_UInt64, std::string>; /**< Map the repeated registering call-back id with the
                                                               discovery server URL */
     using LoginList = std::vector<UA_UsernamePasswordLogin>;
@@ -71,9 +90,13 @@ class Server {
     UA_ServerConfig* m_pConfig = nullptr; /**< The server configuration */
     UA_Boolean m_running = false; /**< Flag both used to keep the server running and storing the server status. Set it
                                      to false to stop the server. @see stop(). */
-    ReadWriteMutex m_mutex;       /**< mutex for thread-safe read-write of the server nodes. Should probably mutable */
+    ReadWriteMutex m_mutex;       /**< mutex for thread-safe read-write of the server nodes.
+                                       Read-only services (read, browse, translate) take a ServerReadLock,
+                                       shared when open62541 is built with UA_MULTITHREADING,
+                                       where the stack still serialises them, see ServerReadLock.
+                                       services modifying the address space take an exclusive WriteLock.
+                                       The lock is not recursive: never call a locking method while holding it. */
 
-    static ServerMap        s_serverMap;              /**< map UA_SERVERs to Server objects. Enables a server to find another one. */
     DiscoveryMap m_discoveryList; /**< set of discovery servers this server has registered with.
                                        Map the repeated registering call-back id with the discovery server URL. */
     LoginList m_logins;           /**< set of permitted logins (user, password pairs)*/
@@ -82,10 +105,14 @@ class Server {
     std::map<unsigned, ConditionPtr> _conditionMap;  // Conditions - SCADA Alarm state handling by any other name
 #endif
     std::map<UA_UInt64, TimerPtr> _timerMap;  // one map per client 
+    SamplingManager* _samplingManager = nullptr; /**< demand-driven device polling, not owned */
+    std::shared_ptr<ServerUpdateQueue> _updateQueue; /**< values pushed by other threads, applied by iterate() */
+    std::unique_ptr<TimerWheel> _timerWheel;        /**< timers driven by the single repeated call-back _timerWheelId */
+    UA_UInt64 _timerWheelId = 0;
 
 
 protected:
-    UA_StatusCode _lastError = 0;
+    std::atomic<UA_StatusCode> _lastError{0}; /**< atomic as the shared lock lets concurrent readers set it */
 
 private:
 
@@ -449,6 +476,8 @@ public:
 
     /*!
      * \brief monitoredItemRegister
+     * Called when a monitored item is created or deleted.
+     * By default counts it in the sampling manager, if any.
      * \param sessionId
      * \param sessionContext
      * \param nodeId
@@ -456,14 +485,12 @@ public:
      * \param attibuteId
      * \param removed
      */
-    virtual void monitoredItemRegister(const UA_NodeId* /*sessionId*/,
-                                       void* /*sessionContext*/,
-                                       const UA_NodeId* /*nodeId*/,
-                                       void* /*nodeContext*/,
-                                       uint32_t /*attibuteId*/,
-                                       bool /*removed*/)
-    {
-    }
+    virtual void monitoredItemRegister(const UA_NodeId* sessionId,
+                                       void* sessionContext,
+                                       const UA_NodeId* nodeId,
+                                       void* nodeContext,
+                                       uint32_t attibuteId,
+                                       bool removed);
 
     /*!
      * \brief setMonitoredItemRegister
@@ -474,6 +501,21 @@ public:
             m_pConfig->monitoredItemRegisterCallback = Server::monitoredItemRegisterCallback;
     }
 
+    /**
+     * Poll the devices only for the monitored variables.
+     * Enables the monitoredItemRegister() call-back.
+     * Set it before the clients connect: the monitored items created before are not counted.
+     * @param manager the poll groups, not owned. Null to stop counting.
+     * @see SamplingManager
+     */
+    void setSamplingManager(SamplingManager* manager)
+    {
+        _samplingManager = manager;
+        if (manager) setMonitoredItemRegister();
+    }
+
+    SamplingManager* samplingManager() const { return _samplingManager; }
+
     /*!
      * \brief createOptionalChild
      * \return true if child is to be created
@@ -617,10 +659,31 @@ public:
     /**
      * Find an existing Server by its UA_Server pointer.
      * Used by call-backs to verify the server exists and is still running.
+     * Lock-free: the last server found by the calling thread is cached,
+     * so the call-backs of a running server resolve it in constant time.
+     * Safe while other servers are created or terminated.
      * @param pUAServer a pointer on the Server underlying UA_Server.
-     * @return a pointer on the matching Server
+     * @return a pointer on the matching Server, nullptr if not running.
      */
-     static Server* findServer(UA_Server* pUAServer) { return s_serverMap[pUAServer]; }
+    static Server* findServer(const UA_Server* pUAServer);
+
+private:
+    /**
+     * Make a server reachable by call-backs through findServer().
+     * @param pUAServer the underlying UA_Server.
+     * @param pServer the Server to return for it.
+     * @throw std::runtime_error if too many servers are running.
+     */
+    static void registerServer(const UA_Server* pUAServer, Server* pServer);
+
+    /**
+     * Make a server unreachable by call-backs.
+     * @param pUAServer the underlying UA_Server.
+     * @param pServer the registered Server. Nothing is done if another Server owns the UA_Server address.
+     */
+    static void unregisterServer(const UA_Server* pUAServer, const Server* pServer);
+
+public:
 
     // Discovery
 
@@ -802,6 +865,28 @@ public:
      */
     virtual void iterate();
 
+    /**
+     * Let other threads update variables without taking the server lock.
+     * They push the values into the queue, iterate() applies them in bulk between two network iterations.
+     * Call it before start().
+     * @param maxNodes maximum number of distinct nodes updated through the queue.
+     * @param budget maximum time in ms spent applying the values per iteration.
+     * @return true on success, false if already enabled.
+     * @see ServerUpdateQueue
+     */
+    bool enableUpdateQueue(size_t maxNodes = 65536, double budget = 5);
+
+    /**
+     * @return the queue of the values pushed by other threads, null if not enabled.
+     */
+    ServerUpdateQueue* updateQueue() const { return _updateQueue.get(); }
+
+    /**
+     * Apply the values waiting in the update queue, under a single lock. Called by iterate().
+     * @return the number of values written.
+     */
+    size_t applyUpdates();
+
     /**
  * Get the running state of the server
  * @return UA_TRUE if the server is running,
@@ -857,6 +942,34 @@ public:
                         const UA_DataType* attr_type,
                         const void* attr);
 
+    /**
+     * Set the Value attribute of many nodes, taking the lock once for the whole batch.
+     * Meant for acquisition threads updating many variables at each cycle.
+     * With skipUnchanged, the values equal to the current Value of their node are not written,
+     * compared under the same lock: a data source node is then read.
+     * @param[in] values the nodes and their new value.
+     * @param[out] results receives the status code of each write, in the same order. Good if skipped.
+     * @param skipUnchanged true to skip the values already in the nodes.
+     * @return true if every write succeeded.
+     */
+    bool writeValues(std::vector<std::pair<NodeId, Variant>>& values,
+                     std::vector<UA_StatusCode>& results,
+                     bool skipUnchanged = false);
+
+    /**
+     * Set the Value attribute of many nodes with their data value, including the source timestamp.
+     * Same as the Variant version. A value is unchanged if its variant and its status are,
+     * then its source timestamp is not updated.
+     * The Value attribute of each item is written, whatever its attributeId.
+     * @param[in] values the nodes and their new data value.
+     * @param[out] results receives the status code of each write, in the same order. Good if skipped.
+     * @param skipUnchanged true to skip the values already in the nodes.
+     * @return true if every write succeeded.
+     */
+    bool writeValues(WriteValueList& values,
+                     std::vector<UA_StatusCode>& results,
+                     bool skipUnchanged = false);
+
     /**
      * Copy only the non-duplicate children of a UA_NodeId into a NodeIdMap.
      * NodeIdMap maps a serialized UA_NodeId as key with the UA_NodeId itself as value.
@@ -866,6 +979,15 @@ public:
      */
     bool browseChildren(const UA_NodeId& nodeId, NodeIdMap& map);
 
+    /**
+     * Copy only the non-duplicate children of a UA_NodeId into a NodeIdHashMap.
+     * Faster than the NodeIdMap version: the node ids aren't serialized.
+     * @param nodeId parent of children to copy
+     * @param map to fill. The nodes already in it aren't browsed again.
+     * @return true on success.
+     */
+    bool browseChildren(const UA_NodeId& nodeId, NodeIdHashMap& map);
+
     /**
      * A simplified TranslateBrowsePathsToNodeIds based on the
      * SimpleAttributeOperand type (Part 4, 7.4.4.5).
@@ -925,6 +1047,14 @@ public:
      */
     bool browseTree(const NodeId& nodeId, NodeIdMap& m);
 
+    /**
+     * Copy a NodeId and its descendants tree into a NodeIdHashMap.
+     * @param nodeId the starting point added to the map with its children.
+     * @param map the destination NodeIdHashMap.
+     * @return true on success.
+     */
+    bool browseTree(const NodeId& nodeId, NodeIdHashMap& map);
+
     /**
      * create a browse path and add it to the tree
      * @warning not implemented.
@@ -1134,11 +1264,17 @@ public:
     bool browseName(NodeId & nodeId, std::string & s, int& ns) {
         if (!m_pServer) throw std::runtime_error("Null server");
         QualifiedName outBrowseName;
-        if (UA_Server_readBrowseName(m_pServer, nodeId, outBrowseName) == UA_STATUSCODE_GOOD) {
+        UA_StatusCode status;
+        {
+            ServerReadLock l(m_mutex);
+            status = UA_Server_readBrowseName(m_pServer, nodeId, outBrowseName);
+        }
+        _lastError = status;
+        if (status == UA_STATUSCODE_GOOD) {
             s = toString(outBrowseName.get().name);
             ns = outBrowseName.get().namespaceIndex;
         }
-        return lastOK();
+        return status == UA_STATUSCODE_GOOD;
     }
 
     /**
@@ -1542,9 +1678,13 @@ public:
 
         // outValue is managed by caller - transfer to output value
         value.null();
-        WriteLock l(m_mutex);
-        UA_Server_readValue(m_pServer, nodeId, value.ref());
-        return lastOK();
+        UA_StatusCode status;
+        {
+            ServerReadLock l(m_mutex);
+            status = UA_Server_readValue(m_pServer, nodeId, value.ref());
+        }
+        _lastError = status;
+        return status == UA_STATUSCODE_GOOD;
     }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -1791,6 +1931,7 @@ public:
             const QualifiedName& propertyName, 
             Variant& value)
         {
+            ServerReadLock l(m_mutex);
             return UA_Server_readObjectProperty(server(), objectId, propertyName, value) == UA_STATUSCODE_GOOD;
         }
 
@@ -2470,6 +2611,21 @@ public:
      * \param callbackId
      */
     void removeTimerEvent(UA_UInt64 callbackId);
+
+    /**
+     * Create the timer wheel, for many timers of the same resolution.
+     * All its timers are driven by a single repeated call-back, instead of one call-back each.
+     * Its functions run in the server thread, like the other timer events.
+     * @param tickMs resolution of the wheel timers in ms.
+     * @return true on success, false if already enabled.
+     * @see timerWheel()
+     */
+    bool enableTimerWheel(unsigned tickMs = 10);
+
+    /**
+     * @return the timer wheel, null if not enabled. Only use it in the server thread.
+     */
+    TimerWheel* timerWheel() const { return _timerWheel.get(); }
 };
 }// namespace open62541
 #endif //OPEN62541SERVER_H
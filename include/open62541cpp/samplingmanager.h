@@ -0,0 +1,144 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef SAMPLINGMANAGER_H
+#define SAMPLINGMANAGER_H
+
+#include <open62541cpp/open62541objects.h>
+#include <open62541cpp/objects/NodeIdHashMap.h>
+#include <open62541cpp/objects/NodeId.h>
+#include <unordered_map>
+#include <mutex>
+#include <set>
+
+namespace Open62541 {
+
+class Server;
+
+/**
+ * The SamplingManager class
+ * Polls the field devices only for the variables some client monitors.
+ * The variables are gathered in poll groups, typically one per device or per fieldbus request.
+ * The monitored items registered on the Value attribute are counted per node:
+ * a group starts polling when the first of its nodes gets monitored,
+ * and stops when the last monitored item of its nodes is deleted.
+ * The group polls at the fastest interval of its monitored nodes.
+ * @see Server::setSamplingManager()
+ */
+class SamplingManager {
+public:
+    typedef std::function<void(const std::string& group)> GroupFunc;
+    /** Poll function of a group, given the nodes currently monitored */
+    typedef std::function<void(const std::string& group, const std::vector<NodeId>& nodes)> PollFunc;
+
+private:
+    struct Group {
+        PollFunc                poll;
+        GroupFunc               start;              /**< called before the first poll */
+        GroupFunc               stop;               /**< called after the last poll */
+        UA_Double               defaultInterval;    /**< of the nodes without MinimumSamplingInterval */
+        std::vector<NodeId>     active;             /**< monitored nodes */
+        std::multiset<UA_Double> intervals;         /**< of the monitored nodes, the first is the fastest */
+        UA_Double               interval = 0;       /**< current poll interval, 0 if stopped */
+        UA_UInt64               timerId  = 0;       /**< repeated timer polling the group */
+        uint64_t                polls    = 0;
+    };
+
+    struct Node {
+        std::string group;
+        UA_Double   interval = 0;   /**< sampling interval */
+        unsigned    refs     = 0;   /**< number of monitored items */
+    };
+
+    // keys are deep copies, released by the manager
+    typedef std::unordered_map<UA_NodeId, Node, NodeIdHash, NodeIdEqual> NodeMap;
+
+    Server&                         m_server;
+    mutable std::mutex              m_mutex;
+    std::map<std::string, Group>    m_groups;
+    NodeMap                         m_nodes;
+
+    bool update(const std::string& name, Group& g, std::vector<std::function<void()>>& actions);
+    void poll(const std::string& name);
+
+public:
+    /**
+     * Constructor
+     * @param server the server whose monitored items drive the polling. Must outlive the manager.
+     */
+    SamplingManager(Server& server) : m_server(server) {}
+
+    /**
+     * Destructor. Stops the groups still polling, without calling their stop function.
+     */
+    virtual ~SamplingManager();
+
+    SamplingManager(const SamplingManager&) = delete;
+    SamplingManager& operator=(const SamplingManager&) = delete;
+
+    /**
+     * Declare a poll group.
+     * @param name unique name of the group.
+     * @param poll reads the devices and updates the values of the given nodes. Runs in the server thread.
+     * @param defaultInterval poll interval in ms of the nodes without a MinimumSamplingInterval.
+     * @param start optional function called when the group starts polling.
+     * @param stop optional function called when the group stops polling.
+     * @return false if the name is already used.
+     */
+    bool addGroup(const std::string&    name,
+                  PollFunc              poll,
+                  UA_Double             defaultInterval = 1000,
+                  GroupFunc             start = nullptr,
+                  GroupFunc             stop = nullptr);
+
+    /**
+     * Add a variable node to a poll group.
+     * @param group the group name.
+     * @param node the variable node polled by the group.
+     * @param interval sampling interval of the node in ms. 0 to use the node MinimumSamplingInterval,
+     *                 or the group default interval if it has none.
+     * @return false if the group is unknown or the node already belongs to a group.
+     */
+    bool addNode(const std::string& group, const NodeId& node, UA_Double interval = 0);
+
+    /**
+     * Count a monitored item creation or deletion.
+     * Called by Server::monitoredItemRegister(), in the server thread.
+     * @param nodeId the monitored node.
+     * @param attributeId the monitored attribute. Only the Value attribute is counted.
+     * @param removed true when the monitored item is deleted.
+     */
+    void monitoredItemRegister(const UA_NodeId& nodeId, uint32_t attributeId, bool removed);
+
+    /**
+     * @return the number of monitored items of a node, 0 if not in a group.
+     */
+    unsigned references(const UA_NodeId& node) const;
+
+    /**
+     * @return the current poll interval of a group in ms, 0 if not polling.
+     */
+    UA_Double interval(const std::string& group) const;
+
+    /**
+     * @return the number of polls done by a group.
+     */
+    uint64_t polls(const std::string& group) const;
+
+    /**
+     * @return the number of groups currently polling.
+     */
+    size_t activeGroups() const;
+};
+
+} // namespace Open62541
+
+#endif // SAMPLINGMANAGER_H
@@ -20,10 +20,72 @@
 #include <boost/beast/core/span.hpp>
 #endif
 #include <open62541cpp/objects/ArgumentList.h>
+#include <array>
+#include <tuple>
+#include <utility>
 
 namespace Open62541 {
 
-using VariantSpan = boost::beast::span<UA_Variant>;
+using VariantSpan       = boost::beast::span<UA_Variant>;
+using ConstVariantSpan  = boost::beast::span<const UA_Variant>; /**< non-owning view on the stack inputs */
+
+/**
+ * The MethodArgument traits
+ * Map a C++ type to the data type and value rank of a method argument,
+ * and read it from an input variant without copying the variant.
+ * Specialised for the numeric built-in types, UA_String (shallow, valid during the call),
+ * std::string (copied) and boost::beast::span<const T> (view on an array input).
+ */
+template <typename T> struct MethodArgument;
+
+#define OPEN62541CPP_METHOD_ARGUMENT(T, TYPES_INDEX)                          \
+template <> struct MethodArgument<T> {                                      \
+    static const UA_DataType* type() { return &UA_TYPES[TYPES_INDEX]; }     \
+    static UA_Int32 valueRank() { return -1; }                              \
+    static bool get(const UA_Variant& v, T& out) {                          \
+        if (!UA_Variant_hasScalarType(&v, type())) return false;            \
+        out = *static_cast<const T*>(v.data);                               \
+        return true;                                                        \
+    }                                                                       \
+};
+
+OPEN62541CPP_METHOD_ARGUMENT(UA_Boolean,  UA_TYPES_BOOLEAN)
+OPEN62541CPP_METHOD_ARGUMENT(UA_SByte,    UA_TYPES_SBYTE)
+OPEN62541CPP_METHOD_ARGUMENT(UA_Byte,     UA_TYPES_BYTE)
+OPEN62541CPP_METHOD_ARGUMENT(UA_Int16,    UA_TYPES_INT16)
+OPEN62541CPP_METHOD_ARGUMENT(UA_UInt16,   UA_TYPES_UINT16)
+OPEN62541CPP_METHOD_ARGUMENT(UA_Int32,    UA_TYPES_INT32)
+OPEN62541CPP_METHOD_ARGUMENT(UA_UInt32,   UA_TYPES_UINT32)
+OPEN62541CPP_METHOD_ARGUMENT(UA_Int64,    UA_TYPES_INT64)
+OPEN62541CPP_METHOD_ARGUMENT(UA_UInt64,   UA_TYPES_UINT64)
+OPEN62541CPP_METHOD_ARGUMENT(UA_Float,    UA_TYPES_FLOAT)
+OPEN62541CPP_METHOD_ARGUMENT(UA_Double,   UA_TYPES_DOUBLE)
+OPEN62541CPP_METHOD_ARGUMENT(UA_String,   UA_TYPES_STRING)
+
+#undef OPEN62541CPP_METHOD_ARGUMENT
+
+template <> struct MethodArgument<std::string> {
+    static const UA_DataType* type() { return &UA_TYPES[UA_TYPES_STRING]; }
+    static UA_Int32 valueRank() { return -1; }
+    static bool get(const UA_Variant& v, std::string& out) {
+        if (!UA_Variant_hasScalarType(&v, type())) return false;
+        const UA_String* s = static_cast<const UA_String*>(v.data);
+        out.assign(reinterpret_cast<const char*>(s->data), s->length);
+        return true;
+    }
+};
+
+template <typename T> struct MethodArgument<boost::beast::span<const T>> {
+    static_assert(!std::is_same<T, std::string>::value, "use span<const UA_String> for string arrays");
+    static const UA_DataType* type() { return MethodArgument<T>::type(); }
+    static UA_Int32 valueRank() { return 1; }
+    static bool get(const UA_Variant& v, boost::beast::span<const T>& out) {
+        if (!UA_Variant_hasArrayType(&v, type())) return false;
+        out = boost::beast::span<const T>(static_cast<const T*>(v.data), v.arrayLength);
+        return true;
+    }
+};
+
 /**
  * The ServerMethod class
  */
@@ -42,7 +104,7 @@ public:
 
     /**
      * Call-back used to call this method.
-     * Customized by callback() hook.
+     * Customized by the callbackView() or callback() hooks.
      * @param server of the method node
      * @param sessionId     (unused)
      * @param sessionContext (unused)
@@ -117,6 +179,60 @@ public:
         return m_lastError;
     }
 
+    /**
+     * Hook called by methodCallback, with a view on the inputs owned by the stack.
+     * No input is copied. The view is only valid during the call.
+     * By default, copies the inputs shallowly in a VariantList and calls
+     * callback(), for the methods written against it.
+     * @param server of the method node
+     * @param objectId node of the method
+     * @param inputs view on the input array
+     * @param outputs view on the output array
+     * @return the status of the call
+     */
+    virtual UA_StatusCode callbackView(
+        Server&             server,
+        const UA_NodeId*    objectId,
+        ConstVariantSpan    inputs,
+        VariantSpan&        outputs) {
+        VariantList list(inputs.begin(), inputs.end());
+        return callback(server, objectId, list, outputs);
+    }
+
+    /**
+     * Read the inputs into typed values, without copying the variants.
+     * The types are checked against the inputs, see MethodArgument.
+     * Span and UA_String values point in the inputs.
+     * @param inputs view on the input array
+     * @param[out] args receives the values, in order.
+     * @return UA_STATUSCODE_GOOD, UA_STATUSCODE_BADARGUMENTSMISSING,
+     *         UA_STATUSCODE_BADTOOMANYARGUMENTS or UA_STATUSCODE_BADTYPEMISMATCH.
+     */
+    template <typename... T>
+    static UA_StatusCode unpackInputs(ConstVariantSpan inputs, std::tuple<T...>& args) {
+        if (inputs.size() < sizeof...(T)) return UA_STATUSCODE_BADARGUMENTSMISSING;
+        if (inputs.size() > sizeof...(T)) return UA_STATUSCODE_BADTOOMANYARGUMENTS;
+        return unpackInputs(inputs, args, std::index_sequence_for<T...>());
+    }
+
+    /**
+     * Declare the input arguments from their C++ types, see MethodArgument.
+     * @param names of the arguments. They must outlive the method, string literals for example.
+     */
+    template <typename... T>
+    void declareInputs(const std::array<const char*, sizeof...(T)>& names) {
+        declareArguments<T...>(m_in, names);
+    }
+
+    /**
+     * Declare the output arguments from their C++ types, see MethodArgument.
+     * @param names of the arguments. They must outlive the method, string literals for example.
+     */
+    template <typename... T>
+    void declareOutputs(const std::array<const char*, sizeof...(T)>& names) {
+        declareArguments<T...>(m_out, names);
+    }
+
     /**
      * @return true if _lastError is UA_STATUSCODE_GOOD
      */
@@ -147,6 +263,33 @@ public:
         const NodeId&       nodeId,
         NodeId&             newNode         = NodeId::Null,
         int                 nameSpaceIndex  = 0);
+
+private:
+    template <typename Tuple, size_t... I>
+    static UA_StatusCode unpackInputs(ConstVariantSpan inputs, Tuple& args, std::index_sequence<I...>) {
+        const bool ok[] = { true,
+            MethodArgument<typename std::tuple_element<I, Tuple>::type>::get(inputs.data()[I], std::get<I>(args))... };
+        for (bool b : ok)
+            if (!b) return UA_STATUSCODE_BADTYPEMISMATCH;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    template <typename... T>
+    static void declareArguments(
+        ArgumentList&                                   list,
+        const std::array<const char*, sizeof...(T)>&    names) {
+        const UA_DataType* types[]  = { nullptr, MethodArgument<T>::type()... };
+        const UA_Int32     ranks[]  = { 0, MethodArgument<T>::valueRank()... };
+        list.resize(sizeof...(T) + 1); // keep the parameter space convention
+        for (size_t i = 0; i < sizeof...(T); i++) {
+            UA_Argument& item = list[i];
+            UA_Argument_init(&item);
+            item.name        = UA_STRING((char*)names[i]);
+            item.description = UA_LOCALIZEDTEXT((char*)"en_US", (char*)names[i]);
+            item.dataType    = types[i + 1]->typeId;
+            item.valueRank   = ranks[i + 1];
+        }
+    }
 };
 
 /**
@@ -154,6 +297,61 @@ public:
  */
 typedef std::shared_ptr<ServerMethod> ServerMethodRef;
 
+/**
+ * The TypedServerMethod class
+ * A method whose input arguments are declared and unpacked from the C++ types In...
+ * The inputs are checked and read without copying the variants, see MethodArgument.
+ * Override call() instead of callback() or callbackView().
+ */
+template <typename... In>
+class TypedServerMethod : public ServerMethod {
+public:
+    typedef std::tuple<In...> Inputs;
+
+    /**
+     * TypedServerMethod
+     * @param name of the method
+     * @param inputNames of the input arguments. They must outlive the method.
+     * @param nOutputs number of output arguments, to set in out().
+     */
+    TypedServerMethod(
+        const std::string&                              name,
+        const std::array<const char*, sizeof...(In)>&   inputNames,
+        int                                             nOutputs = 1)
+        : ServerMethod(name, int(sizeof...(In)), nOutputs) {
+        declareInputs<In...>(inputNames);
+    }
+
+    /**
+     * Hook called with the unpacked inputs.
+     * Do nothing by default.
+     * @param server of the method node
+     * @param objectId node of the method
+     * @param inputs the typed input values
+     * @param outputs view on the output array
+     * @return the status of the call
+     */
+    virtual UA_StatusCode call(
+        Server&             server,
+        const UA_NodeId*    objectId,
+        const Inputs&       inputs,
+        VariantSpan&        outputs) {
+        return UA_STATUSCODE_GOOD;
+    }
+
+    UA_StatusCode callbackView(
+        Server&             server,
+        const UA_NodeId*    objectId,
+        ConstVariantSpan    inputs,
+        VariantSpan&        outputs) override {
+        Inputs args;
+        m_lastError = unpackInputs(inputs, args);
+        if (m_lastError == UA_STATUSCODE_GOOD)
+            m_lastError = call(server, objectId, args, outputs);
+        return m_lastError;
+    }
+};
+
 } // namespace Open62541
 
 #endif /* SERVERMETHOD_H */
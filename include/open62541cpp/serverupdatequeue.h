@@ -0,0 +1,146 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef SERVERUPDATEQUEUE_H
+#define SERVERUPDATEQUEUE_H
+
+#include <open62541cpp/open62541objects.h>
+#include <open62541cpp/boundedqueue.h>
+#include <open62541cpp/objects/NodeIdHashMap.h>
+#include <open62541cpp/objects/Variant.h>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+
+namespace Open62541 {
+
+class ServerUpdateQueue;
+
+/**
+ * The ValueUpdateSlot class
+ * Pending value of one node, pushed by producer threads without lock.
+ * Only the latest value pushed before the server loop applies it is written.
+ * Owned by its ServerUpdateQueue: get it once with ServerUpdateQueue::slot() and keep it.
+ */
+class ValueUpdateSlot {
+    friend class ServerUpdateQueue;
+
+    ServerUpdateQueue&          m_queue;
+    UA_NodeId                   m_node;                 /**< owned */
+    std::atomic<UA_DataValue*>  m_latest{nullptr};      /**< value not applied yet, null if none */
+
+public:
+    ValueUpdateSlot(ServerUpdateQueue& queue, const UA_NodeId& node);
+    ~ValueUpdateSlot();
+    ValueUpdateSlot(const ValueUpdateSlot&) = delete;
+    ValueUpdateSlot& operator=(const ValueUpdateSlot&) = delete;
+
+    const UA_NodeId& node() const { return m_node; }
+
+    /**
+     * Queue a new value of the node, without lock.
+     * @param value the data value, with its source timestamp if any. Moved from.
+     */
+    void push(UA_DataValue& value);
+
+    /**
+     * Queue a new value of the node, without lock.
+     * @param value copied, with the current time as source timestamp.
+     */
+    void push(const Variant& value);
+};
+
+/**
+ * The ServerUpdateQueue class
+ * Lets threads outside the server loop update variables without taking the server lock.
+ * The producers push values into per node slots, the server loop applies them in bulk
+ * under a single lock, for a bounded time per iteration.
+ * A slot is queued at most once: a burst on a node costs one write, with the latest value,
+ * and the queue never holds more entries than there are slots.
+ * @see Server::enableUpdateQueue()
+ */
+class ServerUpdateQueue {
+    friend class ValueUpdateSlot;
+
+public:
+    /** Counters, read without lock */
+    struct Stats {
+        uint64_t pushed    = 0; /**< values pushed */
+        uint64_t coalesced = 0; /**< values replaced by a newer one before being applied */
+        uint64_t applied   = 0; /**< values written in the nodes */
+        uint64_t failed    = 0; /**< values the server refused */
+        size_t   depth     = 0; /**< nodes waiting to be applied */
+    };
+
+    /** Called under the server lock after each write */
+    typedef std::function<void(const UA_NodeId& node, UA_StatusCode status)> AppliedFunc;
+
+private:
+    typedef std::unordered_map<UA_NodeId, std::unique_ptr<ValueUpdateSlot>, NodeIdHash, NodeIdEqual> SlotMap;
+
+    BoundedQueue<ValueUpdateSlot*>              m_queue;        /**< slots holding a value, at most once each */
+    const size_t                                m_maxNodes;
+    std::chrono::duration<double, std::milli>   m_budget;
+    std::mutex                                  m_slotsMutex;   /**< guards the slot creation only */
+    SlotMap                                     m_slots;        /**< keyed by the slot node id */
+
+    std::atomic<uint64_t>                       m_pushed{0};
+    std::atomic<uint64_t>                       m_coalesced{0};
+    std::atomic<uint64_t>                       m_applied{0};
+    std::atomic<uint64_t>                       m_failed{0};
+
+    void queue(ValueUpdateSlot* slot) { m_queue.tryPush(slot); } // never full: one entry per slot
+
+public:
+    /**
+     * @param maxNodes maximum number of slots.
+     * @param budget maximum time in ms spent applying the values per server loop iteration.
+     */
+    ServerUpdateQueue(size_t maxNodes, double budget);
+    ~ServerUpdateQueue() = default;
+    ServerUpdateQueue(const ServerUpdateQueue&) = delete;
+    ServerUpdateQueue& operator=(const ServerUpdateQueue&) = delete;
+
+    /**
+     * Get or create the slot of a node. Takes a lock: do it once per node, before the updates.
+     * @param node the variable node to update.
+     * @return the slot, owned by the queue. Null if there are already maxNodes slots.
+     */
+    ValueUpdateSlot* slot(const UA_NodeId& node);
+
+    /**
+     * Queue a new value of a node, finding its slot under a short lock.
+     * Keep the slot and use ValueUpdateSlot::push() instead in the update loops.
+     * @param node the variable node to update.
+     * @param value moved from.
+     * @return false if no slot is available.
+     */
+    bool push(const UA_NodeId& node, UA_DataValue& value);
+
+    /**
+     * Write the queued values, until the queue is empty or the time budget is spent.
+     * Must be called in the server loop, holding the server lock.
+     * @param server the server owning the nodes.
+     * @param done optional function called after each write.
+     * @return the number of values written.
+     */
+    size_t apply(UA_Server* server, const AppliedFunc& done = nullptr);
+
+    /** @return true if no value waits */
+    bool empty() const { return m_queue.size() == 0; }
+
+    /** @return a snapshot of the counters */
+    Stats stats() const;
+};
+
+} // namespace Open62541
+
+#endif // SERVERUPDATEQUEUE_H
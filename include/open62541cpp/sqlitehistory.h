@@ -0,0 +1,176 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef SQLITEHISTORY_H
+#define SQLITEHISTORY_H
+
+#include <open62541cpp/historydatabase.h>
+#include <unordered_map>
+#include <mutex>
+#include <string>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace Open62541 {
+
+/**
+ * The SQLiteHistoryBackend class
+ * Persistent history storage in a SQLite file, on its own connection:
+ * the journal is in WAL mode with synchronous=NORMAL, so a commit appends to the log
+ * without waiting for the disk, and every statement is prepared once.
+ * begin() and commit() wrap a batch of inserts in one transaction,
+ * called around each drain of a WriteBehindHistoryBackend by SQLiteHistorian.
+ * One row per sample: node, time, status, type and value. The time is the source time stamp,
+ * else the server time stamp, else the time of insertion, returned as both.
+ * Stores scalars of the built-in types: numbers, Boolean, DateTime, StatusCode, Guid,
+ * String, ByteString and XmlElement. Other values are refused with BadTypeMismatch.
+ * Implements the high level HistoryRead API: a read is one indexed range query,
+ * continued after the time and row of the last value returned.
+ * Every pruneInterval samples of a node, its oldest samples beyond maxValuesPerNode,
+ * or older than maxAge seconds, are deleted.
+ * Only built when the sqlite3 library is found, which defines UA_CPP_SQLITE_HISTORY.
+ */
+class SQLiteHistoryBackend : public HistoryDataBackend
+{
+    /** The prepared statements, in the order of the SQL texts in sqlitehistory.cpp */
+    enum Statement {
+        Insert,
+        Exists,
+        Replace,
+        Remove,
+        Before,
+        After,
+        Forward,
+        Backward,
+        PruneCount,
+        PruneAge,
+        Begin,
+        Commit,
+        Statements
+    };
+
+    mutable std::mutex  m_mutex;
+    sqlite3*            m_db = nullptr;
+    sqlite3_stmt*       m_statements[Statements] = {};
+    size_t              m_maxValuesPerNode;
+    UA_DateTime         m_maxAge;
+    size_t              m_pruneInterval;
+    std::unordered_map<std::string, size_t> m_inserted; /**< samples per node since its last pruning */
+
+    // call holding m_mutex
+    UA_StatusCode   execute(Statement s);
+    UA_StatusCode   insert(const std::string& node, const UA_DataValue& value);
+    void            prune(const std::string& node);
+    bool            bound(const std::string& node, Statement s, UA_DateTime t, UA_DateTime& found);
+
+public:
+    /**
+     * SQLiteHistoryBackend
+     * @param dbFileName the database file, created if needed.
+     * @param maxValuesPerNode number of samples kept per node, 0 for no limit.
+     * @param maxAge age in seconds of the samples kept, 0 for no limit.
+     * @param pruneInterval number of samples of a node between two prunings.
+     */
+    SQLiteHistoryBackend(
+        const std::string&  dbFileName,
+        size_t              maxValuesPerNode    = 0,
+        UA_DateTime         maxAge              = 0,
+        size_t              pruneInterval       = 1000);
+    ~SQLiteHistoryBackend() override;
+    SQLiteHistoryBackend(const SQLiteHistoryBackend&) = delete;
+    SQLiteHistoryBackend& operator=(const SQLiteHistoryBackend&) = delete;
+
+    /** @return true if the database is open and its statements prepared. */
+    bool isOpen() const;
+
+    /** Start a transaction: the next inserts are written by commit(). */
+    UA_StatusCode begin();
+
+    /** Commit the transaction started by begin(). */
+    UA_StatusCode commit();
+
+    /** Close the database. */
+    void deleteMembers() override;
+
+    // HistoryDataBackend hooks
+    UA_StatusCode serverSetHistoryData(
+        Context&            context,
+        bool                historizing,
+        const UA_DataValue* value) override;
+
+    /**
+     * Raw read of the values from start to end, the end excluded, in reverse order
+     * if start is after end, with the bounds if asked for, BadBoundNotFound values
+     * standing for the missing ones.
+     * @see HistoryDataBackend::getHistoryData
+     */
+    UA_StatusCode getHistoryData(
+        Context&            context,
+        const UA_DateTime   start,
+        const UA_DateTime   end,
+        size_t              maxSizePerResponse,
+        UA_UInt32           numValuesPerNode,
+        UA_Boolean          returnBounds,
+        UA_TimestampsToReturn timestampsToReturn,
+        UA_NumericRange     range,
+        UA_Boolean          releaseContinuationPoints,
+        std::string&        continuationPoint,
+        std::string&        outContinuationPoint,
+        UA_HistoryData*     result) override;
+
+    UA_Boolean boundSupported(Context& context) override;
+    UA_Boolean timestampsToReturnSupported(Context& context, UA_TimestampsToReturn timestampsToReturn) override;
+
+    UA_StatusCode insertDataValue(Context& context, const UA_DataValue* value) override;
+    UA_StatusCode replaceDataValue(Context& context, const UA_DataValue* value) override;
+    UA_StatusCode updateDataValue(Context& context, const UA_DataValue* value) override;
+    UA_StatusCode removeDataValue(
+        Context&    context,
+        UA_DateTime startTimestamp,
+        UA_DateTime endTimestamp) override;
+};
+
+/**
+ * The SQLiteHistorian class
+ * The default gathering and database over a SQLiteHistoryBackend, behind a write-behind stage:
+ * the values are inserted by a background thread, one transaction per batch.
+ * Same usage as SQLiteHistorianCyclicBuffered, whose inserts are single statements
+ * of the C plug-in, each its own transaction.
+ */
+class SQLiteHistorian : public Historian
+{
+    SQLiteHistoryBackend m_store;
+
+public:
+    /**
+     * @param maxValuesPerNode number of values kept per node, 0 for no limit.
+     * @param maxBufferedTimeSec age in seconds of the values kept, 0 for no limit.
+     * @param flushInterval maximum time in ms a value waits before being inserted,
+     *        0 to insert it in the write service.
+     * @param maxQueued maximum number of values waiting, inserted in place beyond it.
+     */
+    SQLiteHistorian(const char* dbFileName,
+                    size_t numberNodes = 100,
+                    size_t maxValuesPerNode = 0,
+                    UA_DateTime maxBufferedTimeSec = 0,
+                    size_t pruneInterval = 1000,
+                    unsigned flushInterval = 100,
+                    size_t maxQueued = 65536);
+    ~SQLiteHistorian() override;
+
+    /** @return the storage of the historized values. */
+    SQLiteHistoryBackend& store() { return m_store; }
+};
+
+} // namespace Open62541
+
+#endif // SQLITEHISTORY_H
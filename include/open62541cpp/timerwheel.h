@@ -0,0 +1,131 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Open62541 {
+
+/**
+ * The TimerWheel class
+ * Hierarchical timer wheel, for many short-lived timeouts like per-request watchdogs or debounce timers.
+ * 4 levels of 256 slots: the first level holds the timers expiring in the next 256 ticks,
+ * each next level covers 256 times more. A timer moves down a level when its slot comes up.
+ * A timer due beyond the wheel, 2^32 ticks, waits in the top level until it is within range.
+ * Adding, cancelling and rescheduling a timer is O(1). The timers are nodes of a pool, reused once expired.
+ * Driven by advance(), typically from a single repeated call-back: see Server::enableTimerWheel().
+ * Not thread-safe: use it from the thread calling advance().
+ */
+class TimerWheel {
+public:
+    typedef uint64_t Id;                            /**< timer handle, 0 is invalid. Stale after expiry or cancel */
+    typedef std::function<void(Id)> Func;           /**< called when the timer expires */
+
+private:
+    static const unsigned Levels    = 4;
+    static const unsigned SlotBits  = 8;
+    static const unsigned Slots     = 1u << SlotBits;
+    static const uint32_t None      = 0xFFFFFFFFu;
+    static const uint32_t Firing    = Levels * Slots;       /**< list of the timers expiring at this tick */
+
+    struct Node {
+        Func        func;
+        uint64_t    expires     = 0;        /**< tick */
+        uint64_t    interval    = 0;        /**< ticks, 0 for a one-shot timer */
+        uint32_t    prev        = None;
+        uint32_t    next        = None;     /**< next in its list, or in the free list */
+        uint32_t    list        = None;     /**< list holding the node, None if free */
+        uint32_t    generation  = 0;        /**< incremented when released, so the old ids become stale */
+        bool        cancelled   = false;    /**< cancelled while its function runs */
+    };
+
+    std::vector<Node>       m_nodes;                        /**< pool */
+    std::vector<uint32_t>   m_heads;                        /**< first node of each slot list, then Firing */
+    uint32_t                m_free      = None;             /**< free list of the pool */
+    size_t                  m_active    = 0;
+    uint64_t                m_tickMs;
+    uint64_t                m_origin;                       /**< time of tick 0 in ms */
+    uint64_t                m_tick      = 0;                /**< current tick */
+    uint32_t                m_firing    = None;             /**< node whose function runs */
+
+    uint32_t allocate();
+    void release(uint32_t i);
+    void link(uint32_t i, uint32_t list);
+    void unlink(uint32_t i);
+    void schedule(uint32_t i);
+    void cascade(unsigned level);
+    Id add(uint64_t delay, uint64_t interval, Func&& func);
+    uint32_t find(Id id) const;
+    uint64_t ticks(uint64_t ms) const { uint64_t t = ms / m_tickMs + (ms % m_tickMs != 0); return t ? t : 1; }
+    uint64_t due(uint64_t t) const { return t < UINT64_MAX - m_tick ? m_tick + t : UINT64_MAX; }
+
+public:
+    /**
+     * @param tickMs resolution in ms. The timers expire at the first tick after their due time.
+     * @param nowMs current monotonic time in ms.
+     */
+    TimerWheel(unsigned tickMs = 10, uint64_t nowMs = 0);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * Add a one-shot timer.
+     * @param delayMs time until expiry in ms.
+     * @param func called once at expiry.
+     * @return the timer id.
+     */
+    Id addTimeout(uint64_t delayMs, Func func) { return add(delayMs, 0, std::move(func)); }
+
+    /**
+     * Add a repeated timer.
+     * @param intervalMs period in ms.
+     * @param func called at each expiry, until cancelled.
+     * @return the timer id.
+     */
+    Id addRepeated(uint64_t intervalMs, Func func) { return add(intervalMs, intervalMs, std::move(func)); }
+
+    /**
+     * Cancel a timer. Can be called by its own function.
+     * @return false if the id is stale: the timer expired or was already cancelled.
+     */
+    bool cancel(Id id);
+
+    /**
+     * Move the expiry of a pending timer, for example to kick a watchdog.
+     * @param id the timer.
+     * @param delayMs new time until expiry in ms.
+     * @return false if the id is stale.
+     */
+    bool reschedule(Id id, uint64_t delayMs);
+
+    /**
+     * Expire the timers due up to a given time, calling their functions in expiry order.
+     * @param nowMs current monotonic time in ms, as given to the constructor.
+     * @return the number of functions called.
+     */
+    size_t advance(uint64_t nowMs);
+
+    /** @return the number of pending timers */
+    size_t size() const { return m_active; }
+
+    /** @return the resolution in ms */
+    uint64_t tick() const { return m_tickMs; }
+};
+
+} // namespace Open62541
+
+#endif // TIMERWHEEL_H
@@ -0,0 +1,166 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#ifndef WRITEBEHINDHISTORY_H
+#define WRITEBEHINDHISTORY_H
+
+#include <open62541cpp/historydatabase.h>
+#include <open62541cpp/boundedqueue.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Open62541 {
+
+/**
+ * The WriteBehindHistoryBackend class
+ * Moves the storage of the historized values out of the write service:
+ * the samples are copied into a lock-free queue, and a background thread hands them
+ * to the wrapped backend in batches, every flushInterval ms or as soon as the queue
+ * is half full. A slow backend (a SQLite file on a busy disk) no longer delays the writes.
+ * The queue holds at most maxQueued samples: beyond it, the samples are stored
+ * synchronously, after the pending ones, so none is lost and the memory stays bounded.
+ * Reads store the pending samples first: they see every sample written before them.
+ * The raw reads are only offered through getHistoryData(), served in one call under the lock:
+ * no drain runs between the index lookups and the copy of the values. A wrapped backend with
+ * only the low level hooks is read through them by readIndexed().
+ * Each drain can be wrapped in a batch, one transaction of a database: see setBatch().
+ * The wrapped backend is only called by one thread at a time. The queued samples
+ * are stored without their session: the backend must not depend on it.
+ * Takes ownership of the wrapped backend, released by deleteMembers().
+ * @see Historian::enableWriteBehind()
+ */
+class WriteBehindHistoryBackend : public HistoryDataBackend
+{
+public:
+    /** Counters, read without lock */
+    struct Stats {
+        uint64_t queued      = 0;   /**< samples stored from the queue */
+        uint64_t synchronous = 0;   /**< samples stored by the writer, the queue being full */
+        uint64_t batches     = 0;   /**< queue drains storing at least one sample */
+        uint64_t failed      = 0;   /**< samples the backend refused */
+        size_t   depth       = 0;   /**< samples waiting */
+    };
+
+    /** Starts or ends a batch, under the lock of the wrapped backend */
+    typedef std::function<UA_StatusCode()> BatchHook;
+
+private:
+    struct Sample;  // defined in writebehindhistory.cpp
+
+    UA_HistoryDataBackend               m_backend;              /**< the wrapped backend, owned */
+    BoundedQueue<Sample*>               m_queue;
+    std::chrono::milliseconds           m_flushInterval;
+    std::mutex                          m_backendMutex;         /**< serialises the backend calls */
+    std::mutex                          m_wakeMutex;
+    std::condition_variable             m_wake;
+    bool                                m_stop = false;         /**< guarded by m_wakeMutex */
+    std::thread                         m_thread;
+    BatchHook                           m_beginBatch;           /**< guarded by m_backendMutex */
+    BatchHook                           m_endBatch;
+
+    std::atomic<uint64_t>               m_queued{0};
+    std::atomic<uint64_t>               m_synchronous{0};
+    std::atomic<uint64_t>               m_batches{0};
+    std::atomic<uint64_t>               m_failed{0};
+
+    void            run();
+    size_t          drain();    // call holding m_backendMutex
+    UA_StatusCode   store(UA_Server* server, const UA_NodeId* node, bool historizing, const UA_DataValue* value);
+
+    template <typename R, typename Hook, typename... Args>
+    R call(Context& context, Hook UA_HistoryDataBackend::*hook, R fallback, Args... args);
+    template <typename R, typename Hook, typename... Args>
+    R forward(Context& context, Hook UA_HistoryDataBackend::*hook, R fallback, Args... args);
+
+    UA_StatusCode readIndexed(
+        Context&            context,
+        UA_DateTime         start,
+        UA_DateTime         end,
+        size_t              maxSizePerResponse,
+        UA_UInt32           numValuesPerNode,
+        UA_Boolean          returnBounds,
+        UA_NumericRange     range,
+        const std::string&  continuationPoint,
+        std::string&        outContinuationPoint,
+        UA_HistoryData*     result);  // call holding m_backendMutex
+
+public:
+    /**
+     * WriteBehindHistoryBackend
+     * @param backend the backend storing the values, released by this object.
+     * @param flushInterval maximum time in ms a sample waits in the queue, at least 1.
+     * @param maxQueued maximum number of samples in the queue, rounded up to a power of 2.
+     */
+    WriteBehindHistoryBackend(
+        const UA_HistoryDataBackend&    backend,
+        unsigned                        flushInterval   = 100,
+        size_t                          maxQueued       = 65536);
+    ~WriteBehindHistoryBackend() override;
+    WriteBehindHistoryBackend(const WriteBehindHistoryBackend&) = delete;
+    WriteBehindHistoryBackend& operator=(const WriteBehindHistoryBackend&) = delete;
+
+    /**
+     * Wrap each drain storing at least one sample in a batch: begin is called before
+     * the first sample, end after the last one, both holding the backend lock.
+     * If end fails, the samples of the batch are counted as failed.
+     * @param begin starts the batch, BEGIN of a SQLite transaction.
+     * @param end ends the batch, its COMMIT.
+     */
+    void setBatch(BatchHook begin, BatchHook end);
+
+    /** Store the pending samples now, in the calling thread. */
+    void flush();
+
+    /** @return a snapshot of the counters */
+    Stats stats() const;
+
+    /** Stop the background thread, store the pending samples and release the wrapped backend. */
+    void deleteMembers() override;
+
+    // HistoryDataBackend hooks, forwarded to the wrapped backend
+    UA_StatusCode serverSetHistoryData(
+        Context&            context,
+        bool                historizing,
+        const UA_DataValue* value) override;
+
+    UA_StatusCode getHistoryData(
+        Context&            context,
+        const UA_DateTime   start,
+        const UA_DateTime   end,
+        size_t              maxSizePerResponse,
+        UA_UInt32           numValuesPerNode,
+        UA_Boolean          returnBounds,
+        UA_TimestampsToReturn timestampsToReturn,
+        UA_NumericRange     range,
+        UA_Boolean          releaseContinuationPoints,
+        std::string&        continuationPoint,
+        std::string&        outContinuationPoint,
+        UA_HistoryData*     result) override;
+
+    UA_Boolean boundSupported(Context& context) override;
+    UA_Boolean timestampsToReturnSupported(Context& context, UA_TimestampsToReturn timestampsToReturn) override;
+
+    UA_StatusCode insertDataValue(Context& context, const UA_DataValue* value) override;
+    UA_StatusCode replaceDataValue(Context& context, const UA_DataValue* value) override;
+    UA_StatusCode updateDataValue(Context& context, const UA_DataValue* value) override;
+    UA_StatusCode removeDataValue(
+        Context&    context,
+        UA_DateTime startTimestamp,
+        UA_DateTime endTimestamp) override;
+};
+
+} // namespace Open62541
+
+#endif // WRITEBEHINDHISTORY_H
@@ -14,26 +14,38 @@
 namespace Open62541 {
 
 ClientRef& ClientCache::add(const std::string& endpoint) {
-    if (m_cache.find(endpoint) == m_cache.end()) {
-        m_cache[endpoint] = std::make_shared<Client>();
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto i = m_cache.find(endpoint);
+    if (i == m_cache.end()) {
+        i = m_cache.emplace(endpoint, std::make_shared<Client>()).first;
+        m_version++;
+        m_changed.notify_all();
     }
-    return m_cache[endpoint];
+    return i->second;
 }
 
 //*****************************************************************************
 
 void ClientCache::remove(const std::string& endpoint) {
-    if (auto a = find(endpoint)) {
-        a->disconnect();
-    }   
-    m_cache.erase(endpoint);
+    ClientRef removed; // released out of the lock
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        auto i = m_cache.find(endpoint);
+        if (i == m_cache.end()) return;
+        removed = i->second;
+        m_cache.erase(i);
+        m_version++;
+    }
+    m_changed.notify_all();
 }
 
 //*****************************************************************************
 
 Client* ClientCache::find(const std::string& endpoint) {
-    if (m_cache.find(endpoint) != m_cache.end()) {
-        return m_cache[endpoint].get();
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto i = m_cache.find(endpoint);
+    if (i != m_cache.end()) {
+        return i->second.get();
     }
     return nullptr;
 }
@@ -41,10 +53,37 @@ Client* ClientCache::find(const std::string& endpoint) {
 //*****************************************************************************
 
 void ClientCache::process() {
-    for (auto& client : m_cache) {
+    ClientMap clients;
+    snapshot(clients); // process() may add or remove clients
+    for (auto& client : clients) {
         if (client.second)
             client.second->process();
     }
 }
 
+//*****************************************************************************
+
+unsigned ClientCache::snapshot(ClientMap& clients) const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    clients = m_cache;
+    return m_version;
+}
+
+//*****************************************************************************
+
+bool ClientCache::waitForChange(unsigned version, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> l(m_mutex);
+    return m_changed.wait_for(l, timeout, [&] { return m_version != version; });
+}
+
+//*****************************************************************************
+
+void ClientCache::wake() {
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        m_version++;
+    }
+    m_changed.notify_all();
+}
+
 } // namespace Open62541
@@ -10,19 +10,56 @@
  * A PARTICULAR PURPOSE.
  */
 #include <open62541cpp/clientcachethread.h>
+#include <algorithm>
 
 namespace Open62541 {
 
+void ClientCacheThread::run(unsigned index) {
+    std::hash<std::string>  hash;
+    std::vector<ClientRef>  shard;
+    unsigned                version = ~m_cache.version(); // force the first snapshot
+
+    while (m_running) {
+        // refresh the clients of the shard when endpoints are added or removed
+        if (version != m_cache.version()) {
+            ClientMap clients;
+            version = m_cache.snapshot(clients);
+            shard.clear();
+            for (auto& client : clients) {
+                if (client.second && (hash(client.first) % m_workers) == index)
+                    shard.push_back(client.second);
+            }
+        }
+
+        // share the cycle between the clients, each one blocking on its own socket
+        uint32_t slice = shard.empty() ? m_interval
+                                       : std::max<uint32_t>(1, m_interval / uint32_t(shard.size()));
+        bool active = false;
+        for (auto& client : shard) {
+            if (!m_running) break;
+            if (client->runIterate(slice)) active = true;
+            client->process();
+        }
+
+        // nothing to wait for on the network, sleep until the cache changes
+        if (!active && m_running)
+            m_cache.waitForChange(version, std::chrono::milliseconds(m_interval));
+    }
+    shard.clear(); // removed clients are disconnected by this thread
+}
+
+//*****************************************************************************
+
 bool ClientCacheThread::start() {
+    if (m_running) return false;
+    m_running = true;
     try {
-        m_thread = std::thread([this] {
-            m_running = true;
-            while (m_running) {
-                m_cache.process();
-            }
-        });
+        for (unsigned i = 0; i < m_workers; i++) {
+            m_threads.emplace_back([this, i] { run(i); });
+        }
     }
     catch(...) {
+        stop();
         return false;
     }
     return true;
@@ -32,7 +69,12 @@ bool ClientCacheThread::start() {
 
 bool ClientCacheThread::stop() {
     m_running = false;
-    m_thread.join();
+    m_cache.wake();
+    for (auto& thread : m_threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+    m_threads.clear();
     return true;
 }
 
@@ -95,9 +95,18 @@ MonitoredItem* ClientSubscription::findMonitorItem(unsigned id) {
 //*****************************************************************************
 
 unsigned ClientSubscription::addMonitorNodeId(monitorItemFunc func, NodeId& node) {
+    return addMonitorNodeId(func, node, m_profile);
+}
+
+//*****************************************************************************
+
+unsigned ClientSubscription::addMonitorNodeId(
+    monitorItemFunc             func,
+    NodeId&                     node,
+    const DataChangeProfile&    profile) {
     auto pdc = new MonitoredItemDataChange(func, *this);
 
-    if (pdc->addDataChange(node)) {                   // make it notify on data change
+    if (pdc->addDataChange(node, profile)) {          // make it notify on data change
         return addMonitorItem(MonitoredItemRef(pdc)); // add to subscription set
     }
 
@@ -107,6 +116,39 @@ unsigned ClientSubscription::addMonitorNodeId(monitorItemFunc func, NodeId& node
 
 //*****************************************************************************
 
+size_t ClientSubscription::addMonitorNodeIds(
+    monitorItemFunc             func,
+    const std::vector<NodeId>&  nodes,
+    const DataChangeProfile&    profile,
+    std::vector<unsigned>&      ids,
+    std::vector<UA_StatusCode>& results,
+    UA_TimestampsToReturn       timestamp /*= UA_TIMESTAMPSTORETURN_BOTH*/) {
+    ids.assign(nodes.size(), 0);
+    results.assign(nodes.size(), UA_STATUSCODE_BADINTERNALERROR);
+    if (nodes.empty() || !m_client.client()) return 0;
+
+    std::vector<std::unique_ptr<MonitoredItemDataChange>> owned;
+    std::vector<MonitoredItemDataChange*> items;
+    owned.reserve(nodes.size());
+    items.reserve(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        owned.emplace_back(new MonitoredItemDataChange(func, *this));
+        items.push_back(owned.back().get());
+    }
+
+    const size_t created = MonitoredItemDataChange::addDataChanges(
+        items, nodes, profile, m_client.maxMonitoredItemsPerCall(), timestamp);
+
+    for (size_t i = 0; i < nodes.size(); i++) { // add to subscription set
+        results[i] = items[i]->lastError();
+        if (results[i] == UA_STATUSCODE_GOOD)
+            ids[i] = addMonitorItem(MonitoredItemRef(owned[i].release()));
+    }
+    return created; // the items not created are deleted with owned
+}
+
+//*****************************************************************************
+
 unsigned ClientSubscription::addEventMonitor(
     monitorEventFunc    func,
     NodeId&             node,
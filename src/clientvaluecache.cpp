@@ -0,0 +1,251 @@
+/*
+* Copyright (C) 2017 -  B. J. Hill
+*
+* This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+* redistribute it and/or modify it under the terms of the Mozilla Public
+* License v2.0 as stated in the LICENSE file provided with open62541.
+*
+* open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+* A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/clientvaluecache.h>
+
+namespace Open62541 {
+
+constexpr std::chrono::milliseconds ClientValueCache::AnyAge;
+
+//*****************************************************************************
+
+ClientValueCache::~ClientValueCache() {
+    std::vector<unsigned> keys;
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        for (auto& e : m_entries) keys.push_back(e.second->itemKey);
+        m_entries.clear();
+    }
+    for (unsigned key : keys) m_sub.deleteMonitorItem(key); // outside the lock, may wait for a notification
+}
+
+//*****************************************************************************
+
+void ClientValueCache::update(Entry& entry, UA_DataValue* value) {
+    if (!value) return;
+    std::lock_guard<std::mutex> l(m_mutex);
+    UA_DataValue_clear(&entry.value);
+    entry.value = *value; // shallow move, the notification value is not used afterward
+    UA_DataValue_init(value);
+    entry.updated = Clock::now();
+    entry.valid   = true;
+    m_stats.notifications++;
+}
+
+//*****************************************************************************
+
+bool ClientValueCache::add(const NodeId& node) {
+    return add(std::vector<NodeId>{node}) == 1;
+}
+
+//*****************************************************************************
+
+size_t ClientValueCache::add(const std::vector<NodeId>& nodes) {
+    std::vector<NodeId>                                   toAdd;
+    std::vector<EntryRef>                                 entries;
+    std::vector<std::unique_ptr<MonitoredItemDataChange>> owned;
+    std::vector<MonitoredItemDataChange*>                 items;
+    size_t                                                known = 0;
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        for (const auto& n : nodes) {
+            if (m_entries.count(n)) {
+                known++;
+                continue;
+            }
+            EntryRef e = std::make_shared<Entry>(n);
+            toAdd.push_back(n);
+            entries.push_back(e);
+            // each item updates its own entry
+            owned.emplace_back(new MonitoredItemDataChange(
+                [this, e](ClientSubscription&, UA_DataValue* value) { update(*e, value); }, m_sub));
+            items.push_back(owned.back().get());
+        }
+    }
+    if (items.empty()) return known;
+
+    MonitoredItemDataChange::addDataChanges(
+        items, toAdd, m_sub.dataChangeProfile(), m_sub.client().maxMonitoredItemsPerCall());
+
+    size_t added = known;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i]->lastError() != UA_STATUSCODE_GOOD) continue;
+        entries[i]->itemKey = m_sub.addMonitorItem(MonitoredItemRef(owned[i].release()));
+        std::lock_guard<std::mutex> l(m_mutex);
+        m_entries[entries[i]->node] = entries[i];
+        added++;
+    }
+    return added; // the items not created are deleted with owned
+}
+
+//*****************************************************************************
+
+bool ClientValueCache::remove(const NodeId& node) {
+    EntryRef e;
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        auto i = m_entries.find(node);
+        if (i == m_entries.end()) return false;
+        e = i->second;
+        m_entries.erase(i);
+    }
+    m_sub.deleteMonitorItem(e->itemKey);
+    return true;
+}
+
+//*****************************************************************************
+
+bool ClientValueCache::contains(const UA_NodeId& node) const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return m_entries.count(node) > 0;
+}
+
+//*****************************************************************************
+
+void ClientValueCache::invalidate() {
+    std::lock_guard<std::mutex> l(m_mutex);
+    for (auto& e : m_entries) {
+        e.second->valid = false;
+        UA_DataValue_clear(&e.second->value);
+    }
+}
+
+//*****************************************************************************
+
+bool ClientValueCache::lookup(
+    const UA_NodeId&            node,
+    std::chrono::milliseconds   maxAge,
+    UA_DataValue&               out) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto i = m_entries.find(node);
+    if (i != m_entries.end() && i->second->valid && maxAge.count() > 0 &&
+        (maxAge == AnyAge || Clock::now() - i->second->updated <= maxAge)) {
+        UA_DataValue_copy(&i->second->value, &out);
+        m_stats.hits++;
+        return true;
+    }
+    m_stats.misses++;
+    return false;
+}
+
+//*****************************************************************************
+
+/** @return the source timestamp of a value, else its server timestamp, else 0 */
+static UA_DateTime sampleTime(const UA_DataValue& value) {
+    if (value.hasSourceTimestamp) return value.sourceTimestamp;
+    if (value.hasServerTimestamp) return value.serverTimestamp;
+    return 0;
+}
+
+//*****************************************************************************
+
+void ClientValueCache::refresh(const UA_NodeId& node, const UA_DataValue& value) {
+    if (value.hasStatus && value.status != UA_STATUSCODE_GOOD) return;
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto i = m_entries.find(node);
+    if (i == m_entries.end()) return; // not subscribed
+    Entry& e = *i->second;
+    if (e.valid) {
+        // a notification may have been applied since the read: keep the newer value
+        const UA_DateTime read = sampleTime(value), cached = sampleTime(e.value);
+        if (read < cached || (read == cached && !read)) return; // older, or no way to tell
+        if (read == cached) { // same sample, still current at the time of the read
+            e.updated = Clock::now();
+            return;
+        }
+    }
+    UA_DataValue_clear(&e.value);
+    UA_DataValue_copy(&value, &e.value);
+    e.updated = Clock::now();
+    e.valid   = true;
+}
+
+//*****************************************************************************
+
+bool ClientValueCache::readValue(
+    const UA_NodeId&            node,
+    Variant&                    outValue,
+    std::chrono::milliseconds   maxAge) {
+    UA_DataValue v;
+    UA_DataValue_init(&v);
+    if (lookup(node, maxAge, v)) {
+        outValue.null();
+        *outValue.ref() = v.value; // move the variant, the data value is not cleared
+        UA_Variant_init(&v.value);
+        UA_DataValue_clear(&v);
+        return true;
+    }
+    // read with the source timestamp, to compare with the cached value in refresh()
+    ReadValueIdList toRead;
+    toRead.put(node);
+    DataValueList read;
+    if (!m_sub.client().readMany(toRead, read) || read.size() != 1) return false;
+    UA_DataValue& r = read[0];
+    if ((r.hasStatus && r.status != UA_STATUSCODE_GOOD) || !r.hasValue) return false;
+
+    refresh(node, r);
+    outValue.null();
+    *outValue.ref() = r.value; // shallow move
+    UA_Variant_init(&r.value);
+    return true;
+}
+
+//*****************************************************************************
+
+bool ClientValueCache::readValues(
+    const std::vector<NodeId>&  nodes,
+    DataValueList&              results,
+    std::chrono::milliseconds   maxAge) {
+    results.reset(nodes.size());
+
+    ReadValueIdList     toRead;
+    std::vector<size_t> positions; // of the values read from the server in the results
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!lookup(nodes[i], maxAge, results[i])) {
+            toRead.put(nodes[i]);
+            positions.push_back(i);
+        }
+    }
+    if (toRead.empty()) return true;
+
+    DataValueList read;
+    const bool ok = m_sub.client().readMany(toRead, read);
+    if (read.size() != positions.size()) { // no client: nothing read
+        for (size_t p : positions) {
+            results[p].hasStatus = true;
+            results[p].status    = UA_STATUSCODE_BADNOTCONNECTED;
+        }
+        return false;
+    }
+    for (size_t i = 0; i < positions.size(); i++) {
+        UA_DataValue& r = results[positions[i]];
+        r = read[i]; // shallow move, read keeps nothing
+        UA_DataValue_init(&read[i]);
+        if (ok) refresh(nodes[positions[i]], r);
+    }
+    return ok;
+}
+
+//*****************************************************************************
+
+ClientValueCache::Stats ClientValueCache::stats() const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return m_stats;
+}
+
+//*****************************************************************************
+
+void ClientValueCache::resetStats() {
+    std::lock_guard<std::mutex> l(m_mutex);
+    m_stats = Stats();
+}
+
+} // namespace Open62541
@@ -0,0 +1,533 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/columnarhistory.h>
+#include <algorithm>
+#include <cstring>
+
+namespace Open62541 {
+
+/**
+ * The history of one node, as ring buffers of columns.
+ * A sample is addressed by its logical index, 0 being the oldest,
+ * mapped by at() to its physical position in the columns.
+ */
+struct ColumnarHistoryBackend::Series {
+    enum : UA_Byte { HasValue = 1 };
+
+    UA_NodeId                   node;               /**< owned, key of the series map */
+    const size_t                capacity;           /**< maximum number of samples */
+    size_t                      head    = 0;        /**< physical position of the oldest sample */
+    size_t                      count   = 0;        /**< number of samples */
+    const UA_DataType*          type    = nullptr;  /**< type of the inline values, null until the first one */
+    bool                        boxed   = false;    /**< values stored as variants */
+    std::vector<UA_DateTime>    times;
+    std::vector<UA_StatusCode>  status;
+    std::vector<UA_Byte>        flags;
+    std::vector<UA_Byte>        values;             /**< inline values, type->memSize bytes each */
+    std::vector<UA_Variant>     variants;           /**< owned values, when boxed */
+
+    Series(const UA_NodeId& n, size_t maxValues) : capacity(std::max<size_t>(maxValues, 1)) {
+        UA_NodeId_copy(&n, &node);
+    }
+
+    ~Series() {
+        for (UA_Variant& v : variants) UA_Variant_clear(&v);
+        UA_NodeId_clear(&node);
+    }
+
+    size_t allocated() const { return times.size(); }
+
+    size_t at(size_t i) const {
+        size_t p = head + i;
+        return p >= allocated() ? p - allocated() : p;
+    }
+
+    UA_DateTime time(size_t i) const { return times[at(i)]; }
+
+    /** @return the index of the first sample at or after t, count if none */
+    size_t lowerBound(UA_DateTime t) const {
+        size_t first = 0, n = count;
+        while (n > 0) {
+            size_t half = n / 2;
+            if (time(first + half) < t) { first += half + 1; n -= half + 1; }
+            else n = half;
+        }
+        return first;
+    }
+
+    /** @return the index of the first sample after t, count if none */
+    size_t upperBound(UA_DateTime t) const {
+        size_t first = 0, n = count;
+        while (n > 0) {
+            size_t half = n / 2;
+            if (!(t < time(first + half))) { first += half + 1; n -= half + 1; }
+            else n = half;
+        }
+        return first;
+    }
+
+    /** @return true if the value can be stored inline */
+    bool fitsInline(const UA_DataValue& v) const {
+        if (!v.hasValue || !v.value.type) return true;
+        return UA_Variant_isScalar(&v.value)
+            && v.value.type->pointerFree
+            && (!type || type == v.value.type);
+    }
+
+    /** Switch the value column from inline values to variants. */
+    void box() {
+        std::vector<UA_Variant> boxes(allocated());
+        for (size_t i = 0; i < count; i++) {
+            size_t p = at(i);
+            if (flags[p] & HasValue)
+                UA_Variant_setScalarCopy(&boxes[p], &values[p * type->memSize], type);
+        }
+        variants.swap(boxes);
+        std::vector<UA_Byte>().swap(values);
+        boxed = true;
+    }
+
+    /** Make the columns linear and large enough for one more sample. */
+    void reserveOne() {
+        if (count < allocated()) return;
+        if (head) {
+            std::rotate(times.begin(),  times.begin() + head,  times.end());
+            std::rotate(status.begin(), status.begin() + head, status.end());
+            std::rotate(flags.begin(),  flags.begin() + head,  flags.end());
+            if (boxed)
+                std::rotate(variants.begin(), variants.begin() + head, variants.end());
+            else if (type)
+                std::rotate(values.begin(), values.begin() + head * type->memSize, values.end());
+            head = 0;
+        }
+        size_t n = std::min(capacity, std::max<size_t>(16, allocated() * 2));
+        times.resize(n);
+        status.resize(n);
+        flags.resize(n);
+        if (boxed) variants.resize(n); // zero is an empty variant
+        else if (type) values.resize(n * type->memSize);
+    }
+
+    /** Shallow move of a sample, the source position becomes free. */
+    void move(size_t from, size_t to) {
+        times[to]  = times[from];
+        status[to] = status[from];
+        flags[to]  = flags[from];
+        if (boxed) variants[to] = variants[from];
+        else if (type) memcpy(&values[to * type->memSize], &values[from * type->memSize], type->memSize);
+    }
+
+    /** Store a sample at a free physical position. Call fitsInline()/box() before. */
+    void store(size_t p, const UA_DataValue& v, UA_DateTime t) {
+        times[p]  = t;
+        status[p] = v.hasStatus ? v.status : UA_STATUSCODE_GOOD;
+        flags[p]  = 0;
+        if (!v.hasValue || !v.value.type) {
+            if (boxed) UA_Variant_init(&variants[p]);
+            return;
+        }
+        flags[p] = HasValue;
+        if (boxed) {
+            UA_Variant_copy(&v.value, &variants[p]);
+            return;
+        }
+        if (!type) {
+            type = v.value.type;
+            values.resize(allocated() * type->memSize);
+        }
+        memcpy(&values[p * type->memSize], v.value.data, type->memSize);
+    }
+
+    void clearValue(size_t p) {
+        if (boxed) UA_Variant_clear(&variants[p]);
+    }
+
+    /**
+     * Insert a sample after the samples with the same time stamp.
+     * @return false if the history is full and the sample is older than all of it.
+     */
+    bool insert(const UA_DataValue& v, UA_DateTime t) {
+        if (!boxed && !fitsInline(v)) box();
+        size_t pos = upperBound(t);
+        if (count == capacity) {
+            if (pos == 0) return false;
+            clearValue(at(0)); // drop the oldest
+            head = at(1);
+            count--;
+            pos--;
+        }
+        reserveOne();
+        for (size_t i = count; i > pos; i--)
+            move(at(i - 1), at(i));
+        count++;
+        store(at(pos), v, t);
+        return true;
+    }
+
+    /** Replace the sample at index i, keeping its time stamp. */
+    void replace(size_t i, const UA_DataValue& v) {
+        if (!boxed && !fitsInline(v)) box();
+        size_t p = at(i);
+        UA_DateTime t = times[p];
+        clearValue(p);
+        store(p, v, t);
+    }
+
+    /** Remove the samples of indexes [first, last). */
+    void remove(size_t first, size_t last) {
+        size_t n = last - first;
+        if (!n) return;
+        for (size_t i = first; i < last; i++)
+            clearValue(at(i));
+        for (size_t i = last; i < count; i++)
+            move(at(i), at(i - n));
+        if (boxed) {
+            for (size_t i = count - n; i < count; i++)
+                UA_Variant_init(&variants[at(i)]); // moved away
+        }
+        count -= n;
+    }
+
+    /**
+     * Materialise the sample at index i.
+     * @param[out] dv receives the sample, deep copied.
+     * @param range the numeric range to copy, if any.
+     * @return UA_STATUSCODE_GOOD on success.
+     */
+    UA_StatusCode get(size_t i, UA_DataValue& dv, const UA_NumericRange& range) const {
+        size_t p = at(i);
+        if (flags[p] & HasValue) {
+            UA_Variant src;
+            if (boxed) src = variants[p];
+            else UA_Variant_setScalar(&src, const_cast<UA_Byte*>(&values[p * type->memSize]), type);
+
+            UA_StatusCode ret = range.dimensionsSize > 0
+                ? UA_Variant_copyRange(&src, &dv.value, range)
+                : UA_Variant_copy(&src, &dv.value);
+            if (ret != UA_STATUSCODE_GOOD) return ret;
+            dv.hasValue = true;
+        }
+        dv.status               = status[p];
+        dv.hasStatus            = status[p] != UA_STATUSCODE_GOOD;
+        dv.sourceTimestamp      = times[p];
+        dv.hasSourceTimestamp   = true;
+        dv.serverTimestamp      = times[p];
+        dv.hasServerTimestamp   = true;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    size_t memoryUsage() const {
+        return times.capacity()    * sizeof(UA_DateTime)
+             + status.capacity()   * sizeof(UA_StatusCode)
+             + flags.capacity()
+             + values.capacity()
+             + variants.capacity() * sizeof(UA_Variant);
+    }
+};
+
+//*****************************************************************************
+
+/**
+ * @return the time stamp indexing a sample: source, else server, else now.
+ */
+static UA_DateTime sampleTime(const UA_DataValue& v) {
+    if (v.hasSourceTimestamp) return v.sourceTimestamp;
+    if (v.hasServerTimestamp) return v.serverTimestamp;
+    return UA_DateTime_now();
+}
+
+//*****************************************************************************
+
+ColumnarHistoryBackend::ColumnarHistoryBackend(size_t maxValuesPerNode)
+    : m_maxValuesPerNode(maxValuesPerNode) {
+    UA_DataValue_init(&m_scratch[0]);
+    UA_DataValue_init(&m_scratch[1]);
+    initialise();
+    database().getHistoryData = nullptr; // use the low level API
+}
+
+//*****************************************************************************
+
+ColumnarHistoryBackend::~ColumnarHistoryBackend() {
+    UA_DataValue_clear(&m_scratch[0]);
+    UA_DataValue_clear(&m_scratch[1]);
+}
+
+//*****************************************************************************
+
+ColumnarHistoryBackend::Series* ColumnarHistoryBackend::find(const UA_NodeId& node) const {
+    auto i = m_series.find(node);
+    return i == m_series.end() ? nullptr : i->second.get();
+}
+
+//*****************************************************************************
+
+ColumnarHistoryBackend::Series& ColumnarHistoryBackend::series(const UA_NodeId& node) {
+    if (Series* s = find(node)) return *s;
+
+    std::unique_ptr<Series> s(new Series(node, m_maxValuesPerNode));
+    Series& r = *s;
+    m_series.emplace(r.node, std::move(s)); // keyed by the series copy of the node id
+    return r;
+}
+
+//*****************************************************************************
+
+size_t ColumnarHistoryBackend::size(const UA_NodeId& node) const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(node);
+    return s ? s->count : 0;
+}
+
+size_t ColumnarHistoryBackend::nodes() const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return m_series.size();
+}
+
+size_t ColumnarHistoryBackend::memoryUsage() const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    size_t n = 0;
+    for (const auto& s : m_series) n += s.second->memoryUsage();
+    return n;
+}
+
+//*****************************************************************************
+
+void ColumnarHistoryBackend::clear(const UA_NodeId& node) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto i = m_series.find(node);
+    if (i == m_series.end()) return;
+
+    std::unique_ptr<Series> s = std::move(i->second);
+    m_series.erase(i); // before the key owner is destroyed
+}
+
+//*****************************************************************************
+
+UA_StatusCode ColumnarHistoryBackend::serverSetHistoryData(
+    Context&            context,
+    bool              /*historizing*/,
+    const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    std::lock_guard<std::mutex> l(m_mutex);
+    series(context.nodeId).insert(*value, sampleTime(*value));
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+size_t ColumnarHistoryBackend::getDateTimeMatch(
+    Context&            context,
+    const UA_DateTime   timestamp,
+    const MatchStrategy strategy) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    if (!s || !s->count) return 0;
+
+    const size_t end = s->count;
+    size_t i = end;
+    switch (strategy) {
+    case MATCH_EQUAL:
+        i = s->lowerBound(timestamp);
+        if (i < end && s->time(i) != timestamp) i = end;
+        break;
+    case MATCH_AFTER:
+        i = s->upperBound(timestamp);
+        break;
+    case MATCH_EQUAL_OR_AFTER:
+        i = s->lowerBound(timestamp);
+        break;
+    case MATCH_BEFORE:
+        i = s->lowerBound(timestamp);
+        i = i ? i - 1 : end;
+        break;
+    case MATCH_EQUAL_OR_BEFORE:
+        i = s->upperBound(timestamp);
+        i = i ? i - 1 : end;
+        break;
+    }
+    return i;
+}
+
+//*****************************************************************************
+
+size_t ColumnarHistoryBackend::getEnd(Context& context) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    return s ? s->count : 0;
+}
+
+size_t ColumnarHistoryBackend::lastIndex(Context& context) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    return (s && s->count) ? s->count - 1 : 0;
+}
+
+size_t ColumnarHistoryBackend::firstIndex(Context& /*context*/) {
+    return 0;
+}
+
+//*****************************************************************************
+
+size_t ColumnarHistoryBackend::resultSize(Context& context, size_t startIndex, size_t endIndex) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    if (!s || startIndex >= s->count || endIndex >= s->count) return 0;
+    return (startIndex <= endIndex ? endIndex - startIndex : startIndex - endIndex) + 1;
+}
+
+//*****************************************************************************
+
+UA_StatusCode ColumnarHistoryBackend::copyDataValues(
+    Context&        context,
+    size_t          startIndex,
+    size_t          endIndex,
+    UA_Boolean      reverse,
+    size_t          valueSize,
+    UA_NumericRange range,
+    UA_Boolean    /*releaseContinuationPoints*/,
+    std::string&  /*in*/,
+    std::string&  /*out*/,
+    size_t*         providedValues,
+    UA_DataValue*   values) {
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    size_t n = 0;
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    if (s && startIndex < s->count && endIndex < s->count) {
+        // only the samples of the window are materialised
+        if (reverse) {
+            for (size_t i = startIndex; n < valueSize && i >= endIndex; i--) {
+                ret = s->get(i, values[n], range);
+                if (ret != UA_STATUSCODE_GOOD) break;
+                n++;
+                if (!i) break;
+            }
+        }
+        else {
+            for (size_t i = startIndex; n < valueSize && i <= endIndex; i++) {
+                ret = s->get(i, values[n], range);
+                if (ret != UA_STATUSCODE_GOOD) break;
+                n++;
+            }
+        }
+    }
+    if (providedValues) *providedValues = n;
+    return ret;
+}
+
+//*****************************************************************************
+
+const UA_DataValue* ColumnarHistoryBackend::getDataValue(Context& context, size_t index) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    if (!s || index >= s->count) return nullptr;
+
+    UA_DataValue& dv = m_scratch[m_nextScratch];
+    m_nextScratch ^= 1;
+    UA_DataValue_clear(&dv);
+    UA_NumericRange none{0, nullptr};
+    return s->get(index, dv, none) == UA_STATUSCODE_GOOD ? &dv : nullptr;
+}
+
+//*****************************************************************************
+
+UA_Boolean ColumnarHistoryBackend::boundSupported(Context& /*context*/) {
+    return UA_TRUE;
+}
+
+UA_Boolean ColumnarHistoryBackend::timestampsToReturnSupported(
+    Context&              /*context*/,
+    UA_TimestampsToReturn   timestampsToReturn) {
+    return timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE
+        || timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER
+        || timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH;
+}
+
+//*****************************************************************************
+
+UA_StatusCode ColumnarHistoryBackend::insertDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    const UA_DateTime t = sampleTime(*value);
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series& s = series(context.nodeId);
+    size_t i = s.lowerBound(t);
+    if (i < s.count && s.time(i) == t) return UA_STATUSCODE_BADENTRYEXISTS;
+    s.insert(*value, t);
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+UA_StatusCode ColumnarHistoryBackend::replaceDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    const UA_DateTime t = sampleTime(*value);
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    if (!s) return UA_STATUSCODE_BADNOENTRYEXISTS;
+    size_t i = s->lowerBound(t);
+    if (i == s->count || s->time(i) != t) return UA_STATUSCODE_BADNOENTRYEXISTS;
+    s->replace(i, *value);
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+UA_StatusCode ColumnarHistoryBackend::updateDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    const UA_DateTime t = sampleTime(*value);
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series& s = series(context.nodeId);
+    size_t i = s.lowerBound(t);
+    if (i < s.count && s.time(i) == t) s.replace(i, *value);
+    else s.insert(*value, t);
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+UA_StatusCode ColumnarHistoryBackend::removeDataValue(
+    Context&    context,
+    UA_DateTime startTimestamp,
+    UA_DateTime endTimestamp) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    if (!s) return UA_STATUSCODE_BADNODATA;
+
+    size_t first = s->lowerBound(startTimestamp);
+    size_t last  = s->upperBound(endTimestamp);
+    if (first >= last) return UA_STATUSCODE_BADNODATA;
+    s->remove(first, last);
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+ColumnarHistorian::ColumnarHistorian(size_t numberNodes, size_t maxValuesPerNode)
+    : m_store(maxValuesPerNode) {
+    gathering() = UA_HistoryDataGathering_Default(numberNodes);
+    database()  = UA_HistoryDatabase_default(gathering());
+    backend()   = m_store.database();
+    enableReadProcessed();
+}
+
+//*****************************************************************************
+
+ColumnarHistorian::~ColumnarHistorian() {
+    releaseStore(); // m_store is destroyed before ~Historian() releases the backend
+}
+
+} // namespace Open62541
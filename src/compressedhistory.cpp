@@ -0,0 +1,578 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/compressedhistory.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace Open62541 {
+
+/** A bit stream, most significant bits first. */
+struct BitStream {
+    std::vector<UA_UInt64>  words;
+    size_t                  size = 0;   /**< in bits */
+
+    /** Append the n low bits of v, 1 <= n <= 64. */
+    void write(UA_UInt64 v, unsigned n) {
+        if (n < 64) v &= (UA_UInt64(1) << n) - 1;
+        const unsigned used = size % 64;
+        if (!used) words.push_back(0);
+        const unsigned room = 64 - used;
+        if (n <= room) {
+            words.back() |= v << (room - n);
+        }
+        else {
+            words.back() |= v >> (n - room);
+            words.push_back(v << (64 - (n - room)));
+        }
+        size += n;
+    }
+};
+
+/** Reads a BitStream. */
+struct BitReader {
+    const UA_UInt64*    words;
+    size_t              pos = 0;
+
+    explicit BitReader(const BitStream& s) : words(s.words.data()) {}
+
+    /** @return the next n bits, 1 <= n <= 64. */
+    UA_UInt64 read(unsigned n) {
+        const UA_UInt64* w  = words + pos / 64;
+        const unsigned used = pos % 64;
+        const unsigned room = 64 - used;
+        UA_UInt64 v = (w[0] << used) >> (64 - n);
+        if (n > room) v |= w[1] >> (64 - (n - room));
+        pos += n;
+        return v;
+    }
+
+    bool bit() { return read(1) != 0; }
+};
+
+static unsigned leadingZeros(UA_UInt64 v) {
+#if defined(__GNUC__)
+    return v ? unsigned(__builtin_clzll(v)) : 64;
+#else
+    unsigned n = 0;
+    for (UA_UInt64 m = UA_UInt64(1) << 63; m && !(v & m); m >>= 1) n++;
+    return n;
+#endif
+}
+
+static unsigned trailingZeros(UA_UInt64 v) {
+#if defined(__GNUC__)
+    return v ? unsigned(__builtin_ctzll(v)) : 64;
+#else
+    unsigned n = 0;
+    for (UA_UInt64 m = 1; m && !(v & m); m <<= 1) n++;
+    return n;
+#endif
+}
+
+/**
+ * Delta of delta buckets, in 100 ns ticks: the prefix 0 codes a regular sample,
+ * 10, 110 and 1110 a zigzag encoded difference of 16 bits (3.2 ms), 24 bits (0.8 s)
+ * and 32 bits (3.5 mn), 1111 a full 64 bits one.
+ */
+static const unsigned DodBits[] = { 16, 24, 32, 64 };
+
+//*****************************************************************************
+
+/** A run of samples with the same status code. */
+struct StatusRun {
+    UA_StatusCode   status;
+    bool            hasValue;
+    UA_UInt32       length;
+};
+
+/**
+ * The compressed samples of a node. The time of the first sample is kept aside,
+ * its value written in full, the next ones encoded against their predecessor.
+ */
+struct CompressedHistoryBackend::Block {
+    UA_DateTime             first = 0;  /**< time of the first sample */
+    UA_DateTime             last  = 0;  /**< time of the last sample */
+    size_t                  count = 0;
+    BitStream               bits;
+    std::vector<StatusRun>  runs;
+
+    size_t memoryUsage() const {
+        return sizeof(Block) + bits.words.capacity() * sizeof(UA_UInt64)
+             + runs.capacity() * sizeof(StatusRun);
+    }
+};
+
+/**
+ * The blocks of a node, in time order. All but the last hold samplesPerBlock samples:
+ * sample i is in blocks[i / samplesPerBlock].
+ */
+struct CompressedHistoryBackend::Series {
+    UA_NodeId               node;               /**< owned, key of the series map */
+    const UA_DataType*      type = nullptr;     /**< of the values, set by the first one */
+    std::deque<Block>       blocks;
+    size_t                  count = 0;          /**< number of samples */
+    size_t                  firstSequence = 0;  /**< sequence number of blocks[0] */
+
+    // encoder state of the last block
+    UA_DateTime             delta = 0;          /**< between the last two samples */
+    UA_UInt64               value = 0;          /**< the last value */
+    unsigned                leading  = 64;      /**< window of the last encoded XOR, none yet */
+    unsigned                trailing = 0;
+
+    // the last decoded block
+    size_t                  decodedSequence = SIZE_MAX;
+    std::vector<UA_DateTime> times;
+    std::vector<UA_UInt64>  values;
+    std::vector<StatusRun>  status;             /**< one single sample run per sample */
+
+    explicit Series(const UA_NodeId& n) { UA_NodeId_copy(&n, &node); }
+    ~Series() { UA_NodeId_clear(&node); }
+
+    void encode(Block& b, UA_DateTime time, UA_UInt64 v) {
+        if (!b.count) {
+            b.first = time;
+            b.bits.write(v, 64);
+            delta    = 0;
+            leading  = 64;
+            trailing = 0;
+        }
+        else {
+            // time stamp
+            const UA_DateTime d = time - b.last;
+            const UA_UInt64 dod = UA_UInt64(d) - UA_UInt64(delta);
+            const UA_UInt64 zz  = (dod << 1) ^ UA_UInt64(UA_DateTime(dod) >> 63);
+            if (!zz) {
+                b.bits.write(0, 1);
+            }
+            else {
+                unsigned k = 0;
+                while (DodBits[k] < 64 && zz >> DodBits[k]) k++;
+                if (k < 3) b.bits.write((UA_UInt64(1) << (k + 2)) - 2, k + 2); // 10, 110, 1110
+                else b.bits.write(15, 4);
+                b.bits.write(zz, DodBits[k]);
+            }
+            delta = d;
+
+            // value
+            const UA_UInt64 x = v ^ value;
+            if (!x) {
+                b.bits.write(0, 1);
+            }
+            else {
+                const unsigned lz = leadingZeros(x);
+                const unsigned tz = trailingZeros(x);
+                if (lz >= leading && tz >= trailing) {
+                    b.bits.write(2, 2); // 10: in the previous window
+                    b.bits.write(x >> trailing, 64 - leading - trailing);
+                }
+                else {
+                    const unsigned length = 64 - lz - tz;
+                    b.bits.write(3, 2); // 11: new window
+                    b.bits.write(lz, 6);
+                    b.bits.write(length - 1, 6);
+                    b.bits.write(x >> tz, length);
+                    leading  = lz;
+                    trailing = tz;
+                }
+            }
+        }
+        value  = v;
+        b.last = time;
+        b.count++;
+    }
+
+    /** Decode a block into times, values and status. */
+    void decode(size_t k) {
+        const size_t sequence = firstSequence + k;
+        if (decodedSequence == sequence) return;
+
+        const Block& b = blocks[k];
+        times.resize(b.count);
+        values.resize(b.count);
+        status.resize(b.count);
+
+        BitReader r(b.bits);
+        UA_DateTime t = b.first, d = 0;
+        UA_UInt64 v = r.read(64);
+        unsigned lz = 64, tz = 0;
+        times[0]  = t;
+        values[0] = v;
+        for (size_t i = 1; i < b.count; i++) {
+            if (r.bit()) {
+                unsigned bucket = 0;
+                while (bucket < 3 && r.bit()) bucket++;
+                const UA_UInt64 zz = r.read(DodBits[bucket]);
+                d += UA_DateTime((zz >> 1) ^ (UA_UInt64(0) - (zz & 1)));
+            }
+            t += d;
+
+            if (r.bit()) {
+                if (r.bit()) {
+                    lz = unsigned(r.read(6));
+                    tz = 64 - lz - (unsigned(r.read(6)) + 1);
+                }
+                v ^= r.read(64 - lz - tz) << tz;
+            }
+            times[i]  = t;
+            values[i] = v;
+        }
+
+        size_t i = 0;
+        for (const StatusRun& run : b.runs) {
+            for (UA_UInt32 j = 0; j < run.length; j++, i++)
+                status[i] = StatusRun{run.status, run.hasValue, 1};
+        }
+        decodedSequence = sequence;
+    }
+
+    size_t memoryUsage() const {
+        size_t n = sizeof(Series);
+        for (const Block& b : blocks) n += b.memoryUsage();
+        return n;
+    }
+};
+
+//*****************************************************************************
+
+/** @return the time stamp indexing a sample: source, else server, else now. */
+static UA_DateTime sampleTime(const UA_DataValue& v) {
+    if (v.hasSourceTimestamp) return v.sourceTimestamp;
+    if (v.hasServerTimestamp) return v.serverTimestamp;
+    return UA_DateTime_now();
+}
+
+//*****************************************************************************
+
+CompressedHistoryBackend::CompressedHistoryBackend(size_t samplesPerBlock, size_t maxValuesPerNode)
+    : m_samplesPerBlock(std::max<size_t>(samplesPerBlock, 2))
+    , m_maxValuesPerNode(maxValuesPerNode) {
+    UA_DataValue_init(&m_scratch[0]);
+    UA_DataValue_init(&m_scratch[1]);
+    initialise();
+    database().getHistoryData = nullptr; // use the low level API
+}
+
+//*****************************************************************************
+
+CompressedHistoryBackend::~CompressedHistoryBackend() {
+    UA_DataValue_clear(&m_scratch[0]);
+    UA_DataValue_clear(&m_scratch[1]);
+}
+
+//*****************************************************************************
+
+CompressedHistoryBackend::Series* CompressedHistoryBackend::find(const UA_NodeId& node) const {
+    auto i = m_series.find(node);
+    return i == m_series.end() ? nullptr : i->second.get();
+}
+
+//*****************************************************************************
+
+CompressedHistoryBackend::Series& CompressedHistoryBackend::series(const UA_NodeId& node) {
+    if (Series* s = find(node)) return *s;
+
+    std::unique_ptr<Series> s(new Series(node));
+    Series& r = *s;
+    m_series.emplace(r.node, std::move(s)); // keyed by the series copy of the node id
+    return r;
+}
+
+//*****************************************************************************
+
+UA_StatusCode CompressedHistoryBackend::append(Series& s, const UA_DataValue& value) {
+    const UA_DateTime time = sampleTime(value);
+    if (s.count && time < s.blocks.back().last) return UA_STATUSCODE_BADOUTOFRANGE;
+
+    UA_UInt64 v = s.value; // no value: repeat the last one, a single bit
+    const bool hasValue = value.hasValue && value.value.type;
+    if (hasValue) {
+        const UA_DataType* t = value.value.type;
+        if (!UA_Variant_isScalar(&value.value)
+            || !t->pointerFree
+            || t->memSize > sizeof(v)
+            || (s.type && s.type != t))
+            return UA_STATUSCODE_BADTYPEMISMATCH;
+        v = 0;
+        memcpy(&v, value.value.data, t->memSize);
+        s.type = t;
+    }
+    const UA_StatusCode status = value.hasStatus ? value.status : UA_STATUSCODE_GOOD;
+
+    if (s.blocks.empty() || s.blocks.back().count == m_samplesPerBlock) {
+        if (!s.blocks.empty()) {
+            s.blocks.back().bits.words.shrink_to_fit();
+            s.blocks.back().runs.shrink_to_fit();
+        }
+        s.blocks.emplace_back();
+        if (m_maxValuesPerNode && s.count - s.blocks.front().count >= m_maxValuesPerNode) {
+            s.count -= s.blocks.front().count;
+            s.blocks.pop_front();
+            s.firstSequence++;
+        }
+    }
+
+    Block& b = s.blocks.back();
+    if (s.decodedSequence == s.firstSequence + s.blocks.size() - 1)
+        s.decodedSequence = SIZE_MAX; // the cached block grows
+    s.encode(b, time, v);
+    if (!b.runs.empty() && b.runs.back().status == status && b.runs.back().hasValue == hasValue)
+        b.runs.back().length++;
+    else
+        b.runs.push_back(StatusRun{status, hasValue, 1});
+    s.count++;
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+UA_StatusCode CompressedHistoryBackend::get(
+    Series&                 s,
+    size_t                  index,
+    UA_DataValue&           dv,
+    const UA_NumericRange&  range) {
+    if (index >= s.count) return UA_STATUSCODE_BADNOENTRYEXISTS;
+
+    s.decode(index / m_samplesPerBlock);
+    const size_t i = index % m_samplesPerBlock;
+    if (s.status[i].hasValue && s.type) {
+        UA_Variant src;
+        UA_Variant_setScalar(&src, &s.values[i], s.type);
+        UA_StatusCode ret = range.dimensionsSize > 0
+            ? UA_Variant_copyRange(&src, &dv.value, range)
+            : UA_Variant_copy(&src, &dv.value);
+        if (ret != UA_STATUSCODE_GOOD) return ret;
+        dv.hasValue = true;
+    }
+    dv.status               = s.status[i].status;
+    dv.hasStatus            = dv.status != UA_STATUSCODE_GOOD;
+    dv.sourceTimestamp      = s.times[i];
+    dv.hasSourceTimestamp   = true;
+    dv.serverTimestamp      = s.times[i];
+    dv.hasServerTimestamp   = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+size_t CompressedHistoryBackend::bound(Series& s, UA_DateTime timestamp, bool after) {
+    // blocks ending before the bound are skipped without decoding
+    auto j = after
+        ? std::upper_bound(s.blocks.begin(), s.blocks.end(), timestamp,
+                           [](UA_DateTime t, const Block& b) { return t < b.last; })
+        : std::lower_bound(s.blocks.begin(), s.blocks.end(), timestamp,
+                           [](const Block& b, UA_DateTime t) { return b.last < t; });
+    if (j == s.blocks.end()) return s.count;
+
+    const size_t k = size_t(j - s.blocks.begin());
+    s.decode(k);
+    auto i = after
+        ? std::upper_bound(s.times.begin(), s.times.end(), timestamp)
+        : std::lower_bound(s.times.begin(), s.times.end(), timestamp);
+    return k * m_samplesPerBlock + size_t(i - s.times.begin());
+}
+
+//*****************************************************************************
+
+UA_StatusCode CompressedHistoryBackend::append(const UA_NodeId& node, const UA_DataValue& value) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return append(series(node), value);
+}
+
+//*****************************************************************************
+
+size_t CompressedHistoryBackend::size(const UA_NodeId& node) const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(node);
+    return s ? s->count : 0;
+}
+
+size_t CompressedHistoryBackend::nodes() const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return m_series.size();
+}
+
+size_t CompressedHistoryBackend::memoryUsage() const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    size_t n = 0;
+    for (const auto& s : m_series) n += s.second->memoryUsage();
+    return n;
+}
+
+//*****************************************************************************
+
+void CompressedHistoryBackend::clear(const UA_NodeId& node) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto i = m_series.find(node);
+    if (i == m_series.end()) return;
+
+    std::unique_ptr<Series> s = std::move(i->second);
+    m_series.erase(i); // before the key owner is destroyed
+}
+
+//*****************************************************************************
+
+UA_StatusCode CompressedHistoryBackend::serverSetHistoryData(
+    Context&            context,
+    bool              /*historizing*/,
+    const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+    return append(context.nodeId, *value);
+}
+
+//*****************************************************************************
+
+size_t CompressedHistoryBackend::getDateTimeMatch(
+    Context&            context,
+    const UA_DateTime   timestamp,
+    const MatchStrategy strategy) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    if (!s || !s->count) return 0;
+
+    const size_t end = s->count;
+    size_t i = end;
+    switch (strategy) {
+    case MATCH_EQUAL:
+        i = bound(*s, timestamp, false);
+        if (i < end && s->times[i % m_samplesPerBlock] != timestamp) i = end;
+        break;
+    case MATCH_AFTER:
+        i = bound(*s, timestamp, true);
+        break;
+    case MATCH_EQUAL_OR_AFTER:
+        i = bound(*s, timestamp, false);
+        break;
+    case MATCH_BEFORE:
+        i = bound(*s, timestamp, false);
+        i = i ? i - 1 : end;
+        break;
+    case MATCH_EQUAL_OR_BEFORE:
+        i = bound(*s, timestamp, true);
+        i = i ? i - 1 : end;
+        break;
+    }
+    return i;
+}
+
+//*****************************************************************************
+
+size_t CompressedHistoryBackend::getEnd(Context& context) {
+    return size(context.nodeId);
+}
+
+size_t CompressedHistoryBackend::lastIndex(Context& context) {
+    size_t n = size(context.nodeId);
+    return n ? n - 1 : 0;
+}
+
+size_t CompressedHistoryBackend::firstIndex(Context& /*context*/) {
+    return 0;
+}
+
+//*****************************************************************************
+
+size_t CompressedHistoryBackend::resultSize(Context& context, size_t startIndex, size_t endIndex) {
+    size_t n = size(context.nodeId);
+    if (startIndex >= n || endIndex >= n) return 0;
+    return (startIndex <= endIndex ? endIndex - startIndex : startIndex - endIndex) + 1;
+}
+
+//*****************************************************************************
+
+UA_StatusCode CompressedHistoryBackend::copyDataValues(
+    Context&        context,
+    size_t          startIndex,
+    size_t          endIndex,
+    UA_Boolean      reverse,
+    size_t          valueSize,
+    UA_NumericRange range,
+    UA_Boolean    /*releaseContinuationPoints*/,
+    std::string&  /*in*/,
+    std::string&  /*out*/,
+    size_t*         providedValues,
+    UA_DataValue*   values) {
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    size_t n = 0;
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    if (s && startIndex < s->count && endIndex < s->count) {
+        const ptrdiff_t step = reverse ? -1 : 1;
+        const size_t count = (reverse ? startIndex - endIndex : endIndex - startIndex) + 1;
+        size_t i = startIndex;
+        for (; n < valueSize && n < count; n++, i += step) {
+            ret = get(*s, i, values[n], range);
+            if (ret != UA_STATUSCODE_GOOD) break;
+        }
+    }
+    if (providedValues) *providedValues = n;
+    return ret;
+}
+
+//*****************************************************************************
+
+const UA_DataValue* CompressedHistoryBackend::getDataValue(Context& context, size_t index) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series* s = find(context.nodeId);
+    if (!s || index >= s->count) return nullptr;
+
+    UA_DataValue& dv = m_scratch[m_nextScratch];
+    m_nextScratch ^= 1;
+    UA_DataValue_clear(&dv);
+    UA_NumericRange none{0, nullptr};
+    return get(*s, index, dv, none) == UA_STATUSCODE_GOOD ? &dv : nullptr;
+}
+
+//*****************************************************************************
+
+UA_Boolean CompressedHistoryBackend::boundSupported(Context& /*context*/) {
+    return UA_TRUE;
+}
+
+UA_Boolean CompressedHistoryBackend::timestampsToReturnSupported(
+    Context&              /*context*/,
+    UA_TimestampsToReturn   timestampsToReturn) {
+    return timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE
+        || timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER
+        || timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH;
+}
+
+//*****************************************************************************
+
+UA_StatusCode CompressedHistoryBackend::insertDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series& s = series(context.nodeId);
+    if (s.count && s.blocks.back().last == sampleTime(*value)) return UA_STATUSCODE_BADENTRYEXISTS;
+    return append(s, *value);
+}
+
+UA_StatusCode CompressedHistoryBackend::updateDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+    return append(context.nodeId, *value);
+}
+
+UA_StatusCode CompressedHistoryBackend::replaceDataValue(Context& /*context*/, const UA_DataValue* /*value*/) {
+    return UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+}
+
+UA_StatusCode CompressedHistoryBackend::removeDataValue(
+    Context&    /*context*/,
+    UA_DateTime /*startTimestamp*/,
+    UA_DateTime /*endTimestamp*/) {
+    return UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+}
+
+} // namespace Open62541
@@ -0,0 +1,376 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/historyaggregates.h>
+#include "open62541/nodeids.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OPEN62541CPP_AGGREGATES_SSE2
+#endif
+
+namespace Open62541 {
+
+// The reductions keep 4 independent accumulators: the compiler vectorises the sum
+// without having to reorder the floating point operations.
+// It does not vectorise a minimum or maximum without -ffast-math, nor an int64 to double
+// conversion without AVX-512: these kernels use SSE2 where available, and the area runs
+// over the time stamps as Double offsets.
+
+static double sum(const double* v, size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += v[i];
+        s1 += v[i + 1];
+        s2 += v[i + 2];
+        s3 += v[i + 3];
+    }
+    for (; i < n; i++) s0 += v[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+#ifdef OPEN62541CPP_AGGREGATES_SSE2
+
+/** @return the minimum of n > 0 values */
+static double minimum(const double* v, size_t n) {
+    __m128d m0 = _mm_set1_pd(v[0]), m1 = m0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = _mm_min_pd(_mm_loadu_pd(v + i),     m0);
+        m1 = _mm_min_pd(_mm_loadu_pd(v + i + 2), m1);
+    }
+    double m[2];
+    _mm_storeu_pd(m, _mm_min_pd(m0, m1));
+    double r = std::min(m[0], m[1]);
+    for (; i < n; i++) r = v[i] < r ? v[i] : r;
+    return r;
+}
+
+/** @return the maximum of n > 0 values */
+static double maximum(const double* v, size_t n) {
+    __m128d m0 = _mm_set1_pd(v[0]), m1 = m0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = _mm_max_pd(_mm_loadu_pd(v + i),     m0);
+        m1 = _mm_max_pd(_mm_loadu_pd(v + i + 2), m1);
+    }
+    double m[2];
+    _mm_storeu_pd(m, _mm_max_pd(m0, m1));
+    double r = std::max(m[0], m[1]);
+    for (; i < n; i++) r = v[i] > r ? v[i] : r;
+    return r;
+}
+
+/** @return the area under the line through n samples, in value x 100 ns */
+static double area(const double* t, const double* v, size_t n) {
+    __m128d a0 = _mm_setzero_pd(), a1 = a0;
+    size_t i = 0;
+    for (; i + 4 < n; i += 4) {
+        const __m128d d0 = _mm_sub_pd(_mm_loadu_pd(t + i + 1), _mm_loadu_pd(t + i));
+        const __m128d d1 = _mm_sub_pd(_mm_loadu_pd(t + i + 3), _mm_loadu_pd(t + i + 2));
+        const __m128d s0 = _mm_add_pd(_mm_loadu_pd(v + i),     _mm_loadu_pd(v + i + 1));
+        const __m128d s1 = _mm_add_pd(_mm_loadu_pd(v + i + 2), _mm_loadu_pd(v + i + 3));
+        a0 = _mm_add_pd(a0, _mm_mul_pd(d0, s0));
+        a1 = _mm_add_pd(a1, _mm_mul_pd(d1, s1));
+    }
+    double a[2];
+    _mm_storeu_pd(a, _mm_add_pd(a0, a1));
+    double r = a[0] + a[1];
+    for (; i + 1 < n; i++)
+        r += (t[i + 1] - t[i]) * (v[i] + v[i + 1]);
+    return 0.5 * r;
+}
+
+#else
+
+static double minimum(const double* v, size_t n) {
+    double m0 = v[0], m1 = v[0], m2 = v[0], m3 = v[0];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = v[i]     < m0 ? v[i]     : m0;
+        m1 = v[i + 1] < m1 ? v[i + 1] : m1;
+        m2 = v[i + 2] < m2 ? v[i + 2] : m2;
+        m3 = v[i + 3] < m3 ? v[i + 3] : m3;
+    }
+    for (; i < n; i++) m0 = v[i] < m0 ? v[i] : m0;
+    return std::min(std::min(m0, m1), std::min(m2, m3));
+}
+
+static double maximum(const double* v, size_t n) {
+    double m0 = v[0], m1 = v[0], m2 = v[0], m3 = v[0];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = v[i]     > m0 ? v[i]     : m0;
+        m1 = v[i + 1] > m1 ? v[i + 1] : m1;
+        m2 = v[i + 2] > m2 ? v[i + 2] : m2;
+        m3 = v[i + 3] > m3 ? v[i + 3] : m3;
+    }
+    for (; i < n; i++) m0 = v[i] > m0 ? v[i] : m0;
+    return std::max(std::max(m0, m1), std::max(m2, m3));
+}
+
+static double area(const double* t, const double* v, size_t n) {
+    double a0 = 0.0, a1 = 0.0, a2 = 0.0, a3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 < n; i += 4) {
+        a0 += (t[i + 1] - t[i])     * (v[i]     + v[i + 1]);
+        a1 += (t[i + 2] - t[i + 1]) * (v[i + 1] + v[i + 2]);
+        a2 += (t[i + 3] - t[i + 2]) * (v[i + 2] + v[i + 3]);
+        a3 += (t[i + 4] - t[i + 3]) * (v[i + 3] + v[i + 4]);
+    }
+    for (; i + 1 < n; i++)
+        a0 += (t[i + 1] - t[i]) * (v[i] + v[i + 1]);
+    return 0.5 * ((a0 + a1) + (a2 + a3));
+}
+
+#endif
+
+/** @return the value of a numeric scalar */
+static bool toDouble(const UA_Variant& v, double& d) {
+    if (!v.type || !UA_Variant_isScalar(&v)) return false;
+
+    const void* p = v.data;
+    if      (v.type == &UA_TYPES[UA_TYPES_DOUBLE])  d = *static_cast<const UA_Double*>(p);
+    else if (v.type == &UA_TYPES[UA_TYPES_FLOAT])   d = *static_cast<const UA_Float*>(p);
+    else if (v.type == &UA_TYPES[UA_TYPES_INT32])   d = *static_cast<const UA_Int32*>(p);
+    else if (v.type == &UA_TYPES[UA_TYPES_UINT32])  d = *static_cast<const UA_UInt32*>(p);
+    else if (v.type == &UA_TYPES[UA_TYPES_INT64])   d = double(*static_cast<const UA_Int64*>(p));
+    else if (v.type == &UA_TYPES[UA_TYPES_UINT64])  d = double(*static_cast<const UA_UInt64*>(p));
+    else if (v.type == &UA_TYPES[UA_TYPES_INT16])   d = *static_cast<const UA_Int16*>(p);
+    else if (v.type == &UA_TYPES[UA_TYPES_UINT16])  d = *static_cast<const UA_UInt16*>(p);
+    else if (v.type == &UA_TYPES[UA_TYPES_SBYTE])   d = *static_cast<const UA_SByte*>(p);
+    else if (v.type == &UA_TYPES[UA_TYPES_BYTE])    d = *static_cast<const UA_Byte*>(p);
+    else if (v.type == &UA_TYPES[UA_TYPES_BOOLEAN]) d = *static_cast<const UA_Boolean*>(p) ? 1.0 : 0.0;
+    else return false;
+    return true;
+}
+
+//*****************************************************************************
+
+bool HistoryAggregator::aggregate(const UA_NodeId& function, Aggregate& aggregate) {
+    if (function.namespaceIndex != 0 || function.identifierType != UA_NODEIDTYPE_NUMERIC)
+        return false;
+
+    switch (function.identifier.numeric) {
+    case UA_NS0ID_AGGREGATEFUNCTION_INTERPOLATIVE:  aggregate = Interpolative;  return true;
+    case UA_NS0ID_AGGREGATEFUNCTION_AVERAGE:        aggregate = Average;        return true;
+    case UA_NS0ID_AGGREGATEFUNCTION_TIMEAVERAGE:    aggregate = TimeAverage;    return true;
+    case UA_NS0ID_AGGREGATEFUNCTION_MINIMUM:        aggregate = Minimum;        return true;
+    case UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM:        aggregate = Maximum;        return true;
+    case UA_NS0ID_AGGREGATEFUNCTION_COUNT:          aggregate = Count;          return true;
+    case UA_NS0ID_AGGREGATEFUNCTION_DELTA:          aggregate = Delta;          return true;
+    default:                                                                    return false;
+    }
+}
+
+//*****************************************************************************
+
+const size_t HistoryAggregator::ChunkSize;
+
+HistoryAggregator::HistoryAggregator()
+    : m_times(ChunkSize)
+    , m_offsets(ChunkSize)
+    , m_values(ChunkSize) {
+}
+
+//*****************************************************************************
+
+void HistoryAggregator::reset(UA_DateTime start, UA_DateTime end, UA_DateTime interval, size_t count) {
+    m_start     = start;
+    m_end       = end;
+    m_interval  = interval > 0 ? interval : 1;
+    m_intervals.assign(count, Interval());
+    m_bounds.assign(count + 1, Bound());
+    m_nextBound = 0;
+    m_samples   = 0;
+    m_pending   = 0;
+}
+
+//*****************************************************************************
+
+bool HistoryAggregator::add(UA_DateTime time, const UA_DataValue& value) {
+    if (!value.hasValue) return false;
+    if (value.hasStatus && (value.status >> 30) != 0) return false; // bad or uncertain
+
+    double d;
+    if (!toDouble(value.value, d)) return false;
+    add(time, d);
+    return true;
+}
+
+//*****************************************************************************
+
+/**
+ * Fold the pending samples into the accumulators of their intervals,
+ * and interpolate the interval bounds they reach.
+ */
+void HistoryAggregator::fold() {
+    const UA_DateTime*  t = m_times.data();
+    const double*       o = m_offsets.data();
+    const double*       v = m_values.data();
+    const size_t        n = m_pending;
+    if (!n) return;
+    m_pending = 0;
+
+    // a bound is known from the first sample at or after it, and the one before
+    const bool hasPrevious = m_samples > n;
+    for (size_t j = 0; m_nextBound < m_bounds.size(); m_nextBound++) {
+        const UA_DateTime b = boundTime(m_nextBound);
+        j = size_t(std::lower_bound(t + j, t + n, b) - t);
+        if (j == n) break;
+
+        Bound& bound = m_bounds[m_nextBound];
+        if (t[j] == b) {
+            bound.value = v[j];
+            bound.known = true;
+        }
+        else if (j > 0 || hasPrevious) {
+            const UA_DateTime   t0 = j ? t[j - 1] : m_previousTime;
+            const double        v0 = j ? v[j - 1] : m_previousValue;
+            bound.value = v0 + double(b - t0) / double(t[j] - t0) * (v[j] - v0);
+            bound.known = true;
+        }
+    }
+
+    // the samples in [start, end), by runs within an interval
+    size_t          lo = size_t(std::lower_bound(t, t + n, m_start) - t);
+    const size_t    hi = size_t(std::lower_bound(t + lo, t + n, m_end) - t);
+    while (lo < hi && !m_intervals.empty()) {
+        const size_t        k   = std::min(size_t((t[lo] - m_start) / m_interval), m_intervals.size() - 1);
+        const UA_DateTime   e   = boundTime(k + 1);
+        const size_t        run = size_t(std::lower_bound(t + lo, t + hi, e) - t);
+        const size_t        m   = run - lo;
+
+        Interval& i = m_intervals[k];
+        if (!i.count) {
+            i.firstTime = t[lo];
+            i.first     = v[lo];
+            i.minimum   = v[lo];
+            i.maximum   = v[lo];
+        }
+        else {
+            i.area += 0.5 * double(t[lo] - i.lastTime) * (i.last + v[lo]); // from the previous chunk
+        }
+        i.count    += m;
+        i.sum      += sum(v + lo, m);
+        i.minimum   = std::min(i.minimum, minimum(v + lo, m));
+        i.maximum   = std::max(i.maximum, maximum(v + lo, m));
+        i.area     += area(o + lo, v + lo, m);
+        i.lastTime  = t[run - 1];
+        i.last      = v[run - 1];
+        lo = run;
+    }
+
+    m_previousTime  = t[n - 1];
+    m_previousValue = v[n - 1];
+}
+
+//*****************************************************************************
+
+void HistoryAggregator::compute(Aggregate aggregate, double* values, UA_StatusCode* status) {
+    fold();
+    for (size_t k = 0; k < m_intervals.size(); k++) {
+        const Interval&     i  = m_intervals[k];
+        const Bound&        bs = m_bounds[k];
+        const Bound&        be = m_bounds[k + 1];
+
+        double r  = 0.0;
+        bool   ok = i.count > 0;
+        switch (aggregate) {
+        case Interpolative:
+            ok = bs.known;
+            r  = bs.value;
+            break;
+        case Average:
+            if (ok) r = i.sum / double(i.count);
+            break;
+        case TimeAverage: {
+            if (!i.count) {
+                ok = bs.known && be.known; // a straight line over the interval
+                r  = 0.5 * (bs.value + be.value);
+                break;
+            }
+            // from the start bound, else the first sample, to the end bound, else the last sample
+            UA_DateTime from = i.firstTime, to = i.lastTime;
+            double a = i.area;
+            if (bs.known) {
+                from = boundTime(k);
+                a   += 0.5 * double(i.firstTime - from) * (bs.value + i.first);
+            }
+            if (be.known) {
+                to   = boundTime(k + 1);
+                a   += 0.5 * double(to - i.lastTime) * (i.last + be.value);
+            }
+            r = to > from ? a / double(to - from) : i.sum / double(i.count);
+            break;
+        }
+        case Minimum:
+            r = i.minimum;
+            break;
+        case Maximum:
+            r = i.maximum;
+            break;
+        case Count:
+            r  = double(i.count);
+            ok = true;
+            break;
+        case Delta:
+            r = i.last - i.first;
+            break;
+        }
+        values[k] = ok ? r : 0.0;
+        status[k] = ok ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADNODATA;
+    }
+}
+
+//*****************************************************************************
+
+void HistoryAggregator::compute(
+    Aggregate               aggregate,
+    UA_TimestampsToReturn   timestampsToReturn,
+    UA_DataValue*           results) {
+    const size_t count = m_intervals.size();
+    std::vector<double>         values(count);
+    std::vector<UA_StatusCode>  status(count);
+    compute(aggregate, values.data(), status.data());
+
+    const bool source = timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE
+                     || timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH;
+    const bool server = timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER
+                     || timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH;
+    for (size_t k = 0; k < count; k++) {
+        UA_DataValue& dv = results[k];
+        UA_DataValue_init(&dv);
+        if (status[k] == UA_STATUSCODE_GOOD) {
+            if (aggregate == Count) {
+                UA_Int32 c = UA_Int32(values[k]);
+                UA_Variant_setScalarCopy(&dv.value, &c, &UA_TYPES[UA_TYPES_INT32]);
+            }
+            else {
+                UA_Variant_setScalarCopy(&dv.value, &values[k], &UA_TYPES[UA_TYPES_DOUBLE]);
+            }
+            dv.hasValue = true;
+        }
+        else {
+            dv.status    = status[k];
+            dv.hasStatus = true;
+        }
+        const UA_DateTime s = boundTime(k);
+        dv.sourceTimestamp      = s;
+        dv.hasSourceTimestamp   = source;
+        dv.serverTimestamp      = s;
+        dv.hasServerTimestamp   = server;
+    }
+}
+
+} // namespace Open62541
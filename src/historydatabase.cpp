@@ -1,6 +1,12 @@
 #include <open62541cpp/historydatabase.h>
+#include <open62541cpp/compressedhistory.h>
+#include <open62541cpp/historyaggregates.h>
+#include <open62541cpp/writebehindhistory.h>
 #include <open62541cpp/objects/StringUtils.h>
 #include <open62541cpp/open62541server.h>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
 /*
     Copyright (C) 2017 -  B. J. Hill
 
@@ -15,6 +21,33 @@
 
 namespace Open62541 {
 
+/**
+ * Give a continuation point returned by a hook to the stack.
+ * The stack owns and releases the byte string, so it receives a copy.
+ * @param cp the continuation point, none if empty.
+ * @param[out] out receives an allocated copy, untouched if cp is empty.
+ */
+static void setContinuationPoint(const std::string& cp, UA_ByteString* out) {
+    if (cp.empty() || !out) return;
+    if (UA_ByteString_allocBuffer(out, cp.size()) == UA_STATUSCODE_GOOD)
+        memcpy(out->data, cp.data(), cp.size());
+}
+
+/**
+ * The historians serving HistoryReadProcessed, by context of their database:
+ * the default database call-backs only receive that context.
+ */
+static std::mutex                               historiansMutex;
+static std::unordered_map<void*, Historian*>    historians;
+
+/** Raw values read from a backend in one call */
+static const size_t readChunkSize = 1024;
+
+/** Limit of the intervals of a processed read, against an absurd processing interval */
+static const size_t maxProcessedIntervals = 1 << 20;
+
+//*****************************************************************************
+
 void HistoryDataGathering::_deleteMembers(UA_HistoryDataGathering* gathering) {
     if (gathering && gathering->context) {
         auto p = static_cast<HistoryDataGathering*>(gathering->context);
@@ -140,8 +173,9 @@ UA_StatusCode HistoryDataBackend::_serverSetHistoryData(
     const UA_NodeId*    nodeId,
     UA_Boolean          historizing,
     const UA_DataValue* value) {
-    if (!hdbContext || !sessionId) return UA_STATUSCODE_GOOD; // ignore
+    if (!hdbContext) return UA_STATUSCODE_GOOD; // ignore
 
+    // the polling gathering stores without session
     Context c(server, sessionId, sessionContext, nodeId);
     auto p = static_cast<HistoryDataBackend*>(hdbContext);
     return p->serverSetHistoryData(c, historizing, value);
@@ -170,7 +204,7 @@ UA_StatusCode HistoryDataBackend::_getHistoryData(
     
     Context context(server, sessionId, sessionContext, nodeId);
     auto p = static_cast<HistoryDataBackend*>(backend->context);
-    std::string in = fromByteString(*(const_cast<UA_ByteString*>(continuationPoint)));
+    std::string in = continuationPoint ? fromByteString(*continuationPoint) : std::string();
     std::string out;
 
     UA_StatusCode ret = p->getHistoryData(
@@ -186,7 +220,7 @@ UA_StatusCode HistoryDataBackend::_getHistoryData(
         in,
         out,
         result);
-    *outContinuationPoint = UA_BYTESTRING(const_cast<char*>(out.c_str()));
+    setContinuationPoint(out, outContinuationPoint);
     return ret;
 }
 
@@ -291,7 +325,7 @@ UA_StatusCode HistoryDataBackend::_copyDataValues(
 
     Context context(server, sessionId, sessionContext, nodeId);
     auto p = static_cast<HistoryDataBackend*>(hdbContext);
-    std::string in = fromByteString(*(const_cast<UA_ByteString*>(continuationPoint)));
+    std::string in = continuationPoint ? fromByteString(*continuationPoint) : std::string();
     std::string out;
     UA_StatusCode ret = p->copyDataValues(
         context,
@@ -305,7 +339,7 @@ UA_StatusCode HistoryDataBackend::_copyDataValues(
         out,
         providedValues,
         values);
-    *outContinuationPoint = UA_BYTESTRING(const_cast<char*>(out.c_str()));
+    setContinuationPoint(out, outContinuationPoint);
     return ret;
 }
 
@@ -452,6 +486,7 @@ void HistoryDatabase::initialise() {
     database().clear             = _deleteMembers;
     database().setValue          = _setValue;
     database().readRaw           = _readRaw;
+    database().readProcessed     = _readProcessed;
     database().updateData        = _updateData;
     database().deleteRawModified = _deleteRawModified;
 }
@@ -515,6 +550,37 @@ void HistoryDatabase::_readRaw(
 
 //*****************************************************************************
 
+void HistoryDatabase::_readProcessed(
+    UA_Server*                      server,
+    void*                           hdbContext,
+    const UA_NodeId*                sessionId,
+    void*                           sessionContext,
+    const UA_RequestHeader*         requestHeader,
+    const UA_ReadProcessedDetails*  historyReadDetails,
+    UA_TimestampsToReturn           timestampsToReturn,
+    UA_Boolean                      releaseContinuationPoints,
+    size_t                          nodesToReadSize,
+    const UA_HistoryReadValueId*    nodesToRead,
+    UA_HistoryReadResponse*         response,
+    UA_HistoryData* const* const    historyData) {
+    if (!hdbContext) return;
+
+    Context context(server, sessionId, sessionContext, sessionId);
+    auto p = static_cast<HistoryDatabase*>(hdbContext);
+    p->readProcessed(
+        context,
+        requestHeader,
+        historyReadDetails,
+        timestampsToReturn,
+        releaseContinuationPoints,
+        nodesToReadSize,
+        nodesToRead,
+        response,
+        historyData);
+}
+
+//*****************************************************************************
+
 void HistoryDatabase::_updateData(
     UA_Server*                  server,
     void*                       hdbContext,
@@ -558,6 +624,11 @@ Historian::Historian() {
 //*****************************************************************************
 
 Historian::~Historian() {
+    {
+        std::lock_guard<std::mutex> lock(historiansMutex);
+        auto i = historians.find(m_database.context);
+        if (i != historians.end() && i->second == this) historians.erase(i);
+    }
     m_backend.deleteMembers(&m_backend);
     memset(&m_backend, 0, sizeof(m_backend));
 }
@@ -586,11 +657,12 @@ bool Historian::setUpdateNode(
     Server& server,
     size_t  responseSize,
     size_t  pollInterval,
-    void*   context)
+    void*   context,
+    bool    compressed)
 {
     UA_HistorizingNodeIdSettings setting;
     setting.pollingInterval             = pollInterval;
-    setting.historizingBackend          = backend();
+    setting.historizingBackend          = nodeBackend(compressed);
     setting.maxHistoryDataResponseSize  = responseSize;
     setting.historizingUpdateStrategy   = UA_HISTORIZINGUPDATESTRATEGY_VALUESET;
     setting.userContext                 = context;
@@ -608,16 +680,18 @@ bool Historian::setUpdateNode(
  * \param responseSize
  * \param pollInterval
  * \param context
+ * \param compressed
  * \return true on success
  */
 bool Historian::setPollNode(NodeId& nodeId,
                                        Server& server,
                                        size_t responseSize,
                                        size_t pollInterval,
-                                       void* context)
+                                       void* context,
+                                       bool compressed)
 {
     UA_HistorizingNodeIdSettings setting;
-    setting.historizingBackend          = backend();
+    setting.historizingBackend          = nodeBackend(compressed);
     setting.pollingInterval             = pollInterval;
     setting.maxHistoryDataResponseSize  = responseSize;
     setting.historizingUpdateStrategy   = UA_HISTORIZINGUPDATESTRATEGY_POLL;
@@ -653,12 +727,283 @@ bool Historian::setUserNode(
 
 //*****************************************************************************
 
+CompressedHistoryBackend& Historian::compressedStore(size_t samplesPerBlock, size_t maxValuesPerNode)
+{
+    if (!m_compressed)
+        m_compressed.reset(new CompressedHistoryBackend(samplesPerBlock, maxValuesPerNode));
+    return *m_compressed;
+}
+
+//*****************************************************************************
+
+void Historian::enableWriteBehind(unsigned flushInterval, size_t maxQueued)
+{
+    if (m_writeBehind) return;
+    m_writeBehind.reset(new WriteBehindHistoryBackend(m_backend, flushInterval, maxQueued));
+    m_backend = m_writeBehind->database(); // now owns the previous backend
+}
+
+//*****************************************************************************
+
+void Historian::releaseStore()
+{
+    if (m_writeBehind) m_writeBehind->deleteMembers(); // ~Historian() then finds it stopped
+    else m_backend.context = nullptr;
+}
+
+//*****************************************************************************
+
+void Historian::enableReadProcessed()
+{
+    std::lock_guard<std::mutex> lock(historiansMutex);
+    historians[m_database.context] = this;
+    m_database.readProcessed = _readProcessed;
+}
+
+//*****************************************************************************
+
+UA_HistoryDataBackend& Historian::nodeBackend(bool compressed)
+{
+    // the default database reads a node history from the backend of its setting
+    return compressed ? compressedStore().database() : backend();
+}
+
+//*****************************************************************************
+
+void Historian::_readProcessed(
+    UA_Server*                      server,
+    void*                           hdbContext,
+    const UA_NodeId*                sessionId,
+    void*                           sessionContext,
+    const UA_RequestHeader*         /*requestHeader*/,
+    const UA_ReadProcessedDetails*  historyReadDetails,
+    UA_TimestampsToReturn           timestampsToReturn,
+    UA_Boolean                      releaseContinuationPoints,
+    size_t                          nodesToReadSize,
+    const UA_HistoryReadValueId*    nodesToRead,
+    UA_HistoryReadResponse*         response,
+    UA_HistoryData* const* const    historyData)
+{
+    if (releaseContinuationPoints) return; // none is given
+
+    Historian* p = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(historiansMutex);
+        auto i = historians.find(hdbContext);
+        if (i != historians.end()) p = i->second;
+    }
+    if (!p) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+        return;
+    }
+    p->readProcessed(
+        server,
+        sessionId,
+        sessionContext,
+        historyReadDetails,
+        timestampsToReturn,
+        nodesToReadSize,
+        nodesToRead,
+        response,
+        historyData);
+}
+
+//*****************************************************************************
+
+/**
+ * readAggregatorValues() through the getHistoryData() hook, for the backends offering no index:
+ * a raw read with its bounds, chunk by chunk with the continuation points.
+ */
+static UA_StatusCode readAggregatorHistory(
+    UA_Server*                      server,
+    const UA_NodeId*                sessionId,
+    void*                           sessionContext,
+    const UA_NodeId*                nodeId,
+    const UA_HistoryDataBackend&    backend,
+    UA_DateTime                     start,
+    UA_DateTime                     end,
+    HistoryAggregator&              aggregator)
+{
+    const UA_Boolean bounds = backend.boundSupported
+        && backend.boundSupported(server, backend.context, sessionId, sessionContext, nodeId);
+
+    UA_NumericRange range;
+    range.dimensionsSize    = 0;
+    range.dimensions        = nullptr;
+
+    UA_ByteString cp = UA_BYTESTRING_NULL;
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    do {
+        UA_HistoryData data;
+        UA_HistoryData_init(&data);
+        UA_ByteString outCp = UA_BYTESTRING_NULL;
+        ret = backend.getHistoryData(
+            server, sessionId, sessionContext, &backend, start, end, nodeId,
+            readChunkSize, 0, bounds, UA_TIMESTAMPSTORETURN_BOTH, range, false,
+            cp.length ? &cp : nullptr, &outCp, &data);
+        for (size_t i = 0; i < data.dataValuesSize; i++) {
+            const UA_DataValue& dv = data.dataValues[i];
+            aggregator.add(dv.hasSourceTimestamp ? dv.sourceTimestamp : dv.serverTimestamp, dv);
+        }
+        const bool more = data.dataValuesSize > 0;
+        UA_HistoryData_clear(&data);
+        UA_ByteString_clear(&cp);
+        cp = outCp;
+        if (!more) break;
+    } while (ret == UA_STATUSCODE_GOOD && cp.length);
+    UA_ByteString_clear(&cp);
+    return ret;
+}
+
+//*****************************************************************************
+
+/**
+ * Read the good numeric values of a node bounding and within [start, end]:
+ * from the last one before start to the first one after end,
+ * so the aggregates can interpolate at the interval bounds.
+ * @param backend the backend of the node.
+ * @param[out] aggregator receives the values, folded chunk by chunk.
+ */
+static UA_StatusCode readAggregatorValues(
+    UA_Server*                      server,
+    const UA_NodeId*                sessionId,
+    void*                           sessionContext,
+    const UA_NodeId*                nodeId,
+    const UA_HistoryDataBackend&    backend,
+    UA_DateTime                     start,
+    UA_DateTime                     end,
+    HistoryAggregator&              aggregator)
+{
+    if (!backend.getEnd || !backend.lastIndex || !backend.getDateTimeMatch
+        || !backend.resultSize || !backend.copyDataValues) {
+        if (backend.getHistoryData) // the write-behind stage and SQLiteHistoryBackend only read this way
+            return readAggregatorHistory(server, sessionId, sessionContext, nodeId, backend, start, end, aggregator);
+        return UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+    }
+
+    void* context = backend.context;
+    const size_t storeEnd = backend.getEnd(server, context, sessionId, sessionContext, nodeId);
+
+    size_t first = backend.getDateTimeMatch(server, context, sessionId, sessionContext, nodeId, start, MATCH_BEFORE);
+    if (first == storeEnd)
+        first = backend.getDateTimeMatch(server, context, sessionId, sessionContext, nodeId, start, MATCH_EQUAL_OR_AFTER);
+    if (first == storeEnd) return UA_STATUSCODE_GOOD; // no value
+
+    size_t last = backend.getDateTimeMatch(server, context, sessionId, sessionContext, nodeId, end, MATCH_EQUAL_OR_AFTER);
+    if (last == storeEnd)
+        last = backend.lastIndex(server, context, sessionId, sessionContext, nodeId);
+
+    const size_t total = backend.resultSize(server, context, sessionId, sessionContext, nodeId, first, last);
+
+    UA_NumericRange range;
+    range.dimensionsSize    = 0;
+    range.dimensions        = nullptr;
+
+    // paged by index: the backends are not required to return continuation points
+    std::vector<UA_DataValue> chunk(std::min(total, readChunkSize));
+    const UA_ByteString cp = UA_BYTESTRING_NULL;
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    for (size_t done = 0; done < total;) {
+        UA_ByteString outCp = UA_BYTESTRING_NULL;
+        size_t provided = 0;
+        ret = backend.copyDataValues(
+            server, context, sessionId, sessionContext, nodeId,
+            first + done, last, false, std::min(total - done, chunk.size()), range, false,
+            &cp, &outCp, &provided, chunk.data());
+        UA_ByteString_clear(&outCp);
+        for (size_t i = 0; i < provided; i++) {
+            UA_DataValue& dv = chunk[i];
+            aggregator.add(dv.hasSourceTimestamp ? dv.sourceTimestamp : dv.serverTimestamp, dv);
+            UA_DataValue_clear(&dv);
+        }
+        done += provided;
+        if (ret != UA_STATUSCODE_GOOD || !provided) break;
+    }
+    return ret;
+}
+
+//*****************************************************************************
+
+void Historian::readProcessed(
+    UA_Server*                      server,
+    const UA_NodeId*                sessionId,
+    void*                           sessionContext,
+    const UA_ReadProcessedDetails*  historyReadDetails,
+    UA_TimestampsToReturn           timestampsToReturn,
+    size_t                          nodesToReadSize,
+    const UA_HistoryReadValueId*    nodesToRead,
+    UA_HistoryReadResponse*         response,
+    UA_HistoryData* const* const    historyData)
+{
+    const UA_ReadProcessedDetails& details = *historyReadDetails;
+    if (details.aggregateTypeSize != nodesToReadSize) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADAGGREGATELISTMISMATCH;
+        return;
+    }
+
+    // the intervals are computed forwards, then returned in the requested direction
+    const bool          reverse = details.startTime > details.endTime;
+    const UA_DateTime   start   = reverse ? details.endTime   : details.startTime;
+    const UA_DateTime   end     = reverse ? details.startTime : details.endTime;
+    if (start == end || !(details.processingInterval >= 0.0)) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADINVALIDARGUMENT;
+        return;
+    }
+
+    // a processing interval of 0 is the whole time range
+    UA_DateTime interval = UA_DateTime(details.processingInterval * UA_DATETIME_MSEC);
+    if (interval <= 0 || interval > end - start) interval = end - start;
+    const size_t count = size_t((end - start + interval - 1) / interval);
+    if (count > maxProcessedIntervals) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADRESPONSETOOLARGE;
+        return;
+    }
+
+    HistoryAggregator aggregator;
+    for (size_t i = 0; i < nodesToReadSize; i++) {
+        UA_HistoryReadResult& result = response->results[i];
+
+        HistoryAggregator::Aggregate aggregate;
+        if (!HistoryAggregator::aggregate(details.aggregateType[i], aggregate)) {
+            result.statusCode = UA_STATUSCODE_BADAGGREGATENOTSUPPORTED;
+            continue;
+        }
+
+        const UA_NodeId* nodeId = &nodesToRead[i].nodeId;
+        const UA_HistorizingNodeIdSettings* setting =
+            m_gathering.getHistorizingSetting(server, m_gathering.context, nodeId);
+        if (!setting) {
+            result.statusCode = UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+            continue;
+        }
+
+        aggregator.reset(start, end, interval, count);
+        result.statusCode = readAggregatorValues(
+            server, sessionId, sessionContext, nodeId, setting->historizingBackend, start, end, aggregator);
+        if (result.statusCode != UA_STATUSCODE_GOOD) continue;
+
+        auto values = static_cast<UA_DataValue*>(UA_Array_new(count, &UA_TYPES[UA_TYPES_DATAVALUE]));
+        if (!values) {
+            result.statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+            continue;
+        }
+        aggregator.compute(aggregate, timestampsToReturn, values);
+        if (reverse) std::reverse(values, values + count);
+
+        historyData[i]->dataValues      = values;
+        historyData[i]->dataValuesSize  = count;
+    }
+}
+
+//*****************************************************************************
+
 MemoryHistorian::MemoryHistorian(
     size_t numberNodes      /*= 100*/,
     size_t maxValuesPerNode /*= 100*/) {
     gathering() = UA_HistoryDataGathering_Default(numberNodes);
     database()  = UA_HistoryDatabase_default(gathering());
     backend()   = UA_HistoryDataBackend_Memory_Circular(numberNodes, maxValuesPerNode);
+    enableReadProcessed();
 }
 
 //*****************************************************************************
@@ -666,21 +1011,29 @@ MemoryHistorian::MemoryHistorian(
 SQLiteHistorianCyclicBuffered::SQLiteHistorianCyclicBuffered(const char* dbFileName,
                                                              size_t numberNodes,
                                                              size_t maxValuesPerNode,
-                                                             size_t pruneInterval)
+                                                             size_t pruneInterval,
+                                                             unsigned flushInterval,
+                                                             size_t maxQueued)
 {
     gathering() = UA_HistoryDataGathering_Default(numberNodes);
     database()  = UA_HistoryDatabase_default(gathering());
     backend() = UA_HistoryDataBackend_SQLite_Circular(dbFileName, pruneInterval, maxValuesPerNode, FALSE);
+    if (flushInterval) enableWriteBehind(flushInterval, maxQueued);
+    enableReadProcessed();
 }
 
 SQLiteHistorianTimeBuffered::SQLiteHistorianTimeBuffered(const char* dbFileName,
                                                          size_t numberNodes,
                                                          UA_DateTime maxBufferedTimeSec,
-                                                         size_t pruneInterval)
+                                                         size_t pruneInterval,
+                                                         unsigned flushInterval,
+                                                         size_t maxQueued)
 {
     gathering() = UA_HistoryDataGathering_Default(numberNodes);
     database()  = UA_HistoryDatabase_default(gathering());
     backend()   = UA_HistoryDataBackend_SQLite_TimeBuffered(dbFileName, pruneInterval, maxBufferedTimeSec, FALSE);
+    if (flushInterval) enableWriteBehind(flushInterval, maxQueued);
+    enableReadProcessed();
 }
 
 }  // namespace Open62541
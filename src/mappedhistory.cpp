@@ -0,0 +1,632 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/mappedhistory.h>
+#include <open62541cpp/objects/StringUtils.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+
+namespace bip = boost::interprocess;
+
+namespace Open62541 {
+
+const size_t MappedHistoryBackend::RecordSize;
+
+/**
+ * A sample in a segment file.
+ * The checksum is computed last: a record torn by a crash is invalid,
+ * as is the zero filled space after the last record.
+ */
+struct MappedHistoryBackend::Record {
+    enum : UA_Byte { HasValue = 1 };
+
+    UA_DateTime     time;
+    UA_UInt64       value;      /**< the scalar value, zero padded */
+    UA_StatusCode   status;
+    UA_UInt16       type;       /**< index in UA_TYPES */
+    UA_Byte         flags;
+    UA_Byte         reserved1;
+    UA_UInt32       reserved2;
+    UA_UInt32       check;      /**< checksum of the previous bytes */
+
+    /** @return the FNV-1a hash of the record, check excluded */
+    UA_UInt32 checksum() const {
+        const UA_Byte* p = reinterpret_cast<const UA_Byte*>(this);
+        UA_UInt32 h = 2166136261u;
+        for (size_t i = 0; i < offsetof(Record, check); i++) {
+            h ^= p[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    bool isValid() const { return check == checksum(); }
+
+    /**
+     * Materialise the record.
+     * @param[out] dv receives the sample.
+     * @param range the numeric range to copy, if any.
+     * @return UA_STATUSCODE_GOOD on success.
+     */
+    UA_StatusCode get(UA_DataValue& dv, const UA_NumericRange& range) const {
+        if ((flags & HasValue) && type < UA_TYPES_COUNT) {
+            UA_Variant src;
+            UA_Variant_setScalar(&src, const_cast<UA_UInt64*>(&value), &UA_TYPES[type]);
+            UA_StatusCode ret = range.dimensionsSize > 0
+                ? UA_Variant_copyRange(&src, &dv.value, range)
+                : UA_Variant_copy(&src, &dv.value);
+            if (ret != UA_STATUSCODE_GOOD) return ret;
+            dv.hasValue = true;
+        }
+        dv.status               = status;
+        dv.hasStatus            = status != UA_STATUSCODE_GOOD;
+        dv.sourceTimestamp      = time;
+        dv.hasSourceTimestamp   = true;
+        dv.serverTimestamp      = time;
+        dv.hasServerTimestamp   = true;
+        return UA_STATUSCODE_GOOD;
+    }
+};
+
+static_assert(sizeof(UA_DateTime) == 8 && sizeof(UA_StatusCode) == 4, "record layout");
+
+/**
+ * A segment file of a node. All the segments but the last of a node are full.
+ */
+struct MappedHistoryBackend::Segment {
+    static const size_t IndexStride = 256; /**< records per sparse index entry */
+
+    std::string                             path;
+    size_t                                  count   = 0;        /**< valid records */
+    UA_DateTime                             first   = 0;        /**< time of the first record, if count */
+    std::vector<UA_DateTime>                sparse;             /**< time of every IndexStride-th record */
+    bool                                    indexed = false;    /**< sparse is complete */
+    std::unique_ptr<bip::mapped_region>     region;
+    bool                                    inLru   = false;    /**< in m_mapped */
+    std::list<Segment*>::iterator           lru;
+
+    explicit Segment(const std::string& p) : path(p) {}
+
+    Record* records() const { return static_cast<Record*>(region->get_address()); }
+
+    /** Build the sparse index of a mapped full segment. */
+    void index() {
+        if (indexed) return;
+        sparse.clear();
+        const Record* r = records();
+        for (size_t i = 0; i < count; i += IndexStride)
+            sparse.push_back(r[i].time);
+        indexed = true;
+    }
+};
+
+const size_t MappedHistoryBackend::Segment::IndexStride;
+
+/**
+ * The segments of a node, in time order.
+ * Sample i is in segments[i / recordsPerSegment].
+ */
+struct MappedHistoryBackend::Series {
+    UA_NodeId                               node;               /**< owned, key of the series map */
+    std::string                             key;                /**< file name prefix */
+    size_t                                  firstSequence = 0;  /**< sequence number of segments[0] */
+    std::deque<std::unique_ptr<Segment>>    segments;
+    size_t                                  count = 0;          /**< number of samples */
+    UA_DateTime                             last  = 0;          /**< time of the last sample, if count */
+
+    Series(const UA_NodeId& n, const std::string& k) : key(k) { UA_NodeId_copy(&n, &node); }
+    ~Series() { UA_NodeId_clear(&node); }
+};
+
+//*****************************************************************************
+
+/** @return the time stamp indexing a sample: source, else server, else now. */
+static UA_DateTime sampleTime(const UA_DataValue& v) {
+    if (v.hasSourceTimestamp) return v.sourceTimestamp;
+    if (v.hasServerTimestamp) return v.serverTimestamp;
+    return UA_DateTime_now();
+}
+
+/** @return a file name part unique to the node */
+static std::string nodeKey(const UA_NodeId& node) {
+    std::string key;
+    for (char c : toString(node)) {
+        if (key.size() == 48) break;
+        key += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+    char tail[24];
+    snprintf(tail, sizeof(tail), "_%u_%08x", unsigned(node.identifierType), unsigned(UA_NodeId_hash(&node)));
+    return key + tail;
+}
+
+static std::string segmentPath(const std::string& directory, const std::string& key, size_t sequence) {
+    char name[32];
+    snprintf(name, sizeof(name), ".%08lu.seg", static_cast<unsigned long>(sequence));
+    return directory + "/" + key + name;
+}
+
+static std::string firstPath(const std::string& directory, const std::string& key) {
+    return directory + "/" + key + ".first";
+}
+
+/** Create a zero filled file of the given size. */
+static bool createFile(const std::string& path, size_t size) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    f.seekp(std::streamoff(size - 1));
+    f.put(0);
+    return bool(f);
+}
+
+//*****************************************************************************
+
+MappedHistoryBackend::MappedHistoryBackend(
+    const std::string&  directory,
+    size_t              recordsPerSegment,
+    size_t              maxSegmentsPerNode,
+    size_t              maxMappedSegments)
+    : m_directory(directory)
+    , m_recordsPerSegment(std::max<size_t>(recordsPerSegment, Segment::IndexStride))
+    , m_maxSegmentsPerNode(maxSegmentsPerNode)
+    , m_maxMappedSegments(maxMappedSegments) {
+    UA_DataValue_init(&m_scratch[0]);
+    UA_DataValue_init(&m_scratch[1]);
+    initialise();
+    database().getHistoryData = nullptr; // use the low level API
+}
+
+//*****************************************************************************
+
+MappedHistoryBackend::~MappedHistoryBackend() {
+    UA_DataValue_clear(&m_scratch[0]);
+    UA_DataValue_clear(&m_scratch[1]);
+}
+
+//*****************************************************************************
+
+/**
+ * Map a segment if needed.
+ * @param segment the segment file to map.
+ * @param pinned true for the last segment of a node, never unmapped.
+ * @throw bip::interprocess_exception if the file cannot be mapped.
+ */
+void MappedHistoryBackend::map(Segment& segment, bool pinned) {
+    if (segment.region) {
+        if (segment.inLru) m_mapped.splice(m_mapped.begin(), m_mapped, segment.lru);
+        return;
+    }
+    bip::file_mapping file(segment.path.c_str(), bip::read_write);
+    segment.region.reset(new bip::mapped_region(file, bip::read_write));
+    if (!pinned) track(segment);
+}
+
+//*****************************************************************************
+
+/**
+ * Add a mapped segment to the least recently used list,
+ * unmapping the oldest segments beyond maxMappedSegments.
+ */
+void MappedHistoryBackend::track(Segment& segment) {
+    m_mapped.push_front(&segment);
+    segment.lru   = m_mapped.begin();
+    segment.inLru = true;
+    const size_t keep = std::max<size_t>(m_maxMappedSegments, 1); // not the one just used
+    while (m_mapped.size() > keep) {
+        Segment* g = m_mapped.back();
+        m_mapped.pop_back();
+        g->inLru = false;
+        g->region.reset();
+    }
+}
+
+//*****************************************************************************
+
+MappedHistoryBackend::Series* MappedHistoryBackend::find(const UA_NodeId& node) {
+    auto i = m_series.find(node);
+    return i == m_series.end() ? nullptr : i->second.get();
+}
+
+//*****************************************************************************
+
+MappedHistoryBackend::Series& MappedHistoryBackend::series(const UA_NodeId& node) {
+    if (Series* s = find(node)) return *s;
+
+    std::unique_ptr<Series> p(new Series(node, nodeKey(node)));
+    Series& s = *p;
+    m_series.emplace(s.node, std::move(p)); // keyed by the series copy of the node id
+
+    // recover the segments left by a previous run, without reading the full ones
+    std::ifstream firstFile(firstPath(m_directory, s.key));
+    if (firstFile) firstFile >> s.firstSequence;
+
+    for (size_t seq = s.firstSequence;; seq++) {
+        std::string path = segmentPath(m_directory, s.key, seq);
+        std::ifstream f(path, std::ios::binary);
+        if (!f) break;
+
+        std::unique_ptr<Segment> g(new Segment(path));
+        g->count = m_recordsPerSegment;
+        Record r;
+        if (f.read(reinterpret_cast<char*>(&r), sizeof(r)) && r.isValid())
+            g->first = r.time;
+        else if (!s.segments.empty())
+            g->first = s.segments.back()->first;
+        s.segments.push_back(std::move(g));
+    }
+    if (s.segments.empty()) return s;
+
+    // scan the last segment, up to its first invalid record
+    try {
+        map(*s.segments.back(), true);
+    }
+    catch (const bip::interprocess_exception&) {
+        s.segments.pop_back(); // unreadable, overwritten by the next append
+    }
+    if (!s.segments.empty() && s.segments.back()->region) {
+        Segment& tail = *s.segments.back();
+        const size_t capacity = std::min(m_recordsPerSegment, tail.region->get_size() / RecordSize);
+        const Record* r = tail.records();
+        size_t n = 0;
+        for (; n < capacity && r[n].isValid(); n++)
+            if (n % Segment::IndexStride == 0) tail.sparse.push_back(r[n].time);
+        tail.count   = n;
+        tail.indexed = true;
+        if (n) tail.first = r[0].time;
+    }
+
+    if (!s.segments.empty())
+        s.count = (s.segments.size() - 1) * m_recordsPerSegment + s.segments.back()->count;
+    if (s.count) {
+        const Record* r = record(s, s.count - 1);
+        s.last = r ? r->time : s.segments.back()->first;
+    }
+    return s;
+}
+
+//*****************************************************************************
+
+void MappedHistoryBackend::dropOldestSegment(Series& s) {
+    std::unique_ptr<Segment> g = std::move(s.segments.front());
+    s.segments.pop_front();
+    s.count -= g->count;
+    s.firstSequence++;
+    {
+        // before deleting the file: a crash in between only leaves a stale file
+        std::ofstream f(firstPath(m_directory, s.key), std::ios::trunc);
+        f << s.firstSequence;
+    }
+    if (g->inLru) m_mapped.erase(g->lru);
+    g->region.reset();
+    std::remove(g->path.c_str());
+}
+
+//*****************************************************************************
+
+const MappedHistoryBackend::Record* MappedHistoryBackend::record(Series& s, size_t index) {
+    if (index >= s.count) return nullptr;
+
+    Segment& g = *s.segments[index / m_recordsPerSegment];
+    try {
+        map(g);
+    }
+    catch (const bip::interprocess_exception&) {
+        return nullptr;
+    }
+    return g.records() + index % m_recordsPerSegment;
+}
+
+//*****************************************************************************
+
+size_t MappedHistoryBackend::bound(Series& s, UA_DateTime timestamp, bool after) {
+    // number of segments starting before the bound, the bound is in the last of them
+    auto before = [&](const std::unique_ptr<Segment>& g) {
+        return g->count && (after ? g->first <= timestamp : g->first < timestamp);
+    };
+    size_t lo = 0, n = s.segments.size();
+    while (n > 0) {
+        size_t half = n / 2;
+        if (before(s.segments[lo + half])) { lo += half + 1; n -= half + 1; }
+        else n = half;
+    }
+    if (lo == 0) return 0;
+
+    const size_t k = lo - 1;
+    Segment& g = *s.segments[k];
+    try {
+        map(g);
+    }
+    catch (const bip::interprocess_exception&) {
+        return k * m_recordsPerSegment; // unreadable segment
+    }
+    g.index();
+
+    // the sparse index gives the block, a binary search in it the record
+    auto j = after
+        ? std::upper_bound(g.sparse.begin(), g.sparse.end(), timestamp)
+        : std::lower_bound(g.sparse.begin(), g.sparse.end(), timestamp);
+    const size_t block = size_t(j - g.sparse.begin()) - 1;
+    const Record* first = g.records() + block * Segment::IndexStride;
+    const Record* last  = g.records() + std::min(g.count, (block + 1) * Segment::IndexStride);
+    const Record* r = after
+        ? std::upper_bound(first, last, timestamp,
+                           [](UA_DateTime t, const Record& x) { return t < x.time; })
+        : std::lower_bound(first, last, timestamp,
+                           [](const Record& x, UA_DateTime t) { return x.time < t; });
+    return k * m_recordsPerSegment + size_t(r - g.records());
+}
+
+//*****************************************************************************
+
+UA_StatusCode MappedHistoryBackend::append(Series& s, const UA_DataValue& value) {
+    Record r;
+    memset(&r, 0, sizeof(r));
+    r.time = sampleTime(value);
+    if (s.count && r.time < s.last) return UA_STATUSCODE_BADOUTOFRANGE;
+
+    if (value.hasValue && value.value.type) {
+        const UA_DataType* t = value.value.type;
+        if (!UA_Variant_isScalar(&value.value)
+            || !t->pointerFree
+            || t->memSize > sizeof(r.value)
+            || t->typeIndex >= UA_TYPES_COUNT
+            || &UA_TYPES[t->typeIndex] != t)
+            return UA_STATUSCODE_BADTYPEMISMATCH;
+        memcpy(&r.value, value.value.data, t->memSize);
+        r.type  = t->typeIndex;
+        r.flags = Record::HasValue;
+    }
+    r.status = value.hasStatus ? value.status : UA_STATUSCODE_GOOD;
+    r.check  = r.checksum();
+
+    if (s.segments.empty() || s.segments.back()->count == m_recordsPerSegment) {
+        // start a new segment
+        const size_t sequence = s.firstSequence + s.segments.size();
+        std::unique_ptr<Segment> g(new Segment(segmentPath(m_directory, s.key, sequence)));
+        g->indexed = true;
+        try {
+            if (!createFile(g->path, m_recordsPerSegment * RecordSize))
+                return UA_STATUSCODE_BADINTERNALERROR;
+            map(*g, true);
+        }
+        catch (const bip::interprocess_exception&) {
+            std::remove(g->path.c_str());
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+
+        if (!s.segments.empty() && s.segments.back()->region)
+            track(*s.segments.back()); // the full segment is only read from now: let it be unmapped
+        s.segments.push_back(std::move(g));
+        if (m_maxSegmentsPerNode && s.segments.size() > m_maxSegmentsPerNode)
+            dropOldestSegment(s);
+    }
+
+    Segment& g = *s.segments.back();
+    memcpy(g.records() + g.count, &r, sizeof(r));
+    if (g.count % Segment::IndexStride == 0) g.sparse.push_back(r.time);
+    if (!g.count) g.first = r.time;
+    g.count++;
+    s.count++;
+    s.last = r.time;
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+UA_StatusCode MappedHistoryBackend::append(const UA_NodeId& node, const UA_DataValue& value) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return append(series(node), value);
+}
+
+//*****************************************************************************
+
+size_t MappedHistoryBackend::size(const UA_NodeId& node) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return series(node).count;
+}
+
+//*****************************************************************************
+
+void MappedHistoryBackend::flush() {
+    std::lock_guard<std::mutex> l(m_mutex);
+    for (auto& s : m_series) {
+        for (auto& g : s.second->segments)
+            if (g->region) g->region->flush(0, 0, false);
+    }
+}
+
+//*****************************************************************************
+
+UA_StatusCode MappedHistoryBackend::serverSetHistoryData(
+    Context&            context,
+    bool              /*historizing*/,
+    const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+    return append(context.nodeId, *value);
+}
+
+//*****************************************************************************
+
+size_t MappedHistoryBackend::getDateTimeMatch(
+    Context&            context,
+    const UA_DateTime   timestamp,
+    const MatchStrategy strategy) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series& s = series(context.nodeId);
+    const size_t end = s.count;
+    if (!end) return 0;
+
+    size_t i = end;
+    switch (strategy) {
+    case MATCH_EQUAL: {
+        i = bound(s, timestamp, false);
+        const Record* r = record(s, i);
+        if (!r || r->time != timestamp) i = end;
+        break;
+    }
+    case MATCH_AFTER:
+        i = bound(s, timestamp, true);
+        break;
+    case MATCH_EQUAL_OR_AFTER:
+        i = bound(s, timestamp, false);
+        break;
+    case MATCH_BEFORE:
+        i = bound(s, timestamp, false);
+        i = i ? i - 1 : end;
+        break;
+    case MATCH_EQUAL_OR_BEFORE:
+        i = bound(s, timestamp, true);
+        i = i ? i - 1 : end;
+        break;
+    }
+    return i;
+}
+
+//*****************************************************************************
+
+size_t MappedHistoryBackend::getEnd(Context& context) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return series(context.nodeId).count;
+}
+
+size_t MappedHistoryBackend::lastIndex(Context& context) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    size_t n = series(context.nodeId).count;
+    return n ? n - 1 : 0;
+}
+
+size_t MappedHistoryBackend::firstIndex(Context& /*context*/) {
+    return 0;
+}
+
+//*****************************************************************************
+
+size_t MappedHistoryBackend::resultSize(Context& context, size_t startIndex, size_t endIndex) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    size_t n = series(context.nodeId).count;
+    if (startIndex >= n || endIndex >= n) return 0;
+    return (startIndex <= endIndex ? endIndex - startIndex : startIndex - endIndex) + 1;
+}
+
+//*****************************************************************************
+
+UA_StatusCode MappedHistoryBackend::copyDataValues(
+    Context&        context,
+    size_t          startIndex,
+    size_t          endIndex,
+    UA_Boolean      reverse,
+    size_t          valueSize,
+    UA_NumericRange range,
+    UA_Boolean    /*releaseContinuationPoints*/,
+    std::string&  /*in*/,
+    std::string&  /*out*/,
+    size_t*         providedValues,
+    UA_DataValue*   values) {
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    size_t n = 0;
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series& s = series(context.nodeId);
+    if (startIndex < s.count && endIndex < s.count) {
+        const ptrdiff_t step = reverse ? -1 : 1;
+        const size_t count = (reverse ? startIndex - endIndex : endIndex - startIndex) + 1;
+        size_t i = startIndex;
+        for (; n < valueSize && n < count; n++, i += step) {
+            const Record* r = record(s, i);
+            ret = r ? r->get(values[n], range) : UA_STATUSCODE_BADINTERNALERROR;
+            if (ret != UA_STATUSCODE_GOOD) break;
+        }
+    }
+    if (providedValues) *providedValues = n;
+    return ret;
+}
+
+//*****************************************************************************
+
+const UA_DataValue* MappedHistoryBackend::getDataValue(Context& context, size_t index) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    const Record* r = record(series(context.nodeId), index);
+    if (!r) return nullptr;
+
+    UA_DataValue& dv = m_scratch[m_nextScratch];
+    m_nextScratch ^= 1;
+    UA_DataValue_clear(&dv);
+    UA_NumericRange none{0, nullptr};
+    return r->get(dv, none) == UA_STATUSCODE_GOOD ? &dv : nullptr;
+}
+
+//*****************************************************************************
+
+UA_Boolean MappedHistoryBackend::boundSupported(Context& /*context*/) {
+    return UA_TRUE;
+}
+
+UA_Boolean MappedHistoryBackend::timestampsToReturnSupported(
+    Context&              /*context*/,
+    UA_TimestampsToReturn   timestampsToReturn) {
+    return timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE
+        || timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER
+        || timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH;
+}
+
+//*****************************************************************************
+
+UA_StatusCode MappedHistoryBackend::insertDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    std::lock_guard<std::mutex> l(m_mutex);
+    Series& s = series(context.nodeId);
+    if (s.count && s.last == sampleTime(*value)) return UA_STATUSCODE_BADENTRYEXISTS;
+    return append(s, *value);
+}
+
+UA_StatusCode MappedHistoryBackend::updateDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+    return append(context.nodeId, *value);
+}
+
+UA_StatusCode MappedHistoryBackend::replaceDataValue(Context& /*context*/, const UA_DataValue* /*value*/) {
+    return UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+}
+
+UA_StatusCode MappedHistoryBackend::removeDataValue(
+    Context&    /*context*/,
+    UA_DateTime /*startTimestamp*/,
+    UA_DateTime /*endTimestamp*/) {
+    return UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+}
+
+//*****************************************************************************
+
+MappedHistorian::MappedHistorian(
+    const std::string&  directory,
+    size_t              numberNodes,
+    size_t              recordsPerSegment,
+    size_t              maxSegmentsPerNode)
+    : m_store(directory, recordsPerSegment, maxSegmentsPerNode) {
+    gathering() = UA_HistoryDataGathering_Default(numberNodes);
+    database()  = UA_HistoryDatabase_default(gathering());
+    backend()   = m_store.database();
+    enableReadProcessed();
+}
+
+//*****************************************************************************
+
+MappedHistorian::~MappedHistorian() {
+    releaseStore(); // m_store is destroyed before ~Historian() releases the backend
+}
+
+} // namespace Open62541
@@ -12,6 +12,8 @@
 #include <open62541cpp/monitoreditem.h>
 #include <open62541cpp/open62541client.h>
 #include <open62541cpp/clientsubscription.h>
+#include <open62541cpp/notificationdispatcher.h>
+#include <algorithm>
 
 
 namespace Open62541 {
@@ -25,6 +27,15 @@ namespace Open62541 {
     {
     }
 
+    /*!
+        \brief MonitoredItem::~MonitoredItem
+    */
+    MonitoredItem::~MonitoredItem()
+    {
+        remove();
+        if (m_dispatchTarget) m_dispatchTarget->detach();
+    }
+
 /* Callback for the deletion of a MonitoredItem */
 /* any of the parts may have disappeared */
 /*!
@@ -78,7 +89,14 @@ void MonitoredItem::dataChangeNotificationCallback(UA_Client* client,
         if (c) {
             MonitoredItem* m = (MonitoredItem*)(monContext);
             if (m) {
-                m->dataChangeNotification(value);
+                if (NotificationDispatcher* d = c->dispatcher()) {
+                    if (!m->m_dispatchTarget)
+                        m->m_dispatchTarget = std::make_shared<DispatchTarget>(m);
+                    d->post(m->m_dispatchTarget, *value); // the value is moved, the stack clears an empty one
+                }
+                else {
+                    m->dataChangeNotification(value);
+                }
             }
         }
     }
@@ -118,6 +136,10 @@ void MonitoredItem::eventNotificationCallback(UA_Client* client,
 //*****************************************************************************
 
 bool  MonitoredItem::remove() {
+    if (m_dispatchTarget) {
+        m_dispatchTarget->detach(); // waits for a handler running in a dispatcher worker
+        m_dispatchTarget.reset();
+    }
     if (id() < 1 || !m_sub.client().client()) return false;
     
     bool ret = UA_Client_MonitoredItems_deleteSingle(
@@ -148,18 +170,114 @@ bool MonitoredItem::setTriggering(
 }
 
 
+void DataChangeProfile::apply(
+    UA_MonitoredItemCreateRequest&  request,
+    UA_DataChangeFilter&            filter) const {
+    request.monitoringMode                          = monitoringMode;
+    request.requestedParameters.samplingInterval    = samplingInterval;
+    request.requestedParameters.queueSize           = queueSize;
+    request.requestedParameters.discardOldest       = discardOldest;
+    if (!hasFilter()) return;
+
+    UA_DataChangeFilter_init(&filter);
+    filter.trigger          = trigger;
+    filter.deadbandType     = UA_UInt32(deadbandType);
+    filter.deadbandValue    = deadbandValue;
+    UA_ExtensionObject_setValueNoDelete( // the request doesn't own the filter
+        &request.requestedParameters.filter, &filter, &UA_TYPES[UA_TYPES_DATACHANGEFILTER]);
+}
+
+//*****************************************************************************
+
 bool MonitoredItemDataChange::addDataChange(
     NodeId&                 node,
     UA_TimestampsToReturn   timeStamp /*= UA_TIMESTAMPSTORETURN_BOTH*/) {
+    return addDataChange(node, subscription().dataChangeProfile(), timeStamp);
+}
+
+//*****************************************************************************
+
+bool MonitoredItemDataChange::addDataChange(
+    NodeId&                     node,
+    const DataChangeProfile&    profile,
+    UA_TimestampsToReturn       timeStamp /*= UA_TIMESTAMPSTORETURN_BOTH*/) {
+    UA_MonitoredItemCreateRequest request = UA_MonitoredItemCreateRequest_default(node); // shallow node id
+    UA_DataChangeFilter filter;
+    profile.apply(request, filter);
+
     m_response = UA_Client_MonitoredItems_createDataChange(
         subscription().client().client(),
         subscription().id(),
         timeStamp, // source and/or server timestamp, or neither.
-        UA_MonitoredItemCreateRequest_default(node),
+        request,
         this,
         dataChangeNotificationCallback,
         deleteMonitoredItemCallback);
-    return m_response.ref()->statusCode == UA_STATUSCODE_GOOD;
+    m_lastError = m_response.ref()->statusCode;
+    return m_lastError == UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+size_t MonitoredItemDataChange::addDataChanges(
+    const std::vector<MonitoredItemDataChange*>& items,
+    const std::vector<NodeId>&                   nodes,
+    const DataChangeProfile&                     profile,
+    size_t                                       maxPerCall /*= 0*/,
+    UA_TimestampsToReturn                        timeStamp /*= UA_TIMESTAMPSTORETURN_BOTH*/) {
+    if (items.empty() || items.size() != nodes.size()) return 0;
+
+    ClientSubscription& sub = items[0]->subscription();
+    UA_Client* client = sub.client().client();
+    if (!client) return 0;
+
+    const size_t chunk = maxPerCall ? maxPerCall : items.size();
+    std::vector<UA_MonitoredItemCreateRequest>              requests;
+    UA_DataChangeFilter                                     filter; // shared by the requests
+    std::vector<void*>                                      contexts;
+    std::vector<UA_Client_DataChangeNotificationCallback>   callbacks;
+    std::vector<UA_Client_DeleteMonitoredItemCallback>      deleteCallbacks;
+    requests.reserve(std::min(chunk, items.size()));
+
+    size_t created = 0;
+    for (size_t first = 0; first < items.size(); first += chunk) {
+        const size_t n = std::min(chunk, items.size() - first);
+        requests.clear();
+        contexts.clear();
+        for (size_t i = first; i < first + n; i++) {
+            requests.push_back(UA_MonitoredItemCreateRequest_default(nodes[i])); // shallow node id
+            profile.apply(requests.back(), filter);
+            contexts.push_back(items[i]);
+        }
+        callbacks.assign(n, dataChangeNotificationCallback);
+        deleteCallbacks.assign(n, deleteMonitoredItemCallback);
+
+        UA_CreateMonitoredItemsRequest request;
+        UA_CreateMonitoredItemsRequest_init(&request);
+        request.subscriptionId      = sub.id();
+        request.timestampsToReturn  = timeStamp; // source and/or server timestamp, or neither.
+        request.itemsToCreate       = requests.data(); // not owned by the request
+        request.itemsToCreateSize   = n;
+
+        UA_CreateMonitoredItemsResponse response = UA_Client_MonitoredItems_createDataChanges(
+            client, request, contexts.data(), callbacks.data(), deleteCallbacks.data());
+
+        const UA_StatusCode service = response.responseHeader.serviceResult;
+        for (size_t i = 0; i < n; i++) {
+            MonitoredItemDataChange* item = items[first + i];
+            if (service == UA_STATUSCODE_GOOD && i < response.resultsSize) {
+                item->m_response  = response.results[i];
+                item->m_lastError = response.results[i].statusCode;
+            }
+            else {
+                item->m_response.null();
+                item->m_lastError = (service != UA_STATUSCODE_GOOD) ? service : UA_STATUSCODE_BADUNEXPECTEDERROR;
+            }
+            if (item->m_lastError == UA_STATUSCODE_GOOD) created++;
+        }
+        UA_CreateMonitoredItemsResponse_clear(&response);
+    }
+    return created;
 }
 
 //*****************************************************************************
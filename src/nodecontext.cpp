@@ -12,6 +12,10 @@
 #include <open62541cpp/nodecontext.h>
 #include <open62541cpp/open62541server.h>
 #include <open62541cpp/objects/Variant.h>
+#include <open62541cpp/objects/NodeIdHashMap.h>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 namespace Open62541 {
 
@@ -75,9 +79,7 @@ UA_StatusCode NodeContext::typeConstructor(
     if (!pContext || !pServer)
         return error;
 
-    NodeId node = *nodeId;
-    NodeId type = *typeNodeId;
-    if (pContext->typeConstruct(*pServer, node, type))
+    if (pContext->typeConstructRef(*pServer, NodeIdRef(*nodeId), NodeIdRef(*typeNodeId)))
         return UA_STATUSCODE_GOOD;
 
     return error;
@@ -108,9 +110,7 @@ void NodeContext::typeDestructor(
     if (!pContext || !pServer)
         return;
 
-    NodeId node = *nodeId;
-    NodeId type = *typeNodeId;
-    pContext->typeDestruct(*pServer, node, type);
+    pContext->typeDestructRef(*pServer, NodeIdRef(*nodeId), NodeIdRef(*typeNodeId));
 }
 
 
@@ -165,13 +165,21 @@ UA_StatusCode NodeContext::readDataSource(
     if (!pServer || !pContext || !nodeId || !value)
         return UA_STATUSCODE_GOOD;
 
-    NodeId node = *nodeId;
-    if (!pContext->readData(*pServer, node, range, *value))
+    if (pContext->m_readCache && !range) {
+        // the cached value keeps the source timestamp of its data source read
+        if (!pContext->readDataCached(*pServer, NodeIdRef(*nodeId), *value))
+            return UA_STATUSCODE_BADDATAUNAVAILABLE;
+        if (!includeSourceTimeStamp)
+            value->hasSourceTimestamp = false;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    if (!pContext->readDataRef(*pServer, NodeIdRef(*nodeId), range, *value)) // no copy of the node id
         return UA_STATUSCODE_BADDATAUNAVAILABLE;
 
     if (includeSourceTimeStamp)
     {
-        value->hasServerTimestamp = true;
+        value->hasSourceTimestamp = true;
         value->sourceTimestamp = UA_DateTime_now();
     }
 
@@ -206,13 +214,179 @@ UA_StatusCode NodeContext::writeDataSource(
     if (!pServer || !pContext || !nodeId || !value)
         return UA_STATUSCODE_GOOD;
 
-    NodeId node = *nodeId;
-    if(!pContext->writeData(*pServer, node, range, *value))
+    if(!pContext->writeDataRef(*pServer, NodeIdRef(*nodeId), range, *value))
         return UA_STATUSCODE_BADDATAUNAVAILABLE;
 
+    if (pContext->m_readCache)
+        pContext->invalidateReadCache(*nodeId);
+
     return UA_STATUSCODE_GOOD;
 }
 
+//*****************************************************************************
+//
+// Data source read cache
+//
+/**
+ * Last value read of each data source node of a context.
+ */
+struct NodeContext::ReadCache {
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        UA_NodeId               node;               /**< owned, shallow copied as map key */
+        std::mutex              mutex;
+        std::condition_variable loaded;             /**< notified at the end of each data source read */
+        UA_DataValue            value;
+        Clock::time_point       updated;
+        bool                    valid            = false;
+        bool                    loading          = false;   /**< a session is reading the data source */
+        bool                    lastOk           = false;   /**< result of the last data source read */
+        unsigned                loads            = 0;       /**< number of data source reads done */
+        unsigned                generation       = 0;       /**< bumped by each invalidation */
+        unsigned                loadedGeneration = 0;       /**< generation at the start of the last read */
+        ReadCacheStats          stats;
+
+        explicit Entry(const UA_NodeId& n) {
+            UA_NodeId_copy(&n, &node);
+            UA_DataValue_init(&value);
+        }
+        ~Entry() {
+            UA_DataValue_clear(&value);
+            UA_NodeId_clear(&node);
+        }
+    };
+    typedef std::shared_ptr<Entry> EntryRef;
+
+    std::chrono::duration<double, std::milli>                           maxAge;
+    mutable std::mutex                                                  mutex; /**< guards the map */
+    std::unordered_map<UA_NodeId, EntryRef, NodeIdHash, NodeIdEqual>    entries;
+
+    EntryRef find(const UA_NodeId& node, bool create) {
+        std::lock_guard<std::mutex> l(mutex);
+        auto i = entries.find(node);
+        if (i != entries.end()) return i->second;
+        if (!create) return EntryRef();
+        EntryRef e = std::make_shared<Entry>(node);
+        entries[e->node] = e;
+        return e;
+    }
+};
+
+//*****************************************************************************
+
+NodeContext::~NodeContext()
+{
+}
+
+//*****************************************************************************
+
+void NodeContext::setReadCache(UA_Double maxAge)
+{
+    if (maxAge <= 0) {
+        m_readCache.reset();
+        return;
+    }
+    if (!m_readCache) m_readCache = std::make_shared<ReadCache>();
+    m_readCache->maxAge = std::chrono::duration<double, std::milli>(maxAge);
+}
+
+//*****************************************************************************
+
+UA_Double NodeContext::readCacheMaxAge() const
+{
+    return m_readCache ? m_readCache->maxAge.count() : 0;
+}
+
+//*****************************************************************************
+
+void NodeContext::invalidateReadCache(const UA_NodeId& node)
+{
+    if (!m_readCache) return;
+    if (auto e = m_readCache->find(node, false)) {
+        std::lock_guard<std::mutex> l(e->mutex);
+        e->valid = false;
+        e->generation++; // a read in progress gets a value older than the write
+    }
+}
+
+//*****************************************************************************
+
+void NodeContext::forgetReadCache(const UA_NodeId& node)
+{
+    if (!m_readCache) return;
+    std::lock_guard<std::mutex> l(m_readCache->mutex);
+    m_readCache->entries.erase(node); // a read in progress keeps its entry alive
+}
+
+//*****************************************************************************
+
+bool NodeContext::readCacheStats(const UA_NodeId& node, ReadCacheStats& stats) const
+{
+    if (!m_readCache) return false;
+    auto e = m_readCache->find(node, false);
+    if (!e) return false;
+    std::lock_guard<std::mutex> l(e->mutex);
+    stats = e->stats;
+    return true;
+}
+
+//*****************************************************************************
+
+bool NodeContext::readDataCached(Server& server, NodeIdRef node, UA_DataValue& value)
+{
+    ReadCache::EntryRef e = m_readCache->find(node, true);
+    std::unique_lock<std::mutex> l(e->mutex);
+
+    if (e->loading) { // share the data source read in progress
+        const unsigned load = e->loads;
+        e->loaded.wait(l, [&e] { return !e->loading; });
+        if (e->loads != load && e->loadedGeneration == e->generation) {
+            e->stats.coalesced++;
+            return e->lastOk && UA_DataValue_copy(&e->value, &value) == UA_STATUSCODE_GOOD;
+        }
+        // invalidated during that read: read again
+    }
+
+    if (e->valid && ReadCache::Clock::now() - e->updated <= m_readCache->maxAge) {
+        e->stats.hits++;
+        return UA_DataValue_copy(&e->value, &value) == UA_STATUSCODE_GOOD;
+    }
+
+    e->stats.misses++;
+    e->loading = true;
+    const unsigned generation = e->generation;
+    l.unlock();
+
+    UA_DataValue fresh;
+    UA_DataValue_init(&fresh);
+    const bool ok = readDataRef(server, node, nullptr, fresh); // without the lock: may be slow
+
+    l.lock();
+    e->loading = false;
+    e->lastOk  = ok;
+    e->loads++;
+    e->loadedGeneration = generation;
+    if (ok) {
+        if (!fresh.hasSourceTimestamp) { // sampled now, the age reported on the later hits
+            fresh.hasSourceTimestamp = true;
+            fresh.sourceTimestamp    = UA_DateTime_now();
+        }
+        UA_DataValue_clear(&e->value);
+        e->value   = fresh; // shallow move
+        e->valid   = e->generation == generation; // not cached if written during the read
+        e->updated = ReadCache::Clock::now();
+        UA_DataValue_copy(&e->value, &value);
+    }
+    else {
+        UA_DataValue_clear(&fresh);
+        e->valid = false;
+    }
+    l.unlock();
+    e->loaded.notify_all();
+    return ok;
+}
+
 //*****************************************************************************
 
 bool NodeContext::setValueCallback(Server& server, NodeId& node)
@@ -250,8 +424,7 @@ void NodeContext::readValueCallback(
     auto pServer  = Server::findServer(server);
     if(pServer && pContext && nodeId && value )
     {
-       NodeId node = *nodeId;
-       pContext->readValue(*pServer, node, range, value);
+       pContext->readValueRef(*pServer, NodeIdRef(*nodeId), range, value);
     }
 }
 
@@ -273,8 +446,7 @@ void NodeContext::writeValueCallback(
     auto pServer  = Server::findServer(server);
     if(pServer && pContext && nodeId && value)
     {
-        NodeId node = *nodeId;
-        pContext->writeValue(*pServer, node, range, *value);
+        pContext->writeValueRef(*pServer, NodeIdRef(*nodeId), range, *value);
     }
 }
 
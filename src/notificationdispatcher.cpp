@@ -0,0 +1,195 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/notificationdispatcher.h>
+#include <open62541cpp/monitoreditem.h>
+
+namespace Open62541 {
+
+DispatchTarget::~DispatchTarget() {
+    if (UA_DataValue* v = latest.exchange(nullptr))
+        UA_DataValue_delete(v);
+}
+
+//*****************************************************************************
+
+NotificationDispatcher::NotificationDispatcher(
+    size_t          workers,
+    size_t          capacity,
+    Backpressure    policy)
+    : m_queue(capacity)
+    , m_policy(policy) {
+    m_running = true;
+    if (workers < 1) workers = 1;
+    for (size_t i = 0; i < workers; i++)
+        m_workers.emplace_back([this] { run(); });
+}
+
+//*****************************************************************************
+
+NotificationDispatcher::~NotificationDispatcher() {
+    stop();
+}
+
+//*****************************************************************************
+
+void NotificationDispatcher::stop() {
+    {
+        std::lock_guard<std::mutex> l(m_idleMutex);
+        m_running = false;
+    }
+    m_idle.notify_all();
+    for (auto& t : m_workers) {
+        if (t.joinable()) t.join();
+    }
+    m_workers.clear();
+
+    while (dropOldest()) {}
+}
+
+//*****************************************************************************
+
+void NotificationDispatcher::post(const DispatchTargetRef& target, UA_DataValue& value) {
+    if (!target) return;
+    m_posted++;
+    if (!m_running) {
+        m_dropped++; // the stack clears the value
+        return;
+    }
+
+    Notification n;
+    n.target = target;
+    if (m_policy == Backpressure::Coalesce) {
+        UA_DataValue* v = UA_DataValue_new();
+        *v = value; // shallow move
+        UA_DataValue_init(&value);
+        if (UA_DataValue* old = target->latest.exchange(v)) {
+            UA_DataValue_delete(old); // the item is already queued, it gets the new value
+            m_coalesced++;
+            return;
+        }
+    }
+    else {
+        n.value = value; // shallow move
+        n.hasValue = true;
+        UA_DataValue_init(&value);
+    }
+    push(n);
+}
+
+//*****************************************************************************
+
+void NotificationDispatcher::push(Notification& n) {
+    bool full = false;
+    // never wait for a worker here: the client thread holds its client, the handlers may be calling it
+    while (!m_queue.tryPush(n)) {
+        full = true;
+        if (m_policy == Backpressure::Block && n.hasValue) {
+            // coalesce with the values of the item not dispatched yet
+            UA_DataValue* v = UA_DataValue_new();
+            *v = n.value; // shallow move
+            UA_DataValue_init(&n.value);
+            n.hasValue = false;
+            if (UA_DataValue* old = n.target->latest.exchange(v)) {
+                UA_DataValue_delete(old); // the item is already queued, it gets the new value
+                m_coalesced++;
+                m_blocked++;
+                return;
+            }
+            continue; // queue the entry taking the latest value, dropping the oldest if still full
+        }
+        dropOldest();
+    }
+    if (full) m_blocked++;
+
+    const size_t depth = m_queue.size();
+    size_t maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+    while (depth > maxDepth && !m_maxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed)) {}
+
+    wakeWorker();
+}
+
+//*****************************************************************************
+
+bool NotificationDispatcher::dropOldest() {
+    Notification old;
+    if (!m_queue.tryPop(old)) return false;
+    if (!old.hasValue) { // coalescing entry: its value goes too, the next post of the item queues a new one
+        if (UA_DataValue* v = old.target->latest.exchange(nullptr))
+            UA_DataValue_delete(v);
+    }
+    m_dropped++;
+    return true;
+}
+
+//*****************************************************************************
+
+void NotificationDispatcher::wakeWorker() {
+    if (m_sleeping.load() > 0) {
+        std::lock_guard<std::mutex> l(m_idleMutex); // no lost wake-up between the test and the wait
+        m_idle.notify_one();
+    }
+}
+
+//*****************************************************************************
+
+void NotificationDispatcher::dispatch(Notification& n) {
+    DispatchTarget& t = *n.target;
+    std::lock_guard<std::recursive_mutex> l(t.mutex);
+    if (!n.hasValue) {
+        // coalescing: take the latest value, cleared when the notification is reused
+        UA_DataValue* v = t.latest.exchange(nullptr);
+        if (!v) return;
+        n.value = *v;
+        n.hasValue = true;
+        UA_free(v); // only the struct, its content moved
+    }
+    if (!t.item) {
+        m_dropped++; // removed while queued
+        return;
+    }
+    t.item->dataChangeNotification(&n.value);
+    m_dispatched++;
+}
+
+//*****************************************************************************
+
+void NotificationDispatcher::run() {
+    Notification n;
+    while (m_running) {
+        if (m_queue.tryPop(n)) {
+            dispatch(n);
+            n = Notification(); // release the value and the target now, not on the next pop
+            continue;
+        }
+        std::unique_lock<std::mutex> l(m_idleMutex);
+        m_sleeping++;
+        if (m_running && m_queue.size() == 0)
+            m_idle.wait_for(l, std::chrono::milliseconds(100)); // bounded: a push may race the size test
+        m_sleeping--;
+    }
+}
+
+//*****************************************************************************
+
+NotificationDispatcher::Stats NotificationDispatcher::stats() const {
+    Stats s;
+    s.posted     = m_posted;
+    s.dispatched = m_dispatched;
+    s.dropped    = m_dropped;
+    s.coalesced  = m_coalesced;
+    s.blocked    = m_blocked;
+    s.depth      = m_queue.size();
+    s.maxDepth   = m_maxDepth;
+    return s;
+}
+
+} // namespace Open62541
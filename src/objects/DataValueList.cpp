@@ -0,0 +1,44 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/objects/DataValueList.h>
+#include "open62541/types_generated_handling.h"
+
+namespace Open62541 {
+
+DataValueList::~DataValueList()
+{
+    reset();
+}
+
+//*****************************************************************************
+
+void DataValueList::reset(size_t size)
+{
+    for (auto& value : *this) {
+        UA_DataValue_clear(&value);  // delete value data
+    }
+    UA_DataValue empty;
+    UA_DataValue_init(&empty);
+    assign(size, empty);  // keeps the capacity
+}
+
+//*****************************************************************************
+
+void DataValueList::take(size_t pos, UA_DataValue* values, size_t size)
+{
+    for (size_t i = 0; i < size && pos + i < this->size(); i++) {
+        UA_DataValue_clear(&at(pos + i));
+        at(pos + i) = values[i];        // shallow copy transfers ownership
+        UA_DataValue_init(&values[i]);  // so the source can be cleared safely
+    }
+}
+}  // namespace Open62541
@@ -0,0 +1,37 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/objects/NodeIdHashMap.h>
+#include "open62541/types_generated_handling.h"
+
+namespace Open62541 {
+NodeIdHashMap::~NodeIdHashMap()
+{
+    for (auto& i : *this) {
+        UA_NodeId_clear(&i.second);  // delete node data, shared with the key
+    }
+    clear();
+}
+
+//*****************************************************************************
+
+bool NodeIdHashMap::put(const UA_NodeId& node)
+{
+    if (find(node) != end())
+        return false;
+
+    UA_NodeId copy;  // deep copy
+    UA_NodeId_init(&copy);
+    UA_NodeId_copy(&node, &copy);
+    emplace(copy, copy);
+    return true;
+}
+}  // namespace Open62541
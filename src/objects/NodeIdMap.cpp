@@ -25,12 +25,15 @@ NodeIdMap::~NodeIdMap()
 
 //*****************************************************************************
 
-void NodeIdMap::put(const UA_NodeId& node)
+bool NodeIdMap::put(const UA_NodeId& node)
 {
     UA_NodeId copy;  // deep copy
     UA_NodeId_init(&copy);
     UA_NodeId_copy(&node, &copy);
     const std::string s = toString(copy);
-    insert(std::pair<std::string, UA_NodeId>(s, copy));
+    if (insert(std::pair<std::string, UA_NodeId>(s, copy)).second)
+        return true;
+    UA_NodeId_clear(&copy);  // already in the map
+    return false;
 }
 }  // namespace Open62541
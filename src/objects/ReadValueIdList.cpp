@@ -0,0 +1,42 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/objects/ReadValueIdList.h>
+#include "open62541/types_generated_handling.h"
+
+namespace Open62541 {
+
+ReadValueIdList::~ReadValueIdList()
+{
+    reset();
+}
+
+//*****************************************************************************
+
+void ReadValueIdList::put(const UA_NodeId& node, UA_AttributeId attributeId)
+{
+    UA_ReadValueId item;
+    UA_ReadValueId_init(&item);
+    UA_NodeId_copy(&node, &item.nodeId);  // deep copy
+    item.attributeId = attributeId;
+    push_back(item);
+}
+
+//*****************************************************************************
+
+void ReadValueIdList::reset()
+{
+    for (auto& item : *this) {
+        UA_ReadValueId_clear(&item);  // delete node data
+    }
+    clear();
+}
+}  // namespace Open62541
@@ -13,6 +13,8 @@
 #include <open62541cpp/clientbrowser.h>
 #include <open62541cpp/objects/CreateSubscriptionRequest.h>
 #include <open62541cpp/objects/VariableAttributes.h>
+#include <algorithm>
+#include <deque>
 //#include <open62541cpp/open62541config.h>
 //#include "objects/VariableAttributes.cpp"
 
@@ -32,6 +34,7 @@ Client::~Client() {
     if (m_pClient) {
         _timerMap.clear();
         disconnect();
+        cancelAsync(UA_STATUSCODE_BADSHUTDOWN);
         UA_Client_delete(m_pClient);
     }
 }
@@ -42,6 +45,7 @@ bool Client::runIterate(uint32_t interval /*= 100*/) {
     if (!m_pClient || _connectStatus != UA_STATUSCODE_GOOD)
         return false;
 
+    ClientLock l(*this); // the call-backs run here, re-entering the client through the same lock
     m_lastError = UA_Client_run_iterate(m_pClient, interval);
     return lastOK();
 }
@@ -56,6 +60,7 @@ void Client::initialise() {
 
         if (sessionState != UA_SESSIONSTATE_CLOSED)
             disconnect();
+        cancelAsync(UA_STATUSCODE_BADSHUTDOWN);
         UA_Client_delete(m_pClient);
         m_pClient = nullptr;
     }
@@ -191,6 +196,9 @@ void Client::stateChange(UA_SecureChannelState channelState,
     _sessionState = sessionState;
     _connectStatus = connectStatus;
 
+    if (sessionState != UA_SESSIONSTATE_ACTIVATED)
+        _operationLimitsKnown = false; // the next session may be on another server
+
     if (!connectStatus) {
         if (_lastSessionState != sessionState) {
             switch (sessionState) {
@@ -237,7 +245,7 @@ bool Client::getEndpoints(
     UA_EndpointDescription* endpointDescriptions     = nullptr;
     size_t                  endpointDescriptionsSize = 0;
     {
-        WriteLock l(m_mutex);
+        ClientLock l(*this);
         m_lastError = UA_Client_getEndpoints(
             m_pClient, serverUrl.c_str(),
             &endpointDescriptionsSize,
@@ -278,7 +286,7 @@ bool Client::findServers(
     ApplicationDescriptionArray& registeredServers) {
     if (!m_pClient) return false;
 
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = UA_Client_findServers(
         m_pClient,
         serverUrl.c_str(),
@@ -301,7 +309,7 @@ bool Client::findServersOnNetwork(
     const StringArray&      serverCapabilityFilter,
     ServerOnNetworkArray&   serverOnNetwork) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = UA_Client_findServersOnNetwork(
         m_pClient, serverUrl.c_str(),
         startingRecordId,
@@ -321,7 +329,7 @@ bool Client::readAttribute(
     void*               outVal,
     const UA_DataType&  type) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = __UA_Client_readAttribute(m_pClient, &nodeId, attr, outVal, &type);
     return lastOK();
 }
@@ -334,17 +342,143 @@ bool Client::writeAttribute(
     const void*         val,
     const UA_DataType&  type) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = __UA_Client_writeAttribute(m_pClient, &nodeId, attr, val, &type);
     return lastOK();
 }
 
+//*****************************************************************************
+
+/**
+ * Extract an operation limit from a read result.
+ * @return the limit, 0 (no limit) if the server doesn't expose it.
+ */
+static UA_UInt32 operationLimit(const UA_DataValue& value)
+{
+    if (value.hasValue && UA_Variant_hasScalarType(&value.value, &UA_TYPES[UA_TYPES_UINT32]))
+        return *static_cast<const UA_UInt32*>(value.value.data);
+    return 0;
+}
+
+//*****************************************************************************
+
+bool Client::readOperationLimits() {
+    if (!m_pClient) return false;
+
+    const UA_UInt32 ids[4] = {
+        UA_NS0ID_SERVER_SERVERCAPABILITIES_OPERATIONLIMITS_MAXNODESPERREAD,
+        UA_NS0ID_SERVER_SERVERCAPABILITIES_OPERATIONLIMITS_MAXNODESPERWRITE,
+        UA_NS0ID_SERVER_SERVERCAPABILITIES_OPERATIONLIMITS_MAXNODESPERBROWSE,
+        UA_NS0ID_SERVER_SERVERCAPABILITIES_OPERATIONLIMITS_MAXMONITOREDITEMSPERCALL};
+    UA_ReadValueId limits[4];
+    for (size_t i = 0; i < 4; i++) {
+        UA_ReadValueId_init(&limits[i]);
+        limits[i].nodeId      = UA_NODEID_NUMERIC(0, ids[i]);
+        limits[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead     = limits; // numeric ids, nothing to free
+    request.nodesToReadSize = 4;
+
+    ClientLock l(*this);
+    UA_ReadResponse response = UA_Client_Service_read(m_pClient, request);
+    m_lastError = response.responseHeader.serviceResult;
+    if (lastOK() && response.resultsSize == 4) {
+        _maxNodesPerRead            = operationLimit(response.results[0]);
+        _maxNodesPerWrite           = operationLimit(response.results[1]);
+        _maxNodesPerBrowse          = operationLimit(response.results[2]);
+        _maxMonitoredItemsPerCall   = operationLimit(response.results[3]);
+        _operationLimitsKnown       = true;
+    }
+    UA_ReadResponse_clear(&response);
+    return lastOK();
+}
+
+//*****************************************************************************
+
+bool Client::readMany(
+    const ReadValueIdList&  nodes,
+    DataValueList&          results,
+    UA_TimestampsToReturn   timestamps /*= UA_TIMESTAMPSTORETURN_SOURCE*/) {
+    if (!m_pClient) return false;
+
+    results.reset(nodes.size());
+    if (nodes.empty()) return true;
+    if (!_operationLimitsKnown)
+        readOperationLimits(); // on failure the batch is sent at once
+
+    ClientLock l(*this);
+    const size_t limit = _maxNodesPerRead ? _maxNodesPerRead : nodes.size();
+    for (size_t first = 0; first < nodes.size(); first += limit) {
+        const size_t count = std::min(limit, nodes.size() - first);
+
+        UA_ReadRequest request;
+        UA_ReadRequest_init(&request);
+        request.nodesToRead        = const_cast<UA_ReadValueId*>(nodes.data() + first); // not owned
+        request.nodesToReadSize    = count;
+        request.timestampsToReturn = timestamps;
+
+        UA_ReadResponse response = UA_Client_Service_read(m_pClient, request);
+        m_lastError = response.responseHeader.serviceResult;
+        if (lastOK() && response.resultsSize != count)
+            m_lastError = UA_STATUSCODE_BADUNEXPECTEDERROR;
+        if (lastOK()) {
+            results.take(first, response.results, count); // move, no deep copy
+        }
+        else {
+            for (size_t i = first; i < results.size(); i++) { // not read
+                results[i].hasStatus = true;
+                results[i].status    = m_lastError;
+            }
+        }
+        UA_ReadResponse_clear(&response);
+        if (!lastOK()) return false;
+    }
+    return true;
+}
+
+//*****************************************************************************
+
+bool Client::writeMany(const WriteValueList& values, std::vector<UA_StatusCode>& results) {
+    if (!m_pClient) return false;
+
+    results.assign(values.size(), UA_STATUSCODE_GOOD);
+    if (values.empty()) return true;
+    if (!_operationLimitsKnown)
+        readOperationLimits(); // on failure the batch is sent at once
+
+    ClientLock l(*this);
+    const size_t limit = _maxNodesPerWrite ? _maxNodesPerWrite : values.size();
+    for (size_t first = 0; first < values.size(); first += limit) {
+        const size_t count = std::min(limit, values.size() - first);
+
+        UA_WriteRequest request;
+        UA_WriteRequest_init(&request);
+        request.nodesToWrite     = const_cast<UA_WriteValue*>(values.data() + first); // not owned
+        request.nodesToWriteSize = count;
+
+        UA_WriteResponse response = UA_Client_Service_write(m_pClient, request);
+        m_lastError = response.responseHeader.serviceResult;
+        if (lastOK() && response.resultsSize != count)
+            m_lastError = UA_STATUSCODE_BADUNEXPECTEDERROR;
+        if (lastOK())
+            std::copy(response.results, response.results + count, results.begin() + first);
+        else
+            std::fill(results.begin() + first, results.end(), UA_StatusCode(m_lastError));
+        UA_WriteResponse_clear(&response);
+        if (!lastOK()) return false;
+    }
+    return true;
+}
+
 //*****************************************************************************
     UA_StatusCode Client::getState(
         UA_SecureChannelState& channelState,
         UA_SessionState& sessionState)
 {
-        ReadLock l(m_mutex);
+        ClientReadLock l(*this);
     if (m_pClient) {
         UA_StatusCode c;
         UA_Client_getState(m_pClient, &channelState, &sessionState, &c);
@@ -358,7 +492,7 @@ bool Client::writeAttribute(
 
 bool Client::connect(const std::string& endpointUrl) {
     initialise();
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient) throw std::runtime_error("Null client");
     m_lastError = UA_Client_connect(m_pClient, endpointUrl.c_str());
     return lastOK();
@@ -371,7 +505,7 @@ bool Client::connectUsername(
     const std::string& username,
     const std::string& password) {
     initialise();
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient) throw std::runtime_error("Null client");
     m_lastError = UA_Client_connectUsername(
         m_pClient,
@@ -391,7 +525,7 @@ bool Client::connectUsername(
 bool Client::connectAsync(const std::string& endpoint)
 {
     initialise();
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient)
         throw std::runtime_error("Null client");
     m_lastError = UA_Client_connectAsync(m_pClient, endpoint.c_str());
@@ -412,7 +546,7 @@ bool Client::connectAsync(const std::string& endpoint)
 bool Client::connectSecureChannel(const std::string& endpoint)
 {
     initialise();
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient)
         throw std::runtime_error("Null client");
     m_lastError = UA_Client_connectSecureChannel(m_pClient, endpoint.c_str());
@@ -434,7 +568,7 @@ bool Client::connectSecureChannel(const std::string& endpoint)
 bool Client::connectSecureChannelAsync(const std::string& endpoint)
 {
     initialise();
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient)
         throw std::runtime_error("Null client");
     m_lastError = UA_Client_connectSecureChannelAsync(m_pClient, endpoint.c_str());
@@ -451,7 +585,7 @@ bool Client::connectSecureChannelAsync(const std::string& endpoint)
 //*****************************************************************************
 
 bool Client::disconnect() {
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient) throw std::runtime_error("Null client");
     m_lastError = UA_Client_disconnect(m_pClient);
     return lastOK();
@@ -461,7 +595,7 @@ bool Client::disconnect() {
 
 bool Client::disconnectAsync()
 {
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient)
         throw std::runtime_error("Null client");
     _timerMap.clear();  // remove timer objects
@@ -473,7 +607,7 @@ bool Client::disconnectAsync()
 //*****************************************************************************
 
 int Client::namespaceGetIndex(const std::string& namespaceUri) {
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient) throw std::runtime_error("Null client");
     int namespaceIndex = 0;
     UA_String uri = toUA_String(namespaceUri);
@@ -509,7 +643,7 @@ static UA_StatusCode browseTreeCallBack(
 
 UANodeIdList Client::getChildrenList(const UA_NodeId& node) {
     UANodeIdList children;
-    WriteLock ll(m_mutex);
+    ClientLock ll(*this);
 
     UA_Client_forEachChildNodeCall(
         m_pClient, node,
@@ -521,22 +655,212 @@ UANodeIdList Client::getChildrenList(const UA_NodeId& node) {
 
 //*****************************************************************************
 
-bool Client::browseTree(const UA_NodeId& nodeId, UANode* node) {
+/**
+ * Number of nodes per BrowseRequest when the server doesn't limit it.
+ * Keeps the messages to a reasonable size.
+ */
+static const size_t defaultNodesPerBrowse = 1000;
+
+/**
+ * A node waiting to be browsed by Client::browseDescendants()
+ */
+struct PendingBrowse {
+    UA_NodeId   nodeId;  /**< owned copy */
+    void*       context; /**< visitor context */
+};
+
+/**
+ * Pass the forward references of a browse result to the visitor and queue the children to browse.
+ */
+static void visitReferences(
+    const PendingBrowse&            parent,
+    const UA_BrowseResult&          result,
+    const Client::BrowseVisitor&    visitor,
+    std::deque<PendingBrowse>&      queue) {
+    if (result.statusCode != UA_STATUSCODE_GOOD) return;
+
+    for (size_t i = 0; i < result.referencesSize; i++) {
+        const UA_ReferenceDescription& reference = result.references[i];
+        if (!reference.isForward) continue;
+
+        void* childContext = nullptr;
+        if (visitor(parent.nodeId, parent.context, reference, childContext)) {
+            PendingBrowse child;
+            UA_NodeId_copy(&reference.nodeId.nodeId, &child.nodeId);
+            child.context = childContext;
+            queue.push_back(child);
+        }
+    }
+}
+
+//*****************************************************************************
+
+/**
+ * Release the continuation points a browse will not follow, so the server frees them.
+ * Call holding the client lock.
+ * @param points the continuation points, cleared.
+ */
+static void releaseContinuationPoints(UA_Client* client, std::vector<UA_ByteString>& points) {
+    if (points.empty()) return;
+
+    UA_BrowseNextRequest request;
+    UA_BrowseNextRequest_init(&request);
+    request.releaseContinuationPoints   = true;
+    request.continuationPoints          = points.data();
+    request.continuationPointsSize      = points.size();
+    UA_BrowseNextResponse response = UA_Client_Service_browseNext(client, request);
+    UA_BrowseNextResponse_clear(&response);
+
+    for (auto& c : points) UA_ByteString_clear(&c);
+    points.clear();
+}
+
+//*****************************************************************************
+
+bool Client::browseDescendants(const UA_NodeId& start, void* context, const BrowseVisitor& visitor) {
     if (!m_pClient) return false;
-    
-    for (auto& child : getChildrenList(nodeId)) {
-        if (child.namespaceIndex < 1) continue;
-
-        QualifiedName outBrowseName;
-        if (!readBrowseName(child, outBrowseName)) continue;
-        
-        // create the node in the tree using the browse name as key
-        auto dataCopy = child;        // deep copy
-        UANode* pNewNode = node->createChild(toString(outBrowseName.name()));
-        pNewNode->setData(dataCopy);
-        browseTree(child, pNewNode);    // recurse
+    if (!_operationLimitsKnown)
+        readOperationLimits(); // on failure the default is used
+
+    size_t limit;
+    {
+        ClientReadLock l(*this);
+        limit = _maxNodesPerBrowse ? _maxNodesPerBrowse : defaultNodesPerBrowse;
     }
-    return lastOK();
+
+    std::deque<PendingBrowse> queue;
+    PendingBrowse first;
+    UA_NodeId_copy(&start, &first.nodeId);
+    first.context = context;
+    queue.push_back(first);
+
+    // the lock is only held by the service calls: the visitor may call the client
+    UA_StatusCode status = UA_STATUSCODE_GOOD;
+    std::vector<PendingBrowse>        batch;
+    std::vector<UA_BrowseDescription> descriptions;
+    std::vector<UA_ByteString>        continuations;
+    std::vector<size_t>               owners;  // batch index of each continuation point
+    while (!queue.empty() && status == UA_STATUSCODE_GOOD) {
+        // take the oldest pending nodes, whatever their depth
+        const size_t count = std::min(limit, queue.size());
+        batch.assign(queue.begin(), queue.begin() + count);
+        queue.erase(queue.begin(), queue.begin() + count);
+
+        descriptions.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            UA_BrowseDescription_init(&descriptions[i]);
+            descriptions[i].nodeId          = batch[i].nodeId; // not owned
+            descriptions[i].browseDirection = UA_BROWSEDIRECTION_FORWARD;
+            descriptions[i].includeSubtypes = true;
+            descriptions[i].resultMask      = UA_BROWSERESULTMASK_REFERENCETYPEID
+                                            | UA_BROWSERESULTMASK_ISFORWARD
+                                            | UA_BROWSERESULTMASK_BROWSENAME;
+        }
+
+        UA_BrowseRequest request;
+        UA_BrowseRequest_init(&request);
+        request.nodesToBrowse     = descriptions.data();
+        request.nodesToBrowseSize = count;
+
+        UA_BrowseResponse response;
+        {
+            ClientLock l(*this);
+            response = UA_Client_Service_browse(m_pClient, request);
+        }
+        status = response.responseHeader.serviceResult;
+        if (status == UA_STATUSCODE_GOOD && response.resultsSize != count)
+            status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+
+        continuations.clear();
+        owners.clear();
+        for (size_t i = 0; i < response.resultsSize; i++) {
+            UA_BrowseResult& result = response.results[i];
+            if (status == UA_STATUSCODE_GOOD)
+                visitReferences(batch[i], result, visitor, queue);
+            if (result.continuationPoint.length > 0) { // taken, followed or released
+                continuations.push_back(result.continuationPoint);
+                UA_ByteString_init(&result.continuationPoint);
+                owners.push_back(i);
+            }
+        }
+        UA_BrowseResponse_clear(&response);
+
+        // get the rest of the truncated results
+        while (!continuations.empty() && status == UA_STATUSCODE_GOOD) {
+            UA_BrowseNextRequest next;
+            UA_BrowseNextRequest_init(&next);
+            next.continuationPoints     = continuations.data();
+            next.continuationPointsSize = continuations.size();
+
+            UA_BrowseNextResponse nextResponse;
+            {
+                ClientLock l(*this);
+                nextResponse = UA_Client_Service_browseNext(m_pClient, next);
+            }
+            status = nextResponse.responseHeader.serviceResult;
+            if (status == UA_STATUSCODE_GOOD && nextResponse.resultsSize != continuations.size())
+                status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+
+            for (auto& c : continuations) UA_ByteString_clear(&c); // consumed by the request
+            continuations.clear();
+
+            std::vector<size_t> nextOwners;
+            for (size_t i = 0; i < nextResponse.resultsSize; i++) {
+                UA_BrowseResult& result = nextResponse.results[i];
+                const size_t owner = i < owners.size() ? owners[i] : 0;
+                if (status == UA_STATUSCODE_GOOD)
+                    visitReferences(batch[owner], result, visitor, queue);
+                if (result.continuationPoint.length > 0) {
+                    continuations.push_back(result.continuationPoint);
+                    UA_ByteString_init(&result.continuationPoint);
+                    nextOwners.push_back(owner);
+                }
+            }
+            owners.swap(nextOwners);
+            UA_BrowseNextResponse_clear(&nextResponse);
+        }
+        if (!continuations.empty()) { // left by an error
+            ClientLock l(*this);
+            releaseContinuationPoints(m_pClient, continuations);
+        }
+
+        for (auto& b : batch) UA_NodeId_clear(&b.nodeId);
+    }
+
+    for (auto& q : queue) UA_NodeId_clear(&q.nodeId); // left by an error, never browsed
+
+    ClientLock l(*this);
+    m_lastError = status;
+    return status == UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+bool Client::browseTree(const UA_NodeId& nodeId, UANode* node) {
+    if (!m_pClient) return false;
+
+    return browseDescendants(nodeId, node,
+        [](const UA_NodeId&, void* parentContext, const UA_ReferenceDescription& reference, void*& childContext) {
+            const UA_NodeId& child = reference.nodeId.nodeId;
+            if (reference.nodeId.serverIndex != 0 || child.namespaceIndex < 1)
+                return false;
+
+            auto parent = (UANode*)parentContext;
+            for (UANode* p = parent; p; p = p->parent()) { // no loop
+                if (UA_NodeId_equal(p->constData().constRef(), &child))
+                    return false;
+            }
+
+            // create the node in the tree using the browse name as key
+            const std::string name = toString(reference.browseName.name);
+            if (parent->children().count(name))
+                return false; // keep the first sibling, it may be pending
+
+            UANode* pNewNode = parent->createChild(name);
+            pNewNode->setData(NodeId(child)); // deep copy
+            childContext = pNewNode;
+            return true;
+        });
 }
 
 //*****************************************************************************
@@ -556,17 +880,39 @@ bool Client::browseTree(const NodeId& nodeId, NodeIdMap& outNodeMap) {
 
 //*****************************************************************************
 
+/**
+ * Add the descendants of a node in its namespace to a NodeIdMap or a NodeIdHashMap,
+ * the put() of the map rejecting the duplicates.
+ */
+template <typename Map>
+static bool addDescendants(Client& client, const UA_NodeId& nodeId, Map& nodeMap) {
+    return client.browseDescendants(nodeId, nullptr,
+        [&nodeMap](const UA_NodeId& parent, void*, const UA_ReferenceDescription& reference, void*&) {
+            const UA_NodeId& child = reference.nodeId.nodeId;
+            if (reference.nodeId.serverIndex != 0 || child.namespaceIndex != parent.namespaceIndex)
+                return false; // only in same namespace
+
+            return nodeMap.put(child); // no duplicates
+        });
+}
+
+//*****************************************************************************
+
 bool Client::browseChildren(const UA_NodeId& nodeId, NodeIdMap& nodeMap) {
-    for (auto& child : getChildrenList(nodeId)) {
-        if (child.namespaceIndex != nodeId.namespaceIndex)
-            continue; // only in same namespace
+    return addDescendants(*this, nodeId, nodeMap);
+}
 
-        if (nodeMap.find(toString(child)) == nodeMap.end()) {
-            nodeMap.put(child);
-            browseChildren(child, nodeMap); // recurse no duplicates
-        }
-    }
-    return lastOK();
+//*****************************************************************************
+
+bool Client::browseTree(const NodeId& nodeId, NodeIdHashMap& outNodeMap) {
+    outNodeMap.put(nodeId);
+    return browseChildren(nodeId, outNodeMap);
+}
+
+//*****************************************************************************
+
+bool Client::browseChildren(const UA_NodeId& nodeId, NodeIdHashMap& nodeMap) {
+    return addDescendants(*this, nodeId, nodeMap);
 }
 
 //*****************************************************************************
@@ -644,7 +990,7 @@ bool Client::getChild(const NodeId& start, const std::string& childName, NodeId&
 //*****************************************************************************
 
 bool Client::readBrowseName(const NodeId& nodeId, std::string& outName, int& outNamespace) {
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient) throw std::runtime_error("Null client");
     QualifiedName outBrowseName;
     m_lastError = UA_Client_readBrowseNameAttribute(m_pClient, nodeId, outBrowseName);
@@ -659,7 +1005,7 @@ bool Client::readBrowseName(const NodeId& nodeId, std::string& outName, int& out
 
 void Client::setBrowseName(NodeId& nodeId, int nameSpaceIndex, const std::string& name)
 {
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient) throw std::runtime_error("Null client");
     QualifiedName newBrowseName(nameSpaceIndex, name);
     UA_Client_writeBrowseNameAttribute(m_pClient, nodeId, newBrowseName);
@@ -672,7 +1018,7 @@ bool Client::readArrayDimensions(
     std::vector<UA_UInt32>& ret) {
     if (!m_pClient) return false;
 
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     size_t      outArrayDimensionsSize  = 0;
     UA_UInt32*  outArrayDimensions      = nullptr;
     m_lastError = UA_Client_readArrayDimensionsAttribute(
@@ -711,7 +1057,7 @@ bool Client::setArrayDimensions(
 //*****************************************************************************
 
 bool Client::deleteNode(const NodeId& nodeId, bool deleteReferences) {
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient) throw std::runtime_error("Null client");
     m_lastError = UA_Client_deleteNode(m_pClient, nodeId, UA_Boolean(deleteReferences));
     return lastOK();
@@ -722,11 +1068,11 @@ bool Client::deleteNode(const NodeId& nodeId, bool deleteReferences) {
 bool Client::deleteTree(const NodeId& nodeId) {
     if (!m_pClient) return false;
 
-    NodeIdMap nodeMap;
+    NodeIdHashMap nodeMap;
     browseTree(nodeId, nodeMap);
     for (auto& node : nodeMap) {
         if (node.second.namespaceIndex > 0) { // namespace 0 appears to be reserved
-            WriteLock l(m_mutex);
+            ClientLock l(*this);
             UA_Client_deleteNode(m_pClient, node.second, true);
         }
     }
@@ -740,7 +1086,7 @@ bool Client::callMethod(
     const NodeId&       methodId,
     const VariantList&  in,
     VariantArray&       out) {
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (!m_pClient) throw std::runtime_error("Null client");
 
     size_t      outputSize  = 0;
@@ -770,7 +1116,7 @@ bool Client::addFolder(
     NodeId&             outNewNodeId     /*= NodeId::Null*/,
     int                 nameSpaceIndex   /*= 0*/) {
     if(!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (nameSpaceIndex == 0)
         nameSpaceIndex = parent.nameSpaceIndex(); // inherit parent by default
 
@@ -797,7 +1143,7 @@ bool Client::addVariable(
     NodeId&             outNewNodeId     /*= NodeId::Null*/,
     int                 nameSpaceIndex   /*= 0*/) {
     if(!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (nameSpaceIndex == 0)
         nameSpaceIndex = parent.nameSpaceIndex(); // inherit parent by default
 
@@ -824,7 +1170,7 @@ bool Client::addProperty(
     NodeId&             outNewNodeId    /*= NodeId::Null*/,
     int                 nameSpaceIndex  /*= 0*/) {
     if(!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     if (nameSpaceIndex == 0)
         nameSpaceIndex = parent.nameSpaceIndex(); // inherit parent by default
 
@@ -851,7 +1197,7 @@ bool Client::addVariableTypeNode(
     const VariableTypeAttributes& attr,
     NodeId&                       outNewNodeId /*= NodeId::Null*/) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = UA_Client_addVariableTypeNode(
         m_pClient,
         nodeId,
@@ -874,7 +1220,7 @@ bool Client::addObjectNode(
     const ObjectAttributes&   attr,
     NodeId&                   outNewNodeId /*= NodeId::Null*/) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = UA_Client_addObjectNode(
         m_pClient,
         nodeId,
@@ -897,7 +1243,7 @@ bool Client::addObjectTypeNode(
     const ObjectTypeAttributes&   attr,
     NodeId&                       outNewNodeId /*= NodeId::Null*/) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = UA_Client_addObjectTypeNode(
         m_pClient,
         nodeId,
@@ -919,7 +1265,7 @@ bool Client::addViewNode(
     const ViewAttributes& attr,
     NodeId&               outNewNodeId /*= NodeId::Null*/) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = UA_Client_addViewNode(
         m_pClient,
         nodeId,
@@ -941,7 +1287,7 @@ bool Client::addReferenceTypeNode(
     const ReferenceTypeAttributes& attr,
     NodeId&                        outNewNodeId /*= NodeId::Null*/) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = UA_Client_addReferenceTypeNode(
         m_pClient,
         nodeId,
@@ -963,7 +1309,7 @@ bool Client::addDataTypeNode(
     const DataTypeAttributes& attr,
     NodeId&                   outNewNodeId /*= NodeId::Null*/) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = UA_Client_addDataTypeNode(
         m_pClient,
         nodeId,
@@ -985,7 +1331,7 @@ bool Client::addMethodNode(
     const MethodAttributes&   attr,
     NodeId&                   outNewNodeId /*= NodeId::Null*/) {
     if (!m_pClient) return false;
-    WriteLock l(m_mutex);
+    ClientLock l(*this);
     m_lastError = UA_Client_addMethodNode(
         m_pClient,
         nodeId,
@@ -1015,6 +1361,253 @@ UA_Boolean Client::historicalIteratorCallback(
 
 //*****************************************************************************
 
+void Client::asyncOperationCallback(
+    UA_Client*  client,
+    void*       userdata,
+    UA_UInt32   /*requestId*/,
+    void*       response) {
+    std::unique_ptr<AsyncOperation> operation((AsyncOperation*)userdata);
+    if (operation && response)
+        operation->complete(response);
+    else if (operation)
+        operation->fail(UA_STATUSCODE_BADUNEXPECTEDERROR);
+
+    if (auto p = (Client*)UA_Client_getContext(client)) {
+        {
+            std::lock_guard<std::mutex> l(p->_asyncMutex);
+            if (p->_asyncInFlight > 0) p->_asyncInFlight--;
+        }
+        p->dispatchAsync(); // a slot is free
+    }
+}
+
+//*****************************************************************************
+
+void Client::dispatchAsync() {
+    for (;;) {
+        std::unique_ptr<AsyncOperation> operation;
+        {
+            std::lock_guard<std::mutex> l(_asyncMutex);
+            if (_asyncQueue.empty() || _asyncInFlight >= _asyncWindow)
+                return;
+            operation.reset(_asyncQueue.front());
+            _asyncQueue.pop_front();
+            _asyncInFlight++;
+        }
+
+        UA_UInt32 requestId = 0;
+        UA_StatusCode status = m_pClient
+            ? UA_Client_sendAsyncRequest(
+                m_pClient,
+                operation->request(),
+                operation->requestType(),
+                asyncOperationCallback,
+                operation->responseType(),
+                operation.get(),
+                &requestId)
+            : UA_STATUSCODE_BADSERVERNOTCONNECTED;
+
+        if (status == UA_STATUSCODE_GOOD) {
+            operation.release(); // owned by the stack until the call-back
+        }
+        else {
+            {
+                std::lock_guard<std::mutex> l(_asyncMutex);
+                _asyncInFlight--;
+            }
+            operation->fail(status);
+        }
+    }
+}
+
+//*****************************************************************************
+
+void Client::cancelAsync(UA_StatusCode status) {
+    std::deque<AsyncOperation*> queue;
+    {
+        std::lock_guard<std::mutex> l(_asyncMutex);
+        queue.swap(_asyncQueue);
+    }
+    for (AsyncOperation* p : queue) {
+        std::unique_ptr<AsyncOperation> operation(p);
+        operation->fail(status);
+    }
+}
+
+//*****************************************************************************
+
+bool Client::submitAsync(AsyncOperation* operation) {
+    if (!operation) return false;
+    if (!m_pClient) {
+        std::unique_ptr<AsyncOperation> failed(operation);
+        failed->fail(UA_STATUSCODE_BADSERVERNOTCONNECTED);
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> l(_asyncMutex);
+        _asyncQueue.push_back(operation);
+    }
+    {
+        ClientLock l(*this); // nested in a completion, the client is already owned by this thread
+        dispatchAsync();
+    }
+    return m_pClient && getConnectStatus() == UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+bool Client::readAsync(
+    const ReadValueIdList&  nodes,
+    AsyncRead::Completion   done,
+    UA_TimestampsToReturn   timestamps /*= UA_TIMESTAMPSTORETURN_SOURCE*/) {
+    auto operation = new AsyncRead(std::move(done));
+    UA_ReadRequest& request = operation->get();
+    request.timestampsToReturn = timestamps;
+    if (!nodes.empty() &&
+        UA_Array_copy(nodes.data(), nodes.size(), (void**)&request.nodesToRead,
+                      &UA_TYPES[UA_TYPES_READVALUEID]) == UA_STATUSCODE_GOOD)
+        request.nodesToReadSize = nodes.size();
+    return submitAsync(operation);
+}
+
+//*****************************************************************************
+
+bool Client::writeAsync(const WriteValueList& values, AsyncWrite::Completion done) {
+    auto operation = new AsyncWrite(std::move(done));
+    UA_WriteRequest& request = operation->get();
+    if (!values.empty() &&
+        UA_Array_copy(values.data(), values.size(), (void**)&request.nodesToWrite,
+                      &UA_TYPES[UA_TYPES_WRITEVALUE]) == UA_STATUSCODE_GOOD)
+        request.nodesToWriteSize = values.size();
+    return submitAsync(operation);
+}
+
+//*****************************************************************************
+
+bool Client::browseAsync(const UA_BrowseRequest& request, AsyncBrowse::Completion done) {
+    auto operation = new AsyncBrowse(std::move(done));
+    UA_BrowseRequest_copy(&request, &operation->get());
+    return submitAsync(operation);
+}
+
+//*****************************************************************************
+
+bool Client::callAsync(
+    const NodeId&           objectId,
+    const NodeId&           methodId,
+    const VariantList&      in,
+    AsyncCall::Completion   done) {
+    auto operation = new AsyncCall(std::move(done));
+    UA_CallRequest& request = operation->get();
+    request.methodsToCall = UA_CallMethodRequest_new();
+    if (request.methodsToCall) {
+        request.methodsToCallSize = 1;
+        UA_CallMethodRequest& method = request.methodsToCall[0];
+        UA_NodeId_copy(objectId.constRef(), &method.objectId);
+        UA_NodeId_copy(methodId.constRef(), &method.methodId);
+        if (!in.empty() &&
+            UA_Array_copy(in.data(), in.size(), (void**)&method.inputArguments,
+                          &UA_TYPES[UA_TYPES_VARIANT]) == UA_STATUSCODE_GOOD)
+            method.inputArgumentsSize = in.size();
+    }
+    return submitAsync(operation);
+}
+
+//*****************************************************************************
+
+bool Client::historyReadAsync(const UA_HistoryReadRequest& request, AsyncHistoryRead::Completion done) {
+    auto operation = new AsyncHistoryRead(std::move(done));
+    UA_HistoryReadRequest_copy(&request, &operation->get());
+    return submitAsync(operation);
+}
+
+//*****************************************************************************
+
+bool Client::historyReadRawAsync(
+    const NodeId&                   node,
+    UA_DateTime                     startTime,
+    UA_DateTime                     endTime,
+    unsigned                        numValuesPerNode,
+    AsyncHistoryRead::Completion    done) {
+    auto operation = new AsyncHistoryRead(std::move(done));
+    UA_HistoryReadRequest& request = operation->get();
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+
+    if (auto details = UA_ReadRawModifiedDetails_new()) {
+        details->isReadModified   = false;
+        details->startTime        = startTime;
+        details->endTime          = endTime;
+        details->numValuesPerNode = numValuesPerNode;
+        details->returnBounds     = false;
+        request.historyReadDetails.encoding             = UA_EXTENSIONOBJECT_DECODED;
+        request.historyReadDetails.content.decoded.type = &UA_TYPES[UA_TYPES_READRAWMODIFIEDDETAILS];
+        request.historyReadDetails.content.decoded.data = details;
+    }
+    request.nodesToRead = UA_HistoryReadValueId_new();
+    if (request.nodesToRead) {
+        request.nodesToReadSize = 1;
+        UA_NodeId_copy(node.constRef(), &request.nodesToRead[0].nodeId);
+    }
+    return submitAsync(operation);
+}
+
+//*****************************************************************************
+
+std::future<ReadResponse> Client::readFuture(
+    const ReadValueIdList&  nodes,
+    UA_TimestampsToReturn   timestamps /*= UA_TIMESTAMPSTORETURN_SOURCE*/) {
+    auto promise = std::make_shared<std::promise<ReadResponse>>();
+    readAsync(nodes, [promise](UA_ReadResponse& response) {
+        promise->set_value(takeResponse<UA_ReadResponse, UA_TYPES_READRESPONSE>(response));
+    }, timestamps);
+    return promise->get_future();
+}
+
+//*****************************************************************************
+
+std::future<WriteResponse> Client::writeFuture(const WriteValueList& values) {
+    auto promise = std::make_shared<std::promise<WriteResponse>>();
+    writeAsync(values, [promise](UA_WriteResponse& response) {
+        promise->set_value(takeResponse<UA_WriteResponse, UA_TYPES_WRITERESPONSE>(response));
+    });
+    return promise->get_future();
+}
+
+//*****************************************************************************
+
+std::future<BrowseResponse> Client::browseFuture(const UA_BrowseRequest& request) {
+    auto promise = std::make_shared<std::promise<BrowseResponse>>();
+    browseAsync(request, [promise](UA_BrowseResponse& response) {
+        promise->set_value(takeResponse<UA_BrowseResponse, UA_TYPES_BROWSERESPONSE>(response));
+    });
+    return promise->get_future();
+}
+
+//*****************************************************************************
+
+std::future<CallResponse> Client::callFuture(
+    const NodeId&       objectId,
+    const NodeId&       methodId,
+    const VariantList&  in) {
+    auto promise = std::make_shared<std::promise<CallResponse>>();
+    callAsync(objectId, methodId, in, [promise](UA_CallResponse& response) {
+        promise->set_value(takeResponse<UA_CallResponse, UA_TYPES_CALLRESPONSE>(response));
+    });
+    return promise->get_future();
+}
+
+//*****************************************************************************
+
+std::future<HistoryReadResponse> Client::historyReadFuture(const UA_HistoryReadRequest& request) {
+    auto promise = std::make_shared<std::promise<HistoryReadResponse>>();
+    historyReadAsync(request, [promise](UA_HistoryReadResponse& response) {
+        promise->set_value(takeResponse<UA_HistoryReadResponse, UA_TYPES_HISTORYREADRESPONSE>(response));
+    });
+    return promise->get_future();
+}
+
+//*****************************************************************************
+
 bool Client::historyReadRaw(
     const NodeId&       node,
     UA_DateTime         startTime,
@@ -18,9 +18,120 @@
 #include <open62541cpp/condition.h>
 #include <open62541cpp/servermethod.h>
 #include <open62541cpp/open62541timer.h>
+#include <open62541cpp/samplingmanager.h>
+#include <open62541cpp/serverupdatequeue.h>
+#include <mutex>
 
 namespace Open62541 {
-Server::ServerMap Server::s_serverMap;
+
+// Registry of the running servers, read without lock by the call-backs.
+// A slot is written by register then key, and cleared by key then server.
+// The version changes on every registration, invalidating the per-thread caches.
+namespace {
+struct ServerSlot {
+    std::atomic<const UA_Server*>   key{nullptr};
+    std::atomic<Server*>            server{nullptr};
+};
+
+const int               MaxServers = 64;    /**< maximum number of servers running at the same time */
+ServerSlot              serverSlots[MaxServers];
+std::atomic<unsigned>   serverVersion{0};
+std::mutex              serverRegisterMutex; // serialises the writers only
+
+struct LastServer {
+    const UA_Server*    key     = nullptr;
+    Server*             server  = nullptr;
+    unsigned            version = 0;
+};
+thread_local LastServer lastServer;
+} // namespace
+
+//*****************************************************************************
+
+/**
+ * Compare the Value attribute of a node with a new value, the server being locked.
+ * A data source node is read for it.
+ * @return true if the variant and the status, Good if absent, are equal.
+ */
+static bool valueUnchanged(UA_Server* server, const UA_NodeId& node, const UA_DataValue& value) {
+    UA_ReadValueId item;
+    UA_ReadValueId_init(&item);
+    item.nodeId      = node; // shallow, not owned
+    item.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataValue current = UA_Server_read(server, &item, UA_TIMESTAMPSTORETURN_NEITHER);
+    const bool unchanged = current.hasValue == value.hasValue
+        && (current.hasStatus ? current.status : UA_STATUSCODE_GOOD)
+           == (value.hasStatus ? value.status : UA_STATUSCODE_GOOD)
+        && UA_order(&current.value, &value.value, &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_EQ;
+    UA_DataValue_clear(&current);
+    return unchanged;
+}
+
+//*****************************************************************************
+
+Server* Server::findServer(const UA_Server* pUAServer) {
+    if (!pUAServer) return nullptr;
+
+    unsigned version = serverVersion.load(std::memory_order_acquire);
+    if (lastServer.key == pUAServer && lastServer.version == version)
+        return lastServer.server; // the call-backs of one server come from the same thread
+
+    for (;;) {
+        Server* found = nullptr;
+        for (auto& slot : serverSlots) {
+            if (slot.key.load(std::memory_order_acquire) == pUAServer) {
+                found = slot.server.load(std::memory_order_acquire);
+                break;
+            }
+        }
+        const unsigned after = serverVersion.load(std::memory_order_acquire);
+        if (after == version) { // no registration changed the slots while scanning
+            lastServer.key     = pUAServer;
+            lastServer.server  = found;
+            lastServer.version = version;
+            return found;
+        }
+        version = after;
+    }
+}
+
+//*****************************************************************************
+
+void Server::registerServer(const UA_Server* pUAServer, Server* pServer) {
+    std::lock_guard<std::mutex> l(serverRegisterMutex);
+    ServerSlot* empty = nullptr;
+    for (auto& slot : serverSlots) {
+        const UA_Server* key = slot.key.load(std::memory_order_relaxed);
+        if (key == pUAServer) { // re-registration
+            slot.server.store(pServer, std::memory_order_release);
+            serverVersion.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        if (!key && !empty) empty = &slot;
+    }
+    if (!empty) throw std::runtime_error("Too many running servers");
+
+    empty->server.store(pServer, std::memory_order_release);
+    empty->key.store(pUAServer, std::memory_order_release);
+    serverVersion.fetch_add(1, std::memory_order_release);
+}
+
+//*****************************************************************************
+
+void Server::unregisterServer(const UA_Server* pUAServer, const Server* pServer) {
+    std::lock_guard<std::mutex> l(serverRegisterMutex);
+    for (auto& slot : serverSlots) {
+        if (slot.key.load(std::memory_order_relaxed) == pUAServer
+            && slot.server.load(std::memory_order_relaxed) == pServer) {
+            slot.key.store(nullptr, std::memory_order_release);
+            slot.server.store(nullptr, std::memory_order_release);
+            serverVersion.fetch_add(1, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+//*****************************************************************************
 
 void Server::timerCallback(UA_Server*, void* data)
 {
@@ -123,6 +234,24 @@ void Server::removeTimerEvent(UA_UInt64 callbackId)
 {
     _timerMap.erase(callbackId);
 }
+
+/*!
+ * \brief enableTimerWheel
+ * \param tickMs
+ * \return true on success
+ */
+bool Server::enableTimerWheel(unsigned tickMs)
+{
+    if (_timerWheel || !m_pServer) return false;
+    _timerWheel.reset(new TimerWheel(tickMs, UA_DateTime_nowMonotonic() / UA_DATETIME_MSEC));
+    if (!addRepeatedTimerEvent(_timerWheel->tick(), _timerWheelId, [this](Timer&) {
+            _timerWheel->advance(UA_DateTime_nowMonotonic() / UA_DATETIME_MSEC);
+        })) {
+        _timerWheel.reset();
+        return false;
+    }
+    return true;
+}
 //***********************************************************************************
 /*!
     \brief Server::findContext
@@ -161,6 +290,7 @@ void Server::destructor(
 
     if (Server* pServer = findServer(server)) {
         NodeId node(*nodeId);
+        ((NodeContext*)nodeContext)->forgetReadCache(*nodeId);
         ((NodeContext*)nodeContext)->destruct(*pServer, node);
     }
 }
@@ -193,6 +323,18 @@ void Server::monitoredItemRegisterCallback(UA_Server* server,
     }
 }
 
+void Server::monitoredItemRegister(const UA_NodeId* /*sessionId*/,
+                                   void* /*sessionContext*/,
+                                   const UA_NodeId* nodeId,
+                                   void* /*nodeContext*/,
+                                   uint32_t attibuteId,
+                                   bool removed)
+{
+    if (_samplingManager && nodeId) {
+        _samplingManager->monitoredItemRegister(*nodeId, attibuteId, removed);
+    }
+}
+
 UA_Boolean Server::createOptionalChildCallback(UA_Server* server,
                                                           const UA_NodeId* sessionId,
                                                           void* sessionContext,
@@ -516,7 +658,7 @@ void Server::shutdown()
     if (!m_pServer) return;
 
     UA_Server_run_shutdown(m_pServer);
-    s_serverMap.erase(m_pServer); // unreachable by call-backs
+    unregisterServer(m_pServer, this); // unreachable by call-backs
 }
 
 
@@ -538,8 +680,8 @@ void Server::terminate()
     _conditionMap.clear();
 #endif
     UA_Server_run_shutdown(m_pServer);
-    UA_Server_delete(m_pServer);
-    s_serverMap.erase(m_pServer); // unreachable by call-backs
+    UA_Server_delete(m_pServer); // the node destructors still find the server
+    unregisterServer(m_pServer, this); // unreachable by call-backs
     m_pServer = nullptr;
 }
 
@@ -565,7 +707,7 @@ void Server::start() {
 
 void Server::create()
 {
-  s_serverMap[m_pServer] = this; // map for call-backs
+  registerServer(m_pServer, this); // reachable by call-backs
   UA_Server_run_startup(m_pServer);
 }
 
@@ -574,6 +716,7 @@ void Server::create()
 void Server::iterate()
 {
   UA_Server_run_iterate(m_pServer, true);
+  applyUpdates();
   // called from time to time.
   // Only safe places to access server are in process() and callbacks
   process();
@@ -581,6 +724,15 @@ void Server::iterate()
 
 //*****************************************************************************
 
+bool Server::enableUpdateQueue(size_t maxNodes /*= 65536*/, double budget /*= 5*/)
+{
+  if (_updateQueue || maxNodes < 1) return false;
+  _updateQueue = std::make_shared<ServerUpdateQueue>(maxNodes, budget);
+  return true;
+}
+
+//*****************************************************************************
+
 void Server::applyEndpoints(EndpointDescriptionArray& endpoints) {
     m_pConfig->endpoints     = endpoints.data();
     m_pConfig->endpointsSize = endpoints.length();
@@ -617,17 +769,19 @@ bool Server::browseTree(const UA_NodeId& nodeId, UANode* node)
     // form a heirachical tree of nodes
     UANodeIdList l;  // shallow copy node IDs and take ownership
     {
-        WriteLock ll(m_mutex);
+        ServerReadLock ll(m_mutex);
         UA_Server_forEachChildNodeCall(m_pServer, nodeId, browseTreeCallBack, &l);  // get the childlist
     }
     for (int i = 0; i < int(l.size()); i++) {
         if (l[i].namespaceIndex > 0) {
             QualifiedName outBrowseName;
+            UA_StatusCode status;
             {
-                WriteLock ll(m_mutex);
-                _lastError = __UA_Server_read(m_pServer, &l[i], UA_ATTRIBUTEID_BROWSENAME, outBrowseName);
+                ServerReadLock ll(m_mutex);
+                status = __UA_Server_read(m_pServer, &l[i], UA_ATTRIBUTEID_BROWSENAME, outBrowseName);
             }
-            if (_lastError == UA_STATUSCODE_GOOD) {
+            _lastError = status;
+            if (status == UA_STATUSCODE_GOOD) {
                 std::string s = toString(outBrowseName.get().name);  // get the browse name and leak key
                 auto nId = l[i];                                // deep copy
                 UANode* n     = node->createChild(s);                // create the node
@@ -644,7 +798,7 @@ bool Server::browseTree(const UA_NodeId& nodeId, UANode* node)
 bool Server::deleteTree(const NodeId& nodeId) {
     if (!m_pServer) return false;
 
-    NodeIdMap nodeMap; // set of nodes to delete
+    NodeIdHashMap nodeMap; // set of nodes to delete
     browseTree(nodeId, nodeMap);
     for (auto& node : nodeMap) {
         if (node.second.namespaceIndex > 0) { // namespace 0 appears to be reserved
@@ -678,7 +832,7 @@ void Server::setMdnsServerName(const std::string& name)
 
 UANodeIdList Server::getChildrenList(const UA_NodeId& node) {
     UANodeIdList children;
-    WriteLock ll(m_mutex);
+    ServerReadLock ll(m_mutex);
 
     UA_Server_forEachChildNodeCall(
         m_pServer, node,
@@ -690,26 +844,34 @@ UANodeIdList Server::getChildrenList(const UA_NodeId& node) {
 
 //*****************************************************************************
 
-bool Server::browseChildren(const UA_NodeId& nodeId, NodeIdMap& nodeMap) {
-    if (!m_pServer) return false;
-
-    UANodeIdList children;
-    {
-        WriteLock ll(m_mutex);
-        UA_Server_forEachChildNodeCall( // get the child list
-            m_pServer, nodeId,
-            browseTreeCallBack,
-            &children);
-    }
-    for (auto& child : getChildrenList(nodeId)) {
+/**
+ * Add the descendants of a node in its namespace to a NodeIdMap or a NodeIdHashMap,
+ * the put() of the map rejecting the duplicates.
+ */
+template <typename Map>
+static void addDescendants(Server& server, const UA_NodeId& nodeId, Map& nodeMap) {
+    for (auto& child : server.getChildrenList(nodeId)) { // shared lock only while listing
         if (child.namespaceIndex != nodeId.namespaceIndex)
             continue; // only in same namespace
 
-        if (nodeMap.find(toString(child)) == nodeMap.end()) {
-            nodeMap.put(child);
-            browseChildren(child, nodeMap); // recurse no duplicates
-        }
+        if (nodeMap.put(child))
+            addDescendants(server, child, nodeMap); // recurse no duplicates
     }
+}
+
+//*****************************************************************************
+
+bool Server::browseChildren(const UA_NodeId& nodeId, NodeIdMap& nodeMap) {
+    if (!m_pServer) return false;
+    addDescendants(*this, nodeId, nodeMap);
+    return lastOK();
+}
+
+//*****************************************************************************
+
+bool Server::browseChildren(const UA_NodeId& nodeId, NodeIdHashMap& nodeMap) {
+    if (!m_pServer) return false;
+    addDescendants(*this, nodeId, nodeMap);
     return lastOK();
 }
 
@@ -740,6 +902,13 @@ bool Server::browseTree(const NodeId& nodeId, NodeIdMap& nodeMap) {
 
 //*****************************************************************************
 
+bool Server::browseTree(const NodeId& nodeId, NodeIdHashMap& nodeMap) {
+    nodeMap.put(nodeId);
+    return browseChildren(nodeId, nodeMap);
+}
+
+//*****************************************************************************
+
 bool Server::getNodeContext(const NodeId& node, NodeContext*& pContext) {
     if (!server()) return false;
 
@@ -1418,7 +1587,7 @@ bool Server::translateBrowsePathToNodeIds(
     BrowsePathResult&   result) {
     if (!server()) return false;
 
-    WriteLock l(m_mutex);
+    ServerReadLock l(m_mutex);
     result = UA_Server_translateBrowsePathToNodeIds(m_pServer, path);
     return result.statusCode() == UA_STATUSCODE_GOOD;
 }
@@ -1431,9 +1600,13 @@ bool Server::readAttribute(
     void*            value) {
     if (!server()) return false;
 
-    WriteLock l(m_mutex);
-    _lastError = __UA_Server_read(m_pServer, nodeId, attributeId, value);
-    return lastOK();
+    UA_StatusCode status;
+    {
+        ServerReadLock l(m_mutex); // readers only exclude the writers
+        status = __UA_Server_read(m_pServer, nodeId, attributeId, value);
+    }
+    _lastError = status;
+    return status == UA_STATUSCODE_GOOD; // not lastOK(): another reader may have changed it
 }
 
 //*****************************************************************************
@@ -1452,6 +1625,76 @@ bool Server::writeAttribute(
 
 //*****************************************************************************
 
+bool Server::writeValues(
+    std::vector<std::pair<NodeId, Variant>>&    values,
+    std::vector<UA_StatusCode>&                 results,
+    bool                                        skipUnchanged /*= false*/) {
+    results.assign(values.size(), UA_STATUSCODE_GOOD);
+    if (!server()) return false;
+
+    UA_StatusCode failure = UA_STATUSCODE_GOOD;
+    WriteLock l(m_mutex); // once for the batch, the comparisons included
+
+    for (size_t i = 0; i < values.size(); i++) {
+        const UA_NodeId& node  = values[i].first;
+        UA_Variant*      value = values[i].second.ref();
+        if (!value) {
+            failure = results[i] = UA_STATUSCODE_BADINVALIDARGUMENT;
+            continue;
+        }
+
+        UA_DataValue dv;
+        UA_DataValue_init(&dv);
+        dv.value    = *value; // shallow view
+        dv.hasValue = true;
+        if (skipUnchanged && valueUnchanged(m_pServer, node, dv)) continue;
+
+        results[i] = __UA_Server_write(m_pServer, &node, UA_ATTRIBUTEID_VALUE, &UA_TYPES[UA_TYPES_VARIANT], value);
+        if (results[i] != UA_STATUSCODE_GOOD)
+            failure = results[i];
+    }
+    _lastError = failure;
+    return failure == UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+bool Server::writeValues(
+    WriteValueList&             values,
+    std::vector<UA_StatusCode>& results,
+    bool                        skipUnchanged /*= false*/) {
+    results.assign(values.size(), UA_STATUSCODE_GOOD);
+    if (!server()) return false;
+
+    UA_StatusCode failure = UA_STATUSCODE_GOOD;
+    WriteLock l(m_mutex); // once for the batch, the comparisons included
+
+    for (size_t i = 0; i < values.size(); i++) {
+        UA_WriteValue& item = values[i];
+        if (skipUnchanged && valueUnchanged(m_pServer, item.nodeId, item.value)) continue;
+
+        UA_WriteValue write = item; // shallow, not owned
+        write.attributeId   = UA_ATTRIBUTEID_VALUE;
+        results[i] = UA_Server_write(m_pServer, &write);
+        if (results[i] != UA_STATUSCODE_GOOD)
+            failure = results[i];
+    }
+    _lastError = failure;
+    return failure == UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+size_t Server::applyUpdates()
+{
+  if (!_updateQueue || !m_pServer || _updateQueue->empty()) return 0; // no lock when idle
+
+  WriteLock l(m_mutex);
+  return _updateQueue->apply(m_pServer);
+}
+
+//*****************************************************************************
+
 bool Server::readBrowseName(const NodeId& nodeId, std::string& name, int& idxNameSpace) {
     if (!m_pServer) throw std::runtime_error("Null server"); // why not return false?
 
@@ -0,0 +1,183 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/samplingmanager.h>
+#include <open62541cpp/open62541server.h>
+
+namespace Open62541 {
+
+SamplingManager::~SamplingManager() {
+    std::lock_guard<std::mutex> l(m_mutex);
+    for (auto& g : m_groups) {
+        if (g.second.timerId) m_server.removeTimerEvent(g.second.timerId);
+    }
+    for (auto& n : m_nodes) {
+        UA_NodeId key = n.first;
+        UA_NodeId_clear(&key);
+    }
+}
+
+//*****************************************************************************
+
+bool SamplingManager::addGroup(
+    const std::string&  name,
+    PollFunc            poll,
+    UA_Double           defaultInterval /*= 1000*/,
+    GroupFunc           start /*= nullptr*/,
+    GroupFunc           stop /*= nullptr*/) {
+    std::lock_guard<std::mutex> l(m_mutex);
+    if (m_groups.find(name) != m_groups.end()) return false;
+    Group& g          = m_groups[name];
+    g.poll            = poll;
+    g.start           = start;
+    g.stop            = stop;
+    g.defaultInterval = (defaultInterval > 0) ? defaultInterval : 1000;
+    return true;
+}
+
+//*****************************************************************************
+
+bool SamplingManager::addNode(
+    const std::string&  group,
+    const NodeId&       node,
+    UA_Double           interval /*= 0*/) {
+    if (interval <= 0) {
+        UA_Double minimum = 0;
+        if (m_server.readMinimumSamplingInterval(node, minimum) && minimum > 0)
+            interval = minimum;
+    }
+
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto g = m_groups.find(group);
+    if (g == m_groups.end() || m_nodes.find(node) != m_nodes.end()) return false;
+
+    UA_NodeId key;
+    UA_NodeId_copy(node.constRef(), &key);
+    Node& n    = m_nodes[key];
+    n.group    = group;
+    n.interval = (interval > 0) ? interval : g->second.defaultInterval;
+    return true;
+}
+
+//*****************************************************************************
+
+void SamplingManager::monitoredItemRegister(const UA_NodeId& nodeId, uint32_t attributeId, bool removed) {
+    if (attributeId != UA_ATTRIBUTEID_VALUE) return;
+
+    std::vector<std::function<void()>> actions; // start and stop functions, called without lock
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        auto i = m_nodes.find(nodeId);
+        if (i == m_nodes.end()) return; // not polled
+        Node&  n = i->second;
+        Group& g = m_groups[n.group];
+
+        if (removed) {
+            if (n.refs == 0 || --n.refs > 0) return;
+            for (auto a = g.active.begin(); a != g.active.end(); ++a) {
+                if (UA_NodeId_equal(a->constRef(), &nodeId)) {
+                    g.active.erase(a);
+                    break;
+                }
+            }
+            g.intervals.erase(g.intervals.find(n.interval));
+        }
+        else {
+            if (n.refs++ > 0) return;
+            g.active.push_back(NodeId(nodeId));
+            g.intervals.insert(n.interval);
+        }
+        update(n.group, g, actions);
+    }
+    for (auto& a : actions) a();
+}
+
+//*****************************************************************************
+
+bool SamplingManager::update(
+    const std::string&                  name,
+    Group&                              g,
+    std::vector<std::function<void()>>& actions) {
+    const UA_Double wanted = g.intervals.empty() ? 0 : *g.intervals.begin();
+    if (wanted == g.interval) return true;
+
+    if (wanted == 0) { // last monitored item deleted
+        m_server.removeTimerEvent(g.timerId);
+        g.timerId  = 0;
+        g.interval = 0;
+        if (g.stop) actions.push_back(std::bind(g.stop, name));
+        return true;
+    }
+
+    if (g.interval == 0) { // first monitored item
+        if (!m_server.addRepeatedTimerEvent(wanted, g.timerId, [this, name](Timer&) { poll(name); }))
+            return false; // not started
+        if (g.start) actions.push_back(std::bind(g.start, name)); // runs before the first poll, one interval away
+    }
+    else if (!m_server.changeRepeatedTimerInterval(g.timerId, wanted)) {
+        return false; // keep polling at the previous interval
+    }
+    g.interval = wanted;
+    return true;
+}
+
+//*****************************************************************************
+
+void SamplingManager::poll(const std::string& name) {
+    PollFunc            f;
+    std::vector<NodeId> nodes;
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        auto g = m_groups.find(name);
+        if (g == m_groups.end() || !g->second.poll) return;
+        f     = g->second.poll;
+        nodes = g->second.active; // the poll may update the values, which may delete monitored items
+        g->second.polls++;
+    }
+    f(name, nodes);
+}
+
+//*****************************************************************************
+
+unsigned SamplingManager::references(const UA_NodeId& node) const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto i = m_nodes.find(node);
+    return (i == m_nodes.end()) ? 0 : i->second.refs;
+}
+
+//*****************************************************************************
+
+UA_Double SamplingManager::interval(const std::string& group) const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto g = m_groups.find(group);
+    return (g == m_groups.end()) ? 0 : g->second.interval;
+}
+
+//*****************************************************************************
+
+uint64_t SamplingManager::polls(const std::string& group) const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto g = m_groups.find(group);
+    return (g == m_groups.end()) ? 0 : g->second.polls;
+}
+
+//*****************************************************************************
+
+size_t SamplingManager::activeGroups() const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    size_t n = 0;
+    for (auto& g : m_groups) {
+        if (g.second.interval > 0) n++;
+    }
+    return n;
+}
+
+} // namespace Open62541
@@ -1,26 +1,55 @@
-/*
- * Copyright (C) 2017 -  B. J. Hill
- *
- * This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
- * redistribute it and/or modify it under the terms of the Mozilla Public
- * License v2.0 as stated in the LICENSE file provided with open62541.
- *
- * open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
- * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
- * A PARTICULAR PURPOSE.
- */
-#include "open62541cpp/serverbrowser.h"
-#include "open62541cpp/open62541server.h"
-
-namespace Open62541 {
-
-void ServerBrowser::browse(const UA_NodeId& start)
-{
-    list().clear();
-    UA_Server_forEachChildNodeCall(
-        obj().server(),  // UA_Server*
-        start,           // parent node id.
-        browseIter,      // callback used to iterate on the children nodes.
-        (void*)this);    // handle used as browseIter()'s third argument, storing the gathered info of each children.
-}
-} // namespace Open62541
+/*
+ * Copyright (C) 2017 -  B. J. Hill
+ *
+ * This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+ * redistribute it and/or modify it under the terms of the Mozilla Public
+ * License v2.0 as stated in the LICENSE file provided with open62541.
+ *
+ * open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.
+ */
+#include "open62541cpp/serverbrowser.h"
+#include "open62541cpp/open62541server.h"
+#include <open62541cpp/objects/UANodeIdList.h>
+
+namespace Open62541 {
+
+/**
+ * Children gathered while holding the server shared lock.
+ * They are named afterwards since browseName() takes the lock itself.
+ */
+struct ChildList {
+    UANodeIdList nodes; /**< child node ids */
+    UANodeIdList types; /**< matching reference type ids */
+};
+
+static UA_StatusCode collectChild(UA_NodeId childId, UA_Boolean isInverse, UA_NodeId referenceTypeId, void* handle)
+{
+    if (!isInverse) {  // same filter as browseIter()
+        auto p = (ChildList*)handle;
+        p->nodes.put(childId);
+        p->types.put(referenceTypeId);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+void ServerBrowser::browse(const UA_NodeId& start)
+{
+    list().clear();
+    ChildList children;
+    {
+        ServerReadLock l(obj().mutex());
+        UA_Server_forEachChildNodeCall(
+            obj().server(),  // UA_Server*
+            start,           // parent node id.
+            collectChild,    // callback used to iterate on the children nodes.
+            &children);      // handle used as collectChild()'s third argument.
+    }
+    for (size_t i = 0; i < children.nodes.size(); i++) {
+        process(children.nodes[i], children.types[i]);
+    }
+}
+} // namespace Open62541
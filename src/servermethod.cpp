@@ -32,14 +32,13 @@ UA_StatusCode ServerMethod::methodCallback(
 
     if (auto pServer = Server::findServer(pUAServer))
     {
-        VariantList inputs;
-        inputs.assign(input, input + inputSize);
-
-        return ((ServerMethod*)methodContext)->callback(
+        // the inputs are viewed in place, not copied
+        VariantSpan outputs(output, outputSize);
+        return ((ServerMethod*)methodContext)->callbackView(
             *pServer,
             objectId,
-            inputs,
-            VariantSpan(output, outputSize));
+            ConstVariantSpan(input, inputSize),
+            outputs);
     }
 
     return UA_STATUSCODE_GOOD;
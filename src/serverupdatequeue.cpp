@@ -0,0 +1,126 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/serverupdatequeue.h>
+#include <open62541/server.h>
+
+namespace Open62541 {
+
+ValueUpdateSlot::ValueUpdateSlot(ServerUpdateQueue& queue, const UA_NodeId& node)
+    : m_queue(queue) {
+    UA_NodeId_copy(&node, &m_node);
+}
+
+//*****************************************************************************
+
+ValueUpdateSlot::~ValueUpdateSlot() {
+    if (UA_DataValue* v = m_latest.exchange(nullptr))
+        UA_DataValue_delete(v);
+    UA_NodeId_clear(&m_node);
+}
+
+//*****************************************************************************
+
+void ValueUpdateSlot::push(UA_DataValue& value) {
+    UA_DataValue* v = UA_DataValue_new();
+    *v = value; // shallow move
+    UA_DataValue_init(&value);
+
+    m_queue.m_pushed++;
+    if (UA_DataValue* old = m_latest.exchange(v)) {
+        UA_DataValue_delete(old); // already queued, applied with the new value
+        m_queue.m_coalesced++;
+        return;
+    }
+    m_queue.queue(this);
+}
+
+//*****************************************************************************
+
+void ValueUpdateSlot::push(const Variant& value) {
+    UA_DataValue v;
+    UA_DataValue_init(&v);
+    if (value.ref() && UA_Variant_copy(value.ref(), &v.value) == UA_STATUSCODE_GOOD)
+        v.hasValue = true;
+    v.sourceTimestamp    = UA_DateTime_now();
+    v.hasSourceTimestamp = true;
+    push(v);
+}
+
+//*****************************************************************************
+
+ServerUpdateQueue::ServerUpdateQueue(size_t maxNodes, double budget)
+    : m_queue(maxNodes)
+    , m_maxNodes(maxNodes)
+    , m_budget(budget) {
+}
+
+//*****************************************************************************
+
+ValueUpdateSlot* ServerUpdateQueue::slot(const UA_NodeId& node) {
+    std::lock_guard<std::mutex> l(m_slotsMutex);
+    auto i = m_slots.find(node);
+    if (i != m_slots.end()) return i->second.get();
+    if (m_slots.size() >= m_maxNodes) return nullptr;
+
+    std::unique_ptr<ValueUpdateSlot> s(new ValueUpdateSlot(*this, node));
+    ValueUpdateSlot* p = s.get();
+    m_slots.emplace(p->node(), std::move(s)); // keyed by the slot copy of the node id
+    return p;
+}
+
+//*****************************************************************************
+
+bool ServerUpdateQueue::push(const UA_NodeId& node, UA_DataValue& value) {
+    ValueUpdateSlot* s = slot(node);
+    if (!s) return false;
+    s->push(value);
+    return true;
+}
+
+//*****************************************************************************
+
+size_t ServerUpdateQueue::apply(UA_Server* server, const AppliedFunc& done) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+
+    size_t n = 0;
+    ValueUpdateSlot* s = nullptr;
+    while (m_queue.tryPop(s)) {
+        UA_DataValue* v = s->m_latest.exchange(nullptr); // a later push queues the slot again
+        if (!v) continue;
+
+        const UA_StatusCode status = __UA_Server_write(
+            server, &s->m_node, UA_ATTRIBUTEID_VALUE, &UA_TYPES[UA_TYPES_DATAVALUE], v);
+        UA_DataValue_delete(v);
+        if (status == UA_STATUSCODE_GOOD) m_applied++;
+        else m_failed++;
+        if (done) done(s->m_node, status);
+
+        // check the clock every few writes only
+        if ((++n % 64) == 0 && Clock::now() - start >= m_budget) break;
+    }
+    return n;
+}
+
+//*****************************************************************************
+
+ServerUpdateQueue::Stats ServerUpdateQueue::stats() const {
+    Stats s;
+    s.pushed    = m_pushed;
+    s.coalesced = m_coalesced;
+    s.applied   = m_applied;
+    s.failed    = m_failed;
+    s.depth     = m_queue.size();
+    return s;
+}
+
+} // namespace Open62541
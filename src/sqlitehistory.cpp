@@ -0,0 +1,611 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/sqlitehistory.h>
+#include <open62541cpp/writebehindhistory.h>
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Open62541 {
+
+static const char* const schema =
+    "PRAGMA journal_mode=WAL;"
+    "PRAGMA synchronous=NORMAL;"
+    "CREATE TABLE IF NOT EXISTS history("
+    "node TEXT NOT NULL, time INTEGER NOT NULL, status INTEGER NOT NULL, type INTEGER, value);"
+    "CREATE INDEX IF NOT EXISTS history_node_time ON history(node, time);";
+
+/** The texts of the prepared statements, indexed by SQLiteHistoryBackend::Statement */
+static const char* const statementTexts[] = {
+    // Insert, Replace: ?1 node, ?2 time, ?3 status, ?4 type, ?5 value
+    "INSERT INTO history(node, time, status, type, value) VALUES(?1, ?2, ?3, ?4, ?5)",
+    "SELECT 1 FROM history WHERE node = ?1 AND time = ?2 LIMIT 1",
+    "UPDATE history SET status = ?3, type = ?4, value = ?5 WHERE node = ?1 AND time = ?2",
+    "DELETE FROM history WHERE node = ?1 AND time >= ?2 AND time <= ?3",
+    "SELECT time FROM history WHERE node = ?1 AND time <= ?2 ORDER BY time DESC LIMIT 1",
+    "SELECT time FROM history WHERE node = ?1 AND time >= ?2 ORDER BY time LIMIT 1",
+    // Forward, Backward: ?1 node, after ?2 time and ?4 row, up to ?3 time, at most ?5 rows
+    "SELECT rowid, time, status, type, value FROM history"
+    " WHERE node = ?1 AND time >= ?2 AND time <= ?3 AND (time > ?2 OR rowid > ?4)"
+    " ORDER BY time, rowid LIMIT ?5",
+    "SELECT rowid, time, status, type, value FROM history"
+    " WHERE node = ?1 AND time <= ?2 AND time >= ?3 AND (time < ?2 OR rowid < ?4)"
+    " ORDER BY time DESC, rowid DESC LIMIT ?5",
+    // PruneCount: keeps the ?2 + 1 newest samples, PruneAge: the samples from ?2
+    "DELETE FROM history WHERE node = ?1 AND time <"
+    " (SELECT time FROM history WHERE node = ?1 ORDER BY time DESC LIMIT 1 OFFSET ?2)",
+    "DELETE FROM history WHERE node = ?1 AND time < ?2",
+    "BEGIN",
+    "COMMIT"
+};
+
+namespace {
+
+/** A prepared statement in use, reset and unbound when released: no read stays open */
+class Reset {
+    sqlite3_stmt* m_s;
+
+public:
+    explicit Reset(sqlite3_stmt* s) : m_s(s) {}
+    ~Reset() {
+        if (!m_s) return;
+        sqlite3_reset(m_s);
+        sqlite3_clear_bindings(m_s);
+    }
+    operator sqlite3_stmt*() const { return m_s; }
+};
+
+} // namespace
+
+//*****************************************************************************
+
+/**
+ * @return the time stamp indexing a sample: source, else server, else now.
+ */
+static UA_DateTime sampleTime(const UA_DataValue& v) {
+    if (v.hasSourceTimestamp) return v.sourceTimestamp;
+    if (v.hasServerTimestamp) return v.serverTimestamp;
+    return UA_DateTime_now();
+}
+
+/** @return the key of a node in the node column */
+static std::string nodeKey(const UA_NodeId& node) {
+    UA_String s = UA_STRING_NULL;
+    UA_NodeId_print(&node, &s);
+    std::string r(reinterpret_cast<const char*>(s.data), s.length);
+    UA_String_clear(&s);
+    return r;
+}
+
+template <typename T>
+static int bindInteger(sqlite3_stmt* s, int i, const void* p) {
+    return sqlite3_bind_int64(s, i, sqlite3_int64(*static_cast<const T*>(p)));
+}
+
+template <typename T>
+static void setInteger(void* p, sqlite3_int64 i) {
+    *static_cast<T*>(p) = T(i);
+}
+
+//*****************************************************************************
+
+/**
+ * Bind ?1 node, ?2 time, ?3 status, ?4 type and ?5 value of a sample.
+ * Numbers are stored as SQLite integers or reals, strings as text, byte strings as blobs.
+ * @return UA_STATUSCODE_BADTYPEMISMATCH if the value cannot be stored.
+ */
+static UA_StatusCode bindSample(sqlite3_stmt* s, const std::string& node, const UA_DataValue& v) {
+    sqlite3_bind_text(s, 1, node.data(), int(node.size()), SQLITE_STATIC);
+    sqlite3_bind_int64(s, 2, sampleTime(v));
+    sqlite3_bind_int64(s, 3, v.hasStatus ? v.status : UA_STATUSCODE_GOOD);
+    if (!v.hasValue || !v.value.type) return UA_STATUSCODE_GOOD; // type and value stay null
+
+    const UA_DataType* type = v.value.type;
+    const void*        p    = v.value.data;
+    if (!UA_Variant_isScalar(&v.value) || type->typeId.namespaceIndex != 0)
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+
+    int rc = SQLITE_OK;
+    switch (type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN:    rc = bindInteger<UA_Boolean>(s, 5, p);     break;
+    case UA_DATATYPEKIND_SBYTE:      rc = bindInteger<UA_SByte>(s, 5, p);       break;
+    case UA_DATATYPEKIND_BYTE:       rc = bindInteger<UA_Byte>(s, 5, p);        break;
+    case UA_DATATYPEKIND_INT16:      rc = bindInteger<UA_Int16>(s, 5, p);       break;
+    case UA_DATATYPEKIND_UINT16:     rc = bindInteger<UA_UInt16>(s, 5, p);      break;
+    case UA_DATATYPEKIND_INT32:      rc = bindInteger<UA_Int32>(s, 5, p);       break;
+    case UA_DATATYPEKIND_UINT32:     rc = bindInteger<UA_UInt32>(s, 5, p);      break;
+    case UA_DATATYPEKIND_INT64:      rc = bindInteger<UA_Int64>(s, 5, p);       break;
+    case UA_DATATYPEKIND_UINT64:     rc = bindInteger<UA_UInt64>(s, 5, p);      break; // as its bits
+    case UA_DATATYPEKIND_DATETIME:   rc = bindInteger<UA_DateTime>(s, 5, p);    break;
+    case UA_DATATYPEKIND_STATUSCODE: rc = bindInteger<UA_StatusCode>(s, 5, p);  break;
+    case UA_DATATYPEKIND_FLOAT:      rc = sqlite3_bind_double(s, 5, *static_cast<const UA_Float*>(p));  break;
+    case UA_DATATYPEKIND_DOUBLE:     rc = sqlite3_bind_double(s, 5, *static_cast<const UA_Double*>(p)); break;
+    case UA_DATATYPEKIND_STRING: {
+        const UA_String& str = *static_cast<const UA_String*>(p);
+        rc = sqlite3_bind_text(s, 5, reinterpret_cast<const char*>(str.data), int(str.length), SQLITE_STATIC);
+        break;
+    }
+    case UA_DATATYPEKIND_BYTESTRING:
+    case UA_DATATYPEKIND_XMLELEMENT: {
+        const UA_ByteString& str = *static_cast<const UA_ByteString*>(p);
+        rc = sqlite3_bind_blob(s, 5, str.data, int(str.length), SQLITE_STATIC);
+        break;
+    }
+    case UA_DATATYPEKIND_GUID:
+        rc = sqlite3_bind_blob(s, 5, p, int(sizeof(UA_Guid)), SQLITE_STATIC);
+        break;
+    default:
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+    }
+    if (rc != SQLITE_OK) return UA_STATUSCODE_BADINTERNALERROR;
+    sqlite3_bind_int64(s, 4, type->typeId.identifier.numeric);
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+/**
+ * Read the value of a row of the Forward and Backward statements: columns 3 type and 4 value.
+ * @param[out] v receives the value, left empty if the sample has none.
+ */
+static UA_StatusCode columnValue(sqlite3_stmt* s, UA_Variant& v) {
+    if (sqlite3_column_type(s, 3) == SQLITE_NULL) return UA_STATUSCODE_GOOD;
+
+    const UA_NodeId     typeId  = UA_NODEID_NUMERIC(0, UA_UInt32(sqlite3_column_int64(s, 3)));
+    const UA_DataType*  type    = UA_findDataType(&typeId);
+    if (!type) return UA_STATUSCODE_BADDATAENCODINGINVALID;
+
+    void* p = UA_new(type);
+    if (!p) return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    const sqlite3_int64 i = sqlite3_column_int64(s, 4);
+    switch (type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN:    *static_cast<UA_Boolean*>(p) = i != 0;   break;
+    case UA_DATATYPEKIND_SBYTE:      setInteger<UA_SByte>(p, i);              break;
+    case UA_DATATYPEKIND_BYTE:       setInteger<UA_Byte>(p, i);               break;
+    case UA_DATATYPEKIND_INT16:      setInteger<UA_Int16>(p, i);              break;
+    case UA_DATATYPEKIND_UINT16:     setInteger<UA_UInt16>(p, i);             break;
+    case UA_DATATYPEKIND_INT32:      setInteger<UA_Int32>(p, i);              break;
+    case UA_DATATYPEKIND_UINT32:     setInteger<UA_UInt32>(p, i);             break;
+    case UA_DATATYPEKIND_INT64:      setInteger<UA_Int64>(p, i);              break;
+    case UA_DATATYPEKIND_UINT64:     setInteger<UA_UInt64>(p, i);             break;
+    case UA_DATATYPEKIND_DATETIME:   setInteger<UA_DateTime>(p, i);           break;
+    case UA_DATATYPEKIND_STATUSCODE: setInteger<UA_StatusCode>(p, i);         break;
+    case UA_DATATYPEKIND_FLOAT:      *static_cast<UA_Float*>(p)  = UA_Float(sqlite3_column_double(s, 4)); break;
+    case UA_DATATYPEKIND_DOUBLE:     *static_cast<UA_Double*>(p) = sqlite3_column_double(s, 4);           break;
+    case UA_DATATYPEKIND_STRING:
+    case UA_DATATYPEKIND_BYTESTRING:
+    case UA_DATATYPEKIND_XMLELEMENT: {
+        const void*     data    = sqlite3_column_blob(s, 4); // before the size
+        const size_t    size    = size_t(sqlite3_column_bytes(s, 4));
+        UA_String&      str     = *static_cast<UA_String*>(p);
+        if (size) {
+            str.data = static_cast<UA_Byte*>(UA_malloc(size));
+            if (!str.data) {
+                UA_delete(p, type);
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            }
+            memcpy(str.data, data, size);
+            str.length = size;
+        }
+        break;
+    }
+    case UA_DATATYPEKIND_GUID:
+        if (size_t(sqlite3_column_bytes(s, 4)) == sizeof(UA_Guid))
+            memcpy(p, sqlite3_column_blob(s, 4), sizeof(UA_Guid));
+        break;
+    default:
+        UA_delete(p, type);
+        return UA_STATUSCODE_BADDATAENCODINGINVALID;
+    }
+    UA_Variant_setScalar(&v, p, type);
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+SQLiteHistoryBackend::SQLiteHistoryBackend(
+    const std::string&  dbFileName,
+    size_t              maxValuesPerNode,
+    UA_DateTime         maxAge,
+    size_t              pruneInterval)
+    : m_maxValuesPerNode(maxValuesPerNode)
+    , m_maxAge(maxAge)
+    , m_pruneInterval(std::max<size_t>(pruneInterval, 1)) {
+    static_assert(sizeof(statementTexts) / sizeof(statementTexts[0]) == Statements, "one text per statement");
+    initialise();
+    // the high level API only: a read is one query, not a lookup per index
+    UA_HistoryDataBackend& d = database();
+    d.getDateTimeMatch  = nullptr;
+    d.getEnd            = nullptr;
+    d.lastIndex         = nullptr;
+    d.firstIndex        = nullptr;
+    d.resultSize        = nullptr;
+    d.copyDataValues    = nullptr;
+    d.getDataValue      = nullptr;
+
+    const int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX; // m_mutex
+    if (sqlite3_open_v2(dbFileName.c_str(), &m_db, flags, nullptr) != SQLITE_OK
+        || sqlite3_busy_timeout(m_db, 1000) != SQLITE_OK
+        || sqlite3_exec(m_db, schema, nullptr, nullptr, nullptr) != SQLITE_OK) {
+        deleteMembers();
+        return;
+    }
+    for (int i = 0; i < Statements; i++) {
+        if (sqlite3_prepare_v2(m_db, statementTexts[i], -1, &m_statements[i], nullptr) != SQLITE_OK) {
+            deleteMembers();
+            return;
+        }
+    }
+}
+
+//*****************************************************************************
+
+SQLiteHistoryBackend::~SQLiteHistoryBackend() {
+    deleteMembers();
+}
+
+//*****************************************************************************
+
+void SQLiteHistoryBackend::deleteMembers() {
+    std::lock_guard<std::mutex> l(m_mutex);
+    for (sqlite3_stmt*& s : m_statements) {
+        sqlite3_finalize(s);
+        s = nullptr;
+    }
+    sqlite3_close(m_db); // checkpoints the log
+    m_db = nullptr;
+}
+
+//*****************************************************************************
+
+bool SQLiteHistoryBackend::isOpen() const {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return m_db != nullptr;
+}
+
+//*****************************************************************************
+
+/** Run a statement without parameters. */
+UA_StatusCode SQLiteHistoryBackend::execute(Statement statement) {
+    Reset s(m_statements[statement]);
+    if (!s) return UA_STATUSCODE_BADINTERNALERROR;
+    return sqlite3_step(s) == SQLITE_DONE ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADINTERNALERROR;
+}
+
+//*****************************************************************************
+
+UA_StatusCode SQLiteHistoryBackend::begin() {
+    std::lock_guard<std::mutex> l(m_mutex);
+    return execute(Begin);
+}
+
+UA_StatusCode SQLiteHistoryBackend::commit() {
+    std::lock_guard<std::mutex> l(m_mutex);
+    UA_StatusCode ret = execute(Commit);
+    // a failed commit leaves the transaction open: drop it, the next batch starts afresh
+    if (m_db && !sqlite3_get_autocommit(m_db)) sqlite3_exec(m_db, "ROLLBACK", nullptr, nullptr, nullptr);
+    return ret;
+}
+
+//*****************************************************************************
+
+/** Insert a sample, then prune the history of its node. */
+UA_StatusCode SQLiteHistoryBackend::insert(const std::string& node, const UA_DataValue& value) {
+    {
+        Reset s(m_statements[Insert]);
+        if (!s) return UA_STATUSCODE_BADINTERNALERROR;
+        UA_StatusCode ret = bindSample(s, node, value);
+        if (ret != UA_STATUSCODE_GOOD) return ret;
+        if (sqlite3_step(s) != SQLITE_DONE) return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    prune(node);
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+void SQLiteHistoryBackend::prune(const std::string& node) {
+    if (!m_maxValuesPerNode && !m_maxAge) return;
+
+    size_t& n = m_inserted[node];
+    if (++n < m_pruneInterval) return;
+    n = 0;
+
+    if (m_maxValuesPerNode) {
+        Reset s(m_statements[PruneCount]);
+        sqlite3_bind_text(s, 1, node.data(), int(node.size()), SQLITE_STATIC);
+        sqlite3_bind_int64(s, 2, sqlite3_int64(m_maxValuesPerNode - 1));
+        sqlite3_step(s);
+    }
+    if (m_maxAge) {
+        Reset s(m_statements[PruneAge]);
+        sqlite3_bind_text(s, 1, node.data(), int(node.size()), SQLITE_STATIC);
+        sqlite3_bind_int64(s, 2, UA_DateTime_now() - m_maxAge * UA_DATETIME_SEC);
+        sqlite3_step(s);
+    }
+}
+
+//*****************************************************************************
+
+/**
+ * Find the time of a bound: the last sample at or before t with Before,
+ * the first one at or after t with After.
+ * @return false if there is no such sample, found being unchanged.
+ */
+bool SQLiteHistoryBackend::bound(const std::string& node, Statement statement, UA_DateTime t, UA_DateTime& found) {
+    Reset s(m_statements[statement]);
+    if (!s) return false;
+    sqlite3_bind_text(s, 1, node.data(), int(node.size()), SQLITE_STATIC);
+    sqlite3_bind_int64(s, 2, t);
+    if (sqlite3_step(s) != SQLITE_ROW) return false;
+    found = sqlite3_column_int64(s, 0);
+    return true;
+}
+
+//*****************************************************************************
+
+UA_StatusCode SQLiteHistoryBackend::serverSetHistoryData(
+    Context&            context,
+    bool              /*historizing*/,
+    const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    const std::string node = nodeKey(*context.nodeId.ref());
+    std::lock_guard<std::mutex> l(m_mutex);
+    return insert(node, *value);
+}
+
+//*****************************************************************************
+
+UA_StatusCode SQLiteHistoryBackend::getHistoryData(
+    Context&                context,
+    const UA_DateTime       start,
+    const UA_DateTime       end,
+    size_t                  maxSizePerResponse,
+    UA_UInt32               numValuesPerNode,
+    UA_Boolean              returnBounds,
+    UA_TimestampsToReturn   timestampsToReturn,
+    UA_NumericRange         range,
+    UA_Boolean              releaseContinuationPoints,
+    std::string&            continuationPoint,
+    std::string&            outContinuationPoint,
+    UA_HistoryData*         result) {
+    if (releaseContinuationPoints) return UA_STATUSCODE_GOOD;
+
+    // the continuation point is the time and row of the last value returned
+    struct Cursor {
+        sqlite3_int64 time;
+        sqlite3_int64 row;
+    } cursor;
+    const bool resumed = !continuationPoint.empty();
+    if (resumed) {
+        if (continuationPoint.size() != sizeof(cursor)) return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&cursor, continuationPoint.data(), sizeof(cursor));
+    }
+
+    const std::string node = nodeKey(*context.nodeId.ref());
+    std::lock_guard<std::mutex> l(m_mutex);
+    if (!m_db) return UA_STATUSCODE_BADINTERNALERROR;
+
+    // the times of the values, from included to included, widened to the bounds
+    const bool  reverse = start > end;
+    UA_DateTime from    = start;
+    UA_DateTime to      = reverse ? end + 1 : (end > INT64_MIN ? end - 1 : end);
+    bool addFirst = false, addLast = false;
+    if (returnBounds) {
+        addFirst = !bound(node, reverse ? After : Before, start, from);
+        addLast  = !bound(node, reverse ? Before : After, end, to);
+    }
+    if (!resumed) {
+        cursor.time = from;
+        cursor.row  = reverse ? INT64_MAX : -1;
+    }
+
+    size_t limit = SIZE_MAX;
+    if (numValuesPerNode) limit = numValuesPerNode;
+    if (maxSizePerResponse && maxSizePerResponse < limit) limit = maxSizePerResponse;
+
+    const bool source = timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE
+                     || timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH;
+    const bool server = timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER
+                     || timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH;
+
+    std::vector<UA_DataValue> values;
+    auto placeholder = [&values](UA_DateTime t) {
+        UA_DataValue v;
+        UA_DataValue_init(&v);
+        v.status             = UA_STATUSCODE_BADBOUNDNOTFOUND;
+        v.hasStatus          = true;
+        v.sourceTimestamp    = t;
+        v.hasSourceTimestamp = true;
+        values.push_back(v);
+    };
+    if (addFirst && !resumed) placeholder(start);
+
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    bool more = false;
+    {
+        Reset s(m_statements[reverse ? Backward : Forward]);
+        sqlite3_bind_text(s, 1, node.data(), int(node.size()), SQLITE_STATIC);
+        sqlite3_bind_int64(s, 2, cursor.time);
+        sqlite3_bind_int64(s, 3, to);
+        sqlite3_bind_int64(s, 4, cursor.row);
+        sqlite3_bind_int64(s, 5, limit == SIZE_MAX ? -1 : sqlite3_int64(limit - values.size() + 1));
+        int rc;
+        while ((rc = sqlite3_step(s)) == SQLITE_ROW) {
+            if (values.size() == limit) {
+                more = true; // one row past the page
+                break;
+            }
+            UA_DataValue v;
+            UA_DataValue_init(&v);
+            ret = columnValue(s, v.value);
+            if (ret == UA_STATUSCODE_GOOD && v.value.type && range.dimensionsSize > 0) {
+                UA_Variant part;
+                UA_Variant_init(&part);
+                ret = UA_Variant_copyRange(&v.value, &part, range);
+                UA_Variant_clear(&v.value);
+                v.value = part;
+            }
+            if (ret != UA_STATUSCODE_GOOD) {
+                UA_DataValue_clear(&v);
+                break;
+            }
+            cursor.row  = sqlite3_column_int64(s, 0);
+            cursor.time = sqlite3_column_int64(s, 1);
+            v.hasValue              = v.value.type != nullptr;
+            v.status                = UA_StatusCode(sqlite3_column_int64(s, 2));
+            v.hasStatus             = v.status != UA_STATUSCODE_GOOD;
+            v.sourceTimestamp       = cursor.time;
+            v.hasSourceTimestamp    = source;
+            v.serverTimestamp       = cursor.time;
+            v.hasServerTimestamp    = server;
+            values.push_back(v);
+        }
+        if (ret == UA_STATUSCODE_GOOD && rc != SQLITE_ROW && rc != SQLITE_DONE)
+            ret = UA_STATUSCODE_BADINTERNALERROR;
+    }
+    if (ret == UA_STATUSCODE_GOOD && addLast && !more) {
+        if (values.size() < limit) placeholder(end);
+        else more = true;
+    }
+
+    UA_DataValue* dv = nullptr;
+    if (ret == UA_STATUSCODE_GOOD && !values.empty()) {
+        dv = static_cast<UA_DataValue*>(UA_Array_new(values.size(), &UA_TYPES[UA_TYPES_DATAVALUE]));
+        if (!dv) ret = UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    if (ret != UA_STATUSCODE_GOOD) {
+        for (UA_DataValue& v : values) UA_DataValue_clear(&v);
+        return ret;
+    }
+    if (dv) {
+        memcpy(dv, values.data(), values.size() * sizeof(UA_DataValue)); // moved, not copied
+        result->dataValues      = dv;
+        result->dataValuesSize  = values.size();
+    }
+    if (more) outContinuationPoint.assign(reinterpret_cast<const char*>(&cursor), sizeof(cursor));
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+UA_Boolean SQLiteHistoryBackend::boundSupported(Context& /*context*/) {
+    return UA_TRUE;
+}
+
+UA_Boolean SQLiteHistoryBackend::timestampsToReturnSupported(
+    Context&              /*context*/,
+    UA_TimestampsToReturn   timestampsToReturn) {
+    return timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE
+        || timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER
+        || timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH;
+}
+
+//*****************************************************************************
+
+UA_StatusCode SQLiteHistoryBackend::insertDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    const std::string node = nodeKey(*context.nodeId.ref());
+    std::lock_guard<std::mutex> l(m_mutex);
+    {
+        Reset s(m_statements[Exists]);
+        if (!s) return UA_STATUSCODE_BADINTERNALERROR;
+        sqlite3_bind_text(s, 1, node.data(), int(node.size()), SQLITE_STATIC);
+        sqlite3_bind_int64(s, 2, sampleTime(*value));
+        if (sqlite3_step(s) == SQLITE_ROW) return UA_STATUSCODE_BADENTRYEXISTS;
+    }
+    return insert(node, *value);
+}
+
+//*****************************************************************************
+
+UA_StatusCode SQLiteHistoryBackend::replaceDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    const std::string node = nodeKey(*context.nodeId.ref());
+    std::lock_guard<std::mutex> l(m_mutex);
+    Reset s(m_statements[Replace]);
+    if (!s) return UA_STATUSCODE_BADINTERNALERROR;
+    UA_StatusCode ret = bindSample(s, node, *value);
+    if (ret != UA_STATUSCODE_GOOD) return ret;
+    if (sqlite3_step(s) != SQLITE_DONE) return UA_STATUSCODE_BADINTERNALERROR;
+    return sqlite3_changes(m_db) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADNOENTRYEXISTS;
+}
+
+//*****************************************************************************
+
+UA_StatusCode SQLiteHistoryBackend::updateDataValue(Context& context, const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    const std::string node = nodeKey(*context.nodeId.ref());
+    std::lock_guard<std::mutex> l(m_mutex);
+    {
+        Reset s(m_statements[Replace]);
+        if (!s) return UA_STATUSCODE_BADINTERNALERROR;
+        UA_StatusCode ret = bindSample(s, node, *value);
+        if (ret != UA_STATUSCODE_GOOD) return ret;
+        if (sqlite3_step(s) != SQLITE_DONE) return UA_STATUSCODE_BADINTERNALERROR;
+        if (sqlite3_changes(m_db)) return UA_STATUSCODE_GOOD;
+    }
+    return insert(node, *value);
+}
+
+//*****************************************************************************
+
+UA_StatusCode SQLiteHistoryBackend::removeDataValue(
+    Context&    context,
+    UA_DateTime startTimestamp,
+    UA_DateTime endTimestamp) {
+    const std::string node = nodeKey(*context.nodeId.ref());
+    std::lock_guard<std::mutex> l(m_mutex);
+    Reset s(m_statements[Remove]);
+    if (!s) return UA_STATUSCODE_BADINTERNALERROR;
+    sqlite3_bind_text(s, 1, node.data(), int(node.size()), SQLITE_STATIC);
+    sqlite3_bind_int64(s, 2, startTimestamp);
+    sqlite3_bind_int64(s, 3, endTimestamp);
+    if (sqlite3_step(s) != SQLITE_DONE) return UA_STATUSCODE_BADINTERNALERROR;
+    return sqlite3_changes(m_db) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADNODATA;
+}
+
+//*****************************************************************************
+
+SQLiteHistorian::SQLiteHistorian(const char* dbFileName,
+                                 size_t numberNodes,
+                                 size_t maxValuesPerNode,
+                                 UA_DateTime maxBufferedTimeSec,
+                                 size_t pruneInterval,
+                                 unsigned flushInterval,
+                                 size_t maxQueued)
+    : m_store(dbFileName, maxValuesPerNode, maxBufferedTimeSec, pruneInterval) {
+    gathering() = UA_HistoryDataGathering_Default(numberNodes);
+    database()  = UA_HistoryDatabase_default(gathering());
+    backend()   = m_store.database();
+    if (flushInterval) {
+        enableWriteBehind(flushInterval, maxQueued);
+        writeBehind()->setBatch([this]() { return m_store.begin(); },
+                                [this]() { return m_store.commit(); });
+    }
+    enableReadProcessed();
+}
+
+//*****************************************************************************
+
+SQLiteHistorian::~SQLiteHistorian() {
+    releaseStore(); // m_store is destroyed before ~Historian() releases the backend
+}
+
+} // namespace Open62541
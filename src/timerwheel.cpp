@@ -0,0 +1,210 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/timerwheel.h>
+
+namespace Open62541 {
+
+const unsigned TimerWheel::Levels;
+const unsigned TimerWheel::SlotBits;
+const unsigned TimerWheel::Slots;
+const uint32_t TimerWheel::None;
+const uint32_t TimerWheel::Firing;
+
+//*****************************************************************************
+
+TimerWheel::TimerWheel(unsigned tickMs /*= 10*/, uint64_t nowMs /*= 0*/)
+    : m_heads(Levels * Slots + 1, None)
+    , m_tickMs(tickMs ? tickMs : 1)
+    , m_origin(nowMs) {
+}
+
+//*****************************************************************************
+
+uint32_t TimerWheel::allocate() {
+    if (m_free != None) {
+        const uint32_t i = m_free;
+        m_free = m_nodes[i].next;
+        return i;
+    }
+    m_nodes.emplace_back();
+    return uint32_t(m_nodes.size() - 1);
+}
+
+//*****************************************************************************
+
+void TimerWheel::release(uint32_t i) {
+    Node& n     = m_nodes[i];
+    n.func      = nullptr;
+    n.list      = None;
+    n.prev      = None;
+    n.cancelled = false;
+    n.generation++;
+    n.next      = m_free;
+    m_free      = i;
+    m_active--;
+}
+
+//*****************************************************************************
+
+void TimerWheel::link(uint32_t i, uint32_t list) {
+    Node& n = m_nodes[i];
+    n.list  = list;
+    n.prev  = None;
+    n.next  = m_heads[list];
+    if (n.next != None) m_nodes[n.next].prev = i;
+    m_heads[list] = i;
+}
+
+//*****************************************************************************
+
+void TimerWheel::unlink(uint32_t i) {
+    Node& n = m_nodes[i];
+    if (n.prev != None) m_nodes[n.prev].next = n.next;
+    else m_heads[n.list] = n.next;
+    if (n.next != None) m_nodes[n.next].prev = n.prev;
+    n.prev = n.next = None;
+    n.list = None;
+}
+
+//*****************************************************************************
+
+void TimerWheel::schedule(uint32_t i) {
+    Node& n = m_nodes[i];
+    if (n.expires < m_tick) n.expires = m_tick; // due now when cascaded: the current slot is processed next
+
+    // the level is given by the highest slot bits differing from the current tick
+    const uint64_t delta = n.expires - m_tick;
+    unsigned level = 0;
+    while (level < Levels - 1 && delta >= (uint64_t(1) << (SlotBits * (level + 1))))
+        level++;
+
+    // beyond the wheel: parked in the top level slot of the current tick, the last one to come up.
+    // It is cascaded before its expiry and scheduled again from there
+    const uint64_t at = delta >> (SlotBits * Levels) ? m_tick : n.expires;
+    const unsigned slot = unsigned(at >> (SlotBits * level)) & (Slots - 1);
+    link(i, level * Slots + slot);
+}
+
+//*****************************************************************************
+
+void TimerWheel::cascade(unsigned level) {
+    const unsigned slot = unsigned(m_tick >> (SlotBits * level)) & (Slots - 1);
+    uint32_t i = m_heads[level * Slots + slot];
+    m_heads[level * Slots + slot] = None;
+    while (i != None) {
+        const uint32_t next = m_nodes[i].next;
+        m_nodes[i].prev = m_nodes[i].next = None;
+        schedule(i); // to a lower level
+        i = next;
+    }
+}
+
+//*****************************************************************************
+
+TimerWheel::Id TimerWheel::add(uint64_t delay, uint64_t interval, Func&& func) {
+    const uint32_t i = allocate();
+    Node& n    = m_nodes[i];
+    n.func     = std::move(func);
+    n.expires  = due(ticks(delay));
+    n.interval = interval ? ticks(interval) : 0;
+    schedule(i);
+    m_active++;
+    return (uint64_t(n.generation) << 32) | (i + 1);
+}
+
+//*****************************************************************************
+
+uint32_t TimerWheel::find(Id id) const {
+    const uint64_t index = (id & 0xFFFFFFFFu);
+    if (index == 0 || index > m_nodes.size()) return None;
+    const uint32_t i = uint32_t(index - 1);
+    const Node& n = m_nodes[i];
+    if (n.generation != uint32_t(id >> 32) || n.cancelled) return None;
+    if (n.list == None && i != m_firing) return None; // free
+    return i;
+}
+
+//*****************************************************************************
+
+bool TimerWheel::cancel(Id id) {
+    const uint32_t i = find(id);
+    if (i == None) return false;
+    if (m_nodes[i].list != None) unlink(i);
+    if (i == m_firing) {
+        m_nodes[i].cancelled = true; // released when its function returns
+        return true;
+    }
+    release(i);
+    return true;
+}
+
+//*****************************************************************************
+
+bool TimerWheel::reschedule(Id id, uint64_t delay) {
+    const uint32_t i = find(id);
+    if (i == None) return false;
+    if (m_nodes[i].list != None) unlink(i);
+    m_nodes[i].expires = due(ticks(delay));
+    schedule(i);
+    return true;
+}
+
+//*****************************************************************************
+
+size_t TimerWheel::advance(uint64_t now) {
+    if (now < m_origin) return 0;
+    const uint64_t target = (now - m_origin) / m_tickMs;
+
+    size_t fired = 0;
+    while (m_tick < target) {
+        m_tick++;
+        // bring down the timers of the upper levels whose slot comes up
+        for (unsigned level = 1; level < Levels; level++) {
+            if ((m_tick & ((uint64_t(1) << (SlotBits * level)) - 1)) != 0) break;
+            cascade(level);
+        }
+
+        // move the due slot aside: the functions may add timers to it
+        const unsigned slot = unsigned(m_tick) & (Slots - 1);
+        uint32_t i = m_heads[slot];
+        m_heads[slot] = None;
+        while (i != None) {
+            const uint32_t next = m_nodes[i].next;
+            link(i, Firing);
+            i = next;
+        }
+
+        while ((i = m_heads[Firing]) != None) {
+            unlink(i);
+            const Id id = (uint64_t(m_nodes[i].generation) << 32) | (i + 1);
+            fired++;
+            if (m_nodes[i].interval == 0) {
+                Func f = std::move(m_nodes[i].func);
+                release(i); // before the call: the function may add timers
+                if (f) f(id);
+                continue;
+            }
+            m_nodes[i].expires = due(m_nodes[i].interval);
+            schedule(i);
+            // called from a local: the function may add timers, moving the pool
+            Func f = std::move(m_nodes[i].func);
+            m_firing = i;
+            if (f) f(id); // may cancel itself
+            m_firing = None;
+            if (m_nodes[i].cancelled) release(i);
+            else m_nodes[i].func = std::move(f);
+        }
+    }
+    return fired;
+}
+
+} // namespace Open62541
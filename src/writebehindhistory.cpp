@@ -0,0 +1,422 @@
+/*
+    Copyright (C) 2017 -  B. J. Hill
+
+    This file is part of open62541 C++ classes. open62541 C++ classes are free software: you can
+    redistribute it and/or modify it under the terms of the Mozilla Public
+    License v2.0 as stated in the LICENSE file provided with open62541.
+
+    open62541 C++ classes are distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+    A PARTICULAR PURPOSE.
+*/
+#include <open62541cpp/writebehindhistory.h>
+#include <open62541cpp/objects/StringUtils.h>
+#include <algorithm>
+#include <cstring>
+
+namespace Open62541 {
+
+/** A queued sample, owning its copies */
+struct WriteBehindHistoryBackend::Sample {
+    UA_Server*      server;
+    UA_NodeId       node;
+    UA_DataValue    value;
+    bool            historizing;
+
+    Sample(UA_Server* s, const UA_NodeId& n, const UA_DataValue& v, bool h)
+        : server(s), historizing(h) {
+        UA_NodeId_copy(&n, &node);
+        UA_DataValue_copy(&v, &value);
+    }
+    ~Sample() {
+        UA_NodeId_clear(&node);
+        UA_DataValue_clear(&value);
+    }
+};
+
+//*****************************************************************************
+
+WriteBehindHistoryBackend::WriteBehindHistoryBackend(
+    const UA_HistoryDataBackend&    backend,
+    unsigned                        flushInterval,
+    size_t                          maxQueued)
+    : m_backend(backend)
+    , m_queue(maxQueued)
+    , m_flushInterval(std::max(flushInterval, 1u)) { // wait_for(0) would spin the worker
+    initialise();
+
+    // only offer what the wrapped backend does: the database checks the optional hooks
+    UA_HistoryDataBackend& d = database();
+    const bool indexed = m_backend.getDateTimeMatch && m_backend.getEnd && m_backend.lastIndex
+                      && m_backend.resultSize && m_backend.copyDataValues;
+    if (!m_backend.getHistoryData && !indexed)  d.getHistoryData              = nullptr;
+    // the raw reads go through getHistoryData() only: the lookups and the copy of a read
+    // would otherwise be separate calls, with drains in between
+    d.getDateTimeMatch  = nullptr;
+    d.getEnd            = nullptr;
+    d.lastIndex         = nullptr;
+    d.firstIndex        = nullptr;
+    d.resultSize        = nullptr;
+    d.copyDataValues    = nullptr;
+    d.getDataValue      = nullptr; // would point into the backend after the lock is released
+    if (!m_backend.boundSupported)              d.boundSupported              = nullptr;
+    if (!m_backend.timestampsToReturnSupported) d.timestampsToReturnSupported = nullptr;
+    if (!m_backend.insertDataValue)             d.insertDataValue             = nullptr;
+    if (!m_backend.replaceDataValue)            d.replaceDataValue            = nullptr;
+    if (!m_backend.updateDataValue)             d.updateDataValue             = nullptr;
+    if (!m_backend.removeDataValue)             d.removeDataValue             = nullptr;
+
+    m_thread = std::thread([this]() { run(); });
+}
+
+//*****************************************************************************
+
+WriteBehindHistoryBackend::~WriteBehindHistoryBackend() {
+    deleteMembers(); // the base destructor does not reach this override
+}
+
+//*****************************************************************************
+
+void WriteBehindHistoryBackend::deleteMembers() {
+    {
+        std::lock_guard<std::mutex> l(m_wakeMutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+
+    std::lock_guard<std::mutex> l(m_backendMutex);
+    drain();
+    if (m_backend.deleteMembers) m_backend.deleteMembers(&m_backend);
+    memset(&m_backend, 0, sizeof(m_backend));
+}
+
+//*****************************************************************************
+
+void WriteBehindHistoryBackend::run() {
+    std::unique_lock<std::mutex> l(m_wakeMutex);
+    while (!m_stop) {
+        m_wake.wait_for(l, m_flushInterval);
+        l.unlock();
+        {
+            std::lock_guard<std::mutex> b(m_backendMutex);
+            drain();
+        }
+        l.lock();
+    }
+}
+
+//*****************************************************************************
+
+/**
+ * Store the queued samples, in order.
+ * @return the number of samples stored.
+ */
+size_t WriteBehindHistoryBackend::drain() {
+    Sample* s = nullptr;
+    if (!m_queue.tryPop(s)) return 0;
+
+    if (m_beginBatch) m_beginBatch(); // else each sample is stored on its own
+    size_t n = 0;
+    do {
+        store(s->server, &s->node, s->historizing, &s->value);
+        delete s;
+        n++;
+    } while (m_queue.tryPop(s));
+    if (m_endBatch && m_endBatch() != UA_STATUSCODE_GOOD) m_failed += n;
+
+    m_queued += n;
+    m_batches++;
+    return n;
+}
+
+//*****************************************************************************
+
+void WriteBehindHistoryBackend::setBatch(BatchHook begin, BatchHook end) {
+    std::lock_guard<std::mutex> l(m_backendMutex);
+    m_beginBatch = std::move(begin);
+    m_endBatch   = std::move(end);
+}
+
+//*****************************************************************************
+
+UA_StatusCode WriteBehindHistoryBackend::store(
+    UA_Server*          server,
+    const UA_NodeId*    node,
+    bool                historizing,
+    const UA_DataValue* value) {
+    if (!m_backend.serverSetHistoryData) return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_StatusCode ret = m_backend.serverSetHistoryData(
+        server, m_backend.context, nullptr, nullptr, node, historizing, value);
+    if (ret != UA_STATUSCODE_GOOD) m_failed++;
+    return ret;
+}
+
+//*****************************************************************************
+
+void WriteBehindHistoryBackend::flush() {
+    std::lock_guard<std::mutex> l(m_backendMutex);
+    drain();
+}
+
+//*****************************************************************************
+
+WriteBehindHistoryBackend::Stats WriteBehindHistoryBackend::stats() const {
+    Stats s;
+    s.queued      = m_queued;
+    s.synchronous = m_synchronous;
+    s.batches     = m_batches;
+    s.failed      = m_failed;
+    s.depth       = m_queue.size();
+    return s;
+}
+
+//*****************************************************************************
+
+UA_StatusCode WriteBehindHistoryBackend::serverSetHistoryData(
+    Context&            context,
+    bool                historizing,
+    const UA_DataValue* value) {
+    if (!value) return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    UA_Server* server = context.server.server();
+    Sample* s = new Sample(server, context.nodeId, *value, historizing);
+    if (m_queue.tryPush(s)) {
+        if (m_queue.size() > m_queue.capacity() / 2) m_wake.notify_one();
+        return UA_STATUSCODE_GOOD;
+    }
+    delete s;
+
+    // the background thread fell behind: store in place, after the pending samples
+    std::lock_guard<std::mutex> l(m_backendMutex);
+    drain();
+    m_synchronous++;
+    return store(server, context.nodeId.ref(), historizing, value);
+}
+
+//*****************************************************************************
+
+UA_StatusCode WriteBehindHistoryBackend::getHistoryData(
+    Context&            context,
+    const UA_DateTime   start,
+    const UA_DateTime   end,
+    size_t              maxSizePerResponse,
+    UA_UInt32           numValuesPerNode,
+    UA_Boolean          returnBounds,
+    UA_TimestampsToReturn timestampsToReturn,
+    UA_NumericRange     range,
+    UA_Boolean          releaseContinuationPoints,
+    std::string&        continuationPoint,
+    std::string&        outContinuationPoint,
+    UA_HistoryData*     result) {
+    std::lock_guard<std::mutex> l(m_backendMutex);
+    drain();
+    if (!m_backend.getHistoryData) {
+        if (releaseContinuationPoints) return UA_STATUSCODE_GOOD; // nothing held between the calls
+        return readIndexed(context, start, end, maxSizePerResponse, numValuesPerNode, returnBounds,
+                           range, continuationPoint, outContinuationPoint, result);
+    }
+
+    UA_ByteString in;
+    in.length = continuationPoint.size();
+    in.data   = reinterpret_cast<UA_Byte*>(const_cast<char*>(continuationPoint.data()));
+    UA_ByteString out;
+    UA_ByteString_init(&out);
+    UA_StatusCode ret = m_backend.getHistoryData(
+        context.server.server(),
+        context.sessionId.ref(),
+        context.sessionContext,
+        &m_backend,
+        start,
+        end,
+        context.nodeId.ref(),
+        maxSizePerResponse,
+        numValuesPerNode,
+        returnBounds,
+        timestampsToReturn,
+        range,
+        releaseContinuationPoints,
+        continuationPoint.empty() ? nullptr : &in,
+        &out,
+        result);
+    outContinuationPoint = fromByteString(out);
+    UA_ByteString_clear(&out);
+    return ret;
+}
+
+//*****************************************************************************
+
+/**
+ * Call a hook of the wrapped backend. The caller holds m_backendMutex.
+ * @param hook the hook, a member of UA_HistoryDataBackend.
+ * @param fallback the result if the wrapped backend does not have the hook.
+ */
+template <typename R, typename Hook, typename... Args>
+R WriteBehindHistoryBackend::call(Context& context, Hook UA_HistoryDataBackend::*hook, R fallback, Args... args) {
+    if (!(m_backend.*hook)) return fallback;
+    return (m_backend.*hook)(context.server.server(), m_backend.context,
+                             context.sessionId.ref(), context.sessionContext,
+                             context.nodeId.ref(), args...);
+}
+
+/** Store the pending samples, then call a hook of the wrapped backend. */
+template <typename R, typename Hook, typename... Args>
+R WriteBehindHistoryBackend::forward(Context& context, Hook UA_HistoryDataBackend::*hook, R fallback, Args... args) {
+    std::lock_guard<std::mutex> l(m_backendMutex);
+    drain();
+    return call<R>(context, hook, fallback, args...);
+}
+
+//*****************************************************************************
+
+/**
+ * Raw read through the low level hooks of the wrapped backend, like the default database does:
+ * the values from start to end, the end excluded, with the bounds if asked for,
+ * BadBoundNotFound values standing for the missing ones.
+ * The continuation point holds the number of values already returned.
+ */
+UA_StatusCode WriteBehindHistoryBackend::readIndexed(
+    Context&            context,
+    UA_DateTime         start,
+    UA_DateTime         end,
+    size_t              maxSizePerResponse,
+    UA_UInt32           numValuesPerNode,
+    UA_Boolean          returnBounds,
+    UA_NumericRange     range,
+    const std::string&  continuationPoint,
+    std::string&        outContinuationPoint,
+    UA_HistoryData*     result) {
+    uint64_t skip = 0;
+    if (!continuationPoint.empty()) {
+        if (continuationPoint.size() != sizeof(skip)) return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&skip, continuationPoint.data(), sizeof(skip));
+    }
+
+    const size_t storeEnd   = call<size_t>(context, &UA_HistoryDataBackend::getEnd, 0);
+    const bool   empty      = call<size_t>(context, &UA_HistoryDataBackend::lastIndex, storeEnd) == storeEnd;
+    auto match = [&](UA_DateTime t, MatchStrategy strategy) {
+        return call<size_t>(context, &UA_HistoryDataBackend::getDateTimeMatch, storeEnd, t, strategy);
+    };
+
+    // the stored values from first to last, in the order of the read
+    const bool reverse = start > end;
+    size_t first = storeEnd, last = storeEnd;
+    bool addFirst = false, addLast = false;
+    if (empty) {
+        addFirst = addLast = returnBounds;
+    }
+    else if (returnBounds) {
+        first = match(start, reverse ? MATCH_EQUAL_OR_AFTER : MATCH_EQUAL_OR_BEFORE);
+        if (first == storeEnd) {
+            addFirst = true;
+            first    = match(start, reverse ? MATCH_BEFORE : MATCH_AFTER);
+        }
+        last = match(end, reverse ? MATCH_EQUAL_OR_BEFORE : MATCH_EQUAL_OR_AFTER);
+        if (last == storeEnd) {
+            addLast = true;
+            last    = match(end, reverse ? MATCH_AFTER : MATCH_BEFORE);
+        }
+    }
+    else {
+        first = match(start, reverse ? MATCH_EQUAL_OR_BEFORE : MATCH_EQUAL_OR_AFTER);
+        last  = match(end,   reverse ? MATCH_AFTER : MATCH_BEFORE);
+    }
+    const bool   found  = first != storeEnd && last != storeEnd && (reverse ? first >= last : first <= last);
+    const size_t count  = found ? (reverse
+        ? call<size_t>(context, &UA_HistoryDataBackend::resultSize, 0, last, first)
+        : call<size_t>(context, &UA_HistoryDataBackend::resultSize, 0, first, last)) : 0;
+    const size_t total  = count + addFirst + addLast;
+    if (skip >= total) return UA_STATUSCODE_GOOD;
+
+    size_t n = total - size_t(skip);
+    if (numValuesPerNode && n > numValuesPerNode)   n = numValuesPerNode;
+    if (maxSizePerResponse && n > maxSizePerResponse) n = maxSizePerResponse;
+    auto dv = static_cast<UA_DataValue*>(UA_Array_new(n, &UA_TYPES[UA_TYPES_DATAVALUE]));
+    if (!dv) return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    auto bound = [](UA_DataValue& v, UA_DateTime t) {
+        v.status             = UA_STATUSCODE_BADBOUNDNOTFOUND;
+        v.hasStatus          = true;
+        v.sourceTimestamp    = t;
+        v.hasSourceTimestamp = true;
+    };
+
+    // positions skip .. skip + n - 1 of [first bound] values [last bound]
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    size_t p = size_t(skip), k = 0;
+    if (addFirst && p == 0) {
+        bound(dv[k++], start);
+        p++;
+    }
+    const size_t from = p - addFirst;                       // first value to copy
+    const size_t want = std::min(count - std::min(from, count), n - k);
+    if (want) {
+        const UA_ByteString in = UA_BYTESTRING_NULL;
+        UA_ByteString out = UA_BYTESTRING_NULL;
+        size_t provided = 0;
+        ret = m_backend.copyDataValues(
+            context.server.server(), m_backend.context, context.sessionId.ref(), context.sessionContext,
+            context.nodeId.ref(), reverse ? first - from : first + from, last, reverse, want, range,
+            false, &in, &out, &provided, dv + k);
+        UA_ByteString_clear(&out);
+        k += std::min(provided, want);
+        p += std::min(provided, want);
+    }
+    if (ret == UA_STATUSCODE_GOOD && addLast && k < n && p == total - 1) {
+        bound(dv[k++], end);
+        p++;
+    }
+    if (ret != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(dv, n, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        return ret;
+    }
+
+    result->dataValues      = dv;
+    result->dataValuesSize  = k; // the values not provided are left initialised
+    if (p < total && k) {
+        const uint64_t next = p;
+        outContinuationPoint.assign(reinterpret_cast<const char*>(&next), sizeof(next));
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+//*****************************************************************************
+
+UA_Boolean WriteBehindHistoryBackend::boundSupported(Context& context) {
+    return forward<UA_Boolean>(context, &UA_HistoryDataBackend::boundSupported, UA_FALSE);
+}
+
+UA_Boolean WriteBehindHistoryBackend::timestampsToReturnSupported(
+    Context&                context,
+    UA_TimestampsToReturn   timestampsToReturn) {
+    return forward<UA_Boolean>(context, &UA_HistoryDataBackend::timestampsToReturnSupported, UA_FALSE,
+                               timestampsToReturn);
+}
+
+//*****************************************************************************
+
+UA_StatusCode WriteBehindHistoryBackend::insertDataValue(Context& context, const UA_DataValue* value) {
+    return forward<UA_StatusCode>(context, &UA_HistoryDataBackend::insertDataValue,
+                                  UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED, value);
+}
+
+UA_StatusCode WriteBehindHistoryBackend::replaceDataValue(Context& context, const UA_DataValue* value) {
+    return forward<UA_StatusCode>(context, &UA_HistoryDataBackend::replaceDataValue,
+                                  UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED, value);
+}
+
+UA_StatusCode WriteBehindHistoryBackend::updateDataValue(Context& context, const UA_DataValue* value) {
+    return forward<UA_StatusCode>(context, &UA_HistoryDataBackend::updateDataValue,
+                                  UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED, value);
+}
+
+UA_StatusCode WriteBehindHistoryBackend::removeDataValue(
+    Context&    context,
+    UA_DateTime startTimestamp,
+    UA_DateTime endTimestamp) {
+    return forward<UA_StatusCode>(context, &UA_HistoryDataBackend::removeDataValue,
+                                  UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED, startTimestamp, endTimestamp);
+}
+
+} // namespace Open62541